@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "arena.h"
+
+/**
+ * New empty arena, no chunk is allocated until the first `arena_alloc`.
+ */
+arena_t *
+arena_new()
+{
+    arena_t *arena = malloc(sizeof(arena_t));
+
+    if (arena != NULL) {
+        arena->chunks = NULL;
+        arena->cursor = NULL;
+        arena->end = NULL;
+        arena->chunk_size = ARENA_CHUNK_MIN;
+        arena->size = 0;
+        arena->cap = 0;
+    }
+    return arena;
+}
+
+/**
+ * Free arena and all its memory.
+ */
+void
+arena_free(arena_t *arena)
+{
+    if (arena != NULL) {
+        arena_clear(arena);
+        free(arena);
+    }
+}
+
+/**
+ * Release all memory at once, O(chunks).
+ */
+void
+arena_clear(arena_t *arena)
+{
+    assert(arena != NULL);
+
+    arena_chunk_t *chunk = arena->chunks;
+
+    while (chunk != NULL) {
+        arena_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    arena->chunks = NULL;
+    arena->cursor = NULL;
+    arena->end = NULL;
+    arena->chunk_size = ARENA_CHUNK_MIN;
+    arena->size = 0;
+    arena->cap = 0;
+}
+
+/**
+ * Alloc `size` bytes (8 bytes aligned), O(1). Returns NULL on no memory.
+ * Sizes larger than a chunk get a chunk of their own, size 0 gets 8 bytes
+ * (a distinct non-NULL pointer).
+ */
+void *
+arena_alloc(arena_t *arena, size_t size)
+{
+    assert(arena != NULL);
+
+    size = size == 0 ? 8 : (size + 7) & ~(size_t)7;
+
+    if ((size_t)(arena->end - arena->cursor) < size) {
+        size_t data_size = arena->chunk_size;
+
+        if (data_size < size)
+            data_size = size;
+
+        arena_chunk_t *chunk = malloc(sizeof(arena_chunk_t) + data_size);
+
+        if (chunk == NULL)
+            return NULL;
+
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->cursor = (uint8_t *)(chunk + 1);
+        arena->end = arena->cursor + data_size;
+        arena->cap += sizeof(arena_chunk_t) + data_size;
+
+        if (arena->chunk_size < ARENA_CHUNK_MAX)
+            arena->chunk_size *= 2;
+    }
+
+    void *data = arena->cursor;
+    arena->cursor += size;
+    arena->size += size;
+    return data;
+}
@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Bump allocator (chunk based), not thread safe.
+ *
+ * Allocations are carved from the current chunk by moving a cursor, each
+ * new chunk doubles the previous one's size (up to ARENA_CHUNK_MAX).
+ * Memory is never released one by one, only on `arena_clear`/`arena_free`,
+ * in O(chunks).
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARENA_CHUNK_MIN 1024          // bytes of the first chunk
+#define ARENA_CHUNK_MAX 1048576       // max bytes of a chunk
+
+typedef struct arena_chunk_st {
+    struct arena_chunk_st *next;
+    uint64_t align;                  /* keeps data 8 bytes aligned */
+} arena_chunk_t;
+
+typedef struct arena_st {
+    arena_chunk_t *chunks;           /* allocated chunks */
+    uint8_t *cursor;                 /* next free byte in current chunk */
+    uint8_t *end;                    /* end of current chunk */
+    size_t chunk_size;               /* bytes of the next chunk */
+    size_t size;                     /* bytes allocated to callers */
+    size_t cap;                      /* bytes allocated by chunks */
+} arena_t;
+
+arena_t *arena_new();
+void arena_free(arena_t *);
+void arena_clear(arena_t *);
+void *arena_alloc(arena_t *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
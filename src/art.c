@@ -0,0 +1,961 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "art.h"
+
+#define ART_IS_LEAF(p) (((uintptr_t)(p) & 1) == 1)
+#define ART_LEAF(p) ((art_leaf_t *)((uintptr_t)(p) & ~(uintptr_t)1))
+#define ART_TAG(leaf) ((void *)((uintptr_t)(leaf) | 1))
+
+/**
+ * New leaf.
+ */
+static art_leaf_t *
+art_leaf_new(uint8_t *key, size_t key_len, void *val)
+{
+    art_leaf_t *leaf = malloc(sizeof(art_leaf_t));
+
+    if (leaf != NULL) {
+        leaf->key = key;
+        leaf->key_len = key_len;
+        leaf->val = val;
+    }
+    return leaf;
+}
+
+/**
+ * Test if a leaf's key is `key`.
+ */
+static bool
+art_leaf_is(art_leaf_t *leaf, uint8_t *key, size_t key_len)
+{
+    return leaf->key_len == key_len &&
+        memcmp(leaf->key, key, key_len) == 0;
+}
+
+/**
+ * Test if a leaf's key is a prefix of `key`.
+ */
+static bool
+art_leaf_prefixes(art_leaf_t *leaf, uint8_t *key, size_t key_len)
+{
+    return leaf->key_len <= key_len &&
+        memcmp(leaf->key, key, leaf->key_len) == 0;
+}
+
+/**
+ * New inner node of a type.
+ */
+static art_node_t *
+art_node_new(uint8_t type)
+{
+    size_t sizes[] = {sizeof(art_node4_t), sizeof(art_node16_t),
+        sizeof(art_node48_t), sizeof(art_node256_t)};
+    art_node_t *node = calloc(1, sizes[type]);
+
+    if (node != NULL)
+        node->type = type;
+    return node;
+}
+
+/**
+ * Copy the header of a node to a node of another type.
+ */
+static void
+art_node_copy_header(art_node_t *dst, art_node_t *src)
+{
+    dst->num = src->num;
+    dst->prefix_len = src->prefix_len;
+    memcpy(dst->prefix, src->prefix, ART_PREFIX_MAX);
+    dst->leaf = src->leaf;
+}
+
+/**
+ * Get the child slot of a byte, NULL if none.
+ */
+static void **
+art_node_find(art_node_t *node, uint8_t c)
+{
+    size_t i;
+
+    switch (node->type) {
+    case ART_NODE4: {
+        art_node4_t *n = (art_node4_t *)node;
+
+        for (i = 0; i < node->num; i++)
+            if ((n->keys)[i] == c)
+                return &(n->children)[i];
+        return NULL;
+    }
+    case ART_NODE16: {
+        art_node16_t *n = (art_node16_t *)node;
+#ifdef __SSE2__
+        // compare the 16 keys at once
+        __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+                _mm_loadu_si128((__m128i *)n->keys));
+        int mask = _mm_movemask_epi8(cmp) & ((1 << node->num) - 1);
+
+        if (mask != 0)
+            return &(n->children)[__builtin_ctz(mask)];
+#else
+        for (i = 0; i < node->num; i++)
+            if ((n->keys)[i] == c)
+                return &(n->children)[i];
+#endif
+        return NULL;
+    }
+    case ART_NODE48: {
+        art_node48_t *n = (art_node48_t *)node;
+
+        if ((n->index)[c] != 0)
+            return &(n->children)[(n->index)[c] - 1];
+        return NULL;
+    }
+    default: {
+        art_node256_t *n = (art_node256_t *)node;
+
+        if ((n->children)[c] != NULL)
+            return &(n->children)[c];
+        return NULL;
+    }
+    }
+}
+
+/**
+ * Add a child to a node with sorted keys (node4 or node16) with room.
+ */
+static void
+art_node_add_sorted(uint8_t *keys, void **children, uint16_t num,
+        uint8_t c, void *child)
+{
+    size_t i = 0;
+
+    while (i < num && keys[i] < c)
+        i++;
+
+    memmove(keys + i + 1, keys + i, num - i);
+    memmove(children + i + 1, children + i, (num - i) * sizeof(void *));
+    keys[i] = c;
+    children[i] = child;
+}
+
+/**
+ * Grow a full node to the next layout, returns the new node (the old one
+ * is freed) or NULL if no memory.
+ */
+static art_node_t *
+art_node_grow(art_node_t *node)
+{
+    art_node_t *new_node = art_node_new(node->type + 1);
+    size_t i;
+
+    if (new_node == NULL)
+        return NULL;
+
+    art_node_copy_header(new_node, node);
+
+    switch (node->type) {
+    case ART_NODE4: {
+        art_node4_t *n = (art_node4_t *)node;
+        art_node16_t *m = (art_node16_t *)new_node;
+        memcpy(m->keys, n->keys, 4);
+        memcpy(m->children, n->children, 4 * sizeof(void *));
+        break;
+    }
+    case ART_NODE16: {
+        art_node16_t *n = (art_node16_t *)node;
+        art_node48_t *m = (art_node48_t *)new_node;
+        for (i = 0; i < 16; i++) {
+            (m->index)[(n->keys)[i]] = i + 1;
+            (m->children)[i] = (n->children)[i];
+        }
+        break;
+    }
+    default: {
+        art_node48_t *n = (art_node48_t *)node;
+        art_node256_t *m = (art_node256_t *)new_node;
+        for (i = 0; i < 256; i++)
+            if ((n->index)[i] != 0)
+                (m->children)[i] = (n->children)[(n->index)[i] - 1];
+        break;
+    }
+    }
+
+    free(node);
+    return new_node;
+}
+
+/**
+ * Add a child to the node at `ref`, growing it if full.
+ */
+static int
+art_node_add(void **ref, uint8_t c, void *child)
+{
+    art_node_t *node = *ref;
+    uint16_t caps[] = {4, 16, 48, 256};
+
+    if (node->num == caps[node->type]) {
+        if ((node = art_node_grow(node)) == NULL)
+            return ART_ENOMEM;
+        *ref = node;
+    }
+
+    switch (node->type) {
+    case ART_NODE4: {
+        art_node4_t *n = (art_node4_t *)node;
+        art_node_add_sorted(n->keys, n->children, node->num, c, child);
+        break;
+    }
+    case ART_NODE16: {
+        art_node16_t *n = (art_node16_t *)node;
+        art_node_add_sorted(n->keys, n->children, node->num, c, child);
+        break;
+    }
+    case ART_NODE48: {
+        art_node48_t *n = (art_node48_t *)node;
+        size_t slot = 0;
+
+        // slots are reused after removes, find a free one
+        while ((n->children)[slot] != NULL)
+            slot++;
+        (n->children)[slot] = child;
+        (n->index)[c] = slot + 1;
+        break;
+    }
+    default:
+        ((art_node256_t *)node)->children[c] = child;
+        break;
+    }
+
+    node->num += 1;
+    return ART_OK;
+}
+
+/**
+ * Get the smallest leaf under a tagged pointer.
+ */
+static art_leaf_t *
+art_min_leaf(void *p)
+{
+    size_t i;
+
+    while (!ART_IS_LEAF(p)) {
+        art_node_t *node = p;
+
+        if (node->leaf != NULL)
+            return node->leaf;
+
+        switch (node->type) {
+        case ART_NODE4:
+            p = ((art_node4_t *)node)->children[0];
+            break;
+        case ART_NODE16:
+            p = ((art_node16_t *)node)->children[0];
+            break;
+        case ART_NODE48: {
+            art_node48_t *n = (art_node48_t *)node;
+            for (i = 0; (n->index)[i] == 0; i++);
+            p = (n->children)[(n->index)[i] - 1];
+            break;
+        }
+        default: {
+            art_node256_t *n = (art_node256_t *)node;
+            for (i = 0; (n->children)[i] == NULL; i++);
+            p = (n->children)[i];
+            break;
+        }
+        }
+    }
+    return ART_LEAF(p);
+}
+
+/**
+ * Get the length of the common part of a node's prefix and key (from
+ * depth), bytes beyond the kept prefix are checked on the min leaf.
+ */
+static size_t
+art_prefix_mismatch(art_node_t *node, uint8_t *key, size_t key_len,
+        size_t depth)
+{
+    size_t max = node->prefix_len < key_len - depth ?
+        node->prefix_len : key_len - depth;
+    size_t i;
+
+    for (i = 0; i < max && i < ART_PREFIX_MAX; i++)
+        if ((node->prefix)[i] != key[depth + i])
+            return i;
+
+    if (i < max) {
+        art_leaf_t *leaf = art_min_leaf(node);
+
+        for (; i < max; i++)
+            if (leaf->key[depth + i] != key[depth + i])
+                return i;
+    }
+    return i;
+}
+
+/**
+ * Set a key under the tagged pointer at `ref`, `depth` bytes of key are
+ * matched already.
+ */
+static int
+art_insert(art_t *art, void **ref, uint8_t *key, size_t key_len,
+        size_t depth, void *val)
+{
+    void *p = *ref;
+    art_leaf_t *new_leaf;
+
+    if (p == NULL) {
+        if ((new_leaf = art_leaf_new(key, key_len, val)) == NULL)
+            return ART_ENOMEM;
+        *ref = ART_TAG(new_leaf);
+        art->size += 1;
+        return ART_OK;
+    }
+
+    if (ART_IS_LEAF(p)) {
+        art_leaf_t *leaf = ART_LEAF(p);
+
+        if (art_leaf_is(leaf, key, key_len)) {
+            leaf->key = key;
+            leaf->val = val;
+            return ART_OK;
+        }
+
+        // split the leaf into a node4 on the common part
+        art_node_t *node = art_node_new(ART_NODE4);
+        new_leaf = art_leaf_new(key, key_len, val);
+
+        if (node == NULL || new_leaf == NULL) {
+            free(node);
+            free(new_leaf);
+            return ART_ENOMEM;
+        }
+
+        size_t max = leaf->key_len < key_len ? leaf->key_len : key_len;
+        size_t common = 0;
+
+        while (depth + common < max &&
+                leaf->key[depth + common] == key[depth + common])
+            common++;
+
+        node->prefix_len = common;
+        memcpy(node->prefix, key + depth,
+                common < ART_PREFIX_MAX ? common : ART_PREFIX_MAX);
+        depth += common;
+        *ref = node;
+
+        if (leaf->key_len == depth)
+            node->leaf = leaf;
+        else
+            art_node_add(ref, leaf->key[depth], ART_TAG(leaf));
+
+        if (key_len == depth)
+            node->leaf = new_leaf;
+        else
+            art_node_add(ref, key[depth], ART_TAG(new_leaf));
+
+        art->size += 1;
+        return ART_OK;
+    }
+
+    art_node_t *node = p;
+
+    if (node->prefix_len > 0) {
+        size_t mismatch = art_prefix_mismatch(node, key, key_len, depth);
+
+        if (mismatch < node->prefix_len) {
+            // split the prefix, a new node4 takes the common part
+            art_node_t *parent = art_node_new(ART_NODE4);
+            new_leaf = art_leaf_new(key, key_len, val);
+
+            if (parent == NULL || new_leaf == NULL) {
+                free(parent);
+                free(new_leaf);
+                return ART_ENOMEM;
+            }
+
+            parent->prefix_len = mismatch;
+            memcpy(parent->prefix, node->prefix,
+                    mismatch < ART_PREFIX_MAX ? mismatch : ART_PREFIX_MAX);
+
+            uint8_t c;
+
+            if (node->prefix_len <= ART_PREFIX_MAX) {
+                c = (node->prefix)[mismatch];
+                node->prefix_len -= mismatch + 1;
+                memmove(node->prefix, node->prefix + mismatch + 1,
+                        node->prefix_len);
+            } else {
+                art_leaf_t *leaf = art_min_leaf(node);
+                c = leaf->key[depth + mismatch];
+                node->prefix_len -= mismatch + 1;
+                memcpy(node->prefix, leaf->key + depth + mismatch + 1,
+                        node->prefix_len < ART_PREFIX_MAX ?
+                        node->prefix_len : ART_PREFIX_MAX);
+            }
+
+            *ref = parent;
+            art_node_add(ref, c, node);
+
+            if (key_len == depth + mismatch)
+                parent->leaf = new_leaf;
+            else
+                art_node_add(ref, key[depth + mismatch], ART_TAG(new_leaf));
+
+            art->size += 1;
+            return ART_OK;
+        }
+        depth += node->prefix_len;
+    }
+
+    // the key ends at this node
+    if (depth == key_len) {
+        if (node->leaf != NULL) {
+            node->leaf->key = key;
+            node->leaf->val = val;
+            return ART_OK;
+        }
+        if ((node->leaf = art_leaf_new(key, key_len, val)) == NULL)
+            return ART_ENOMEM;
+        art->size += 1;
+        return ART_OK;
+    }
+
+    void **child = art_node_find(node, key[depth]);
+
+    if (child != NULL)
+        return art_insert(art, child, key, key_len, depth + 1, val);
+
+    if ((new_leaf = art_leaf_new(key, key_len, val)) == NULL)
+        return ART_ENOMEM;
+
+    if (art_node_add(ref, key[depth], ART_TAG(new_leaf)) != ART_OK) {
+        free(new_leaf);
+        return ART_ENOMEM;
+    }
+    art->size += 1;
+    return ART_OK;
+}
+
+/**
+ * Remove the child of a byte from a node.
+ */
+static void
+art_node_remove(art_node_t *node, uint8_t c)
+{
+    size_t i;
+
+    switch (node->type) {
+    case ART_NODE4:
+    case ART_NODE16: {
+        uint8_t *keys = node->type == ART_NODE4 ?
+            ((art_node4_t *)node)->keys : ((art_node16_t *)node)->keys;
+        void **children = node->type == ART_NODE4 ?
+            ((art_node4_t *)node)->children :
+            ((art_node16_t *)node)->children;
+
+        for (i = 0; keys[i] != c; i++);
+        memmove(keys + i, keys + i + 1, node->num - i - 1);
+        memmove(children + i, children + i + 1,
+                (node->num - i - 1) * sizeof(void *));
+        break;
+    }
+    case ART_NODE48: {
+        art_node48_t *n = (art_node48_t *)node;
+        (n->children)[(n->index)[c] - 1] = NULL;
+        (n->index)[c] = 0;
+        break;
+    }
+    default:
+        ((art_node256_t *)node)->children[c] = NULL;
+        break;
+    }
+
+    node->num -= 1;
+}
+
+/**
+ * Shrink the node at `ref` after a remove: a node with no children is
+ * replaced by its leaf, a node with one child and no leaf is merged into
+ * the child, sparse nodes move to a smaller layout.
+ */
+static void
+art_node_shrink(void **ref)
+{
+    art_node_t *node = *ref;
+    size_t i, j;
+
+    if (node->num == 0) {
+        *ref = node->leaf != NULL ? ART_TAG(node->leaf) : NULL;
+        free(node);
+        return;
+    }
+
+    if (node->num == 1 && node->leaf == NULL && node->type == ART_NODE4) {
+        art_node4_t *n = (art_node4_t *)node;
+        void *child = (n->children)[0];
+
+        if (!ART_IS_LEAF(child)) {
+            // child prefix = node prefix + byte + child prefix
+            art_node_t *c = child;
+            uint8_t prefix[ART_PREFIX_MAX];
+            size_t len = node->prefix_len < ART_PREFIX_MAX ?
+                node->prefix_len : ART_PREFIX_MAX;
+
+            memcpy(prefix, node->prefix, len);
+            if (len < ART_PREFIX_MAX)
+                prefix[len++] = (n->keys)[0];
+            for (i = 0; len < ART_PREFIX_MAX && i < c->prefix_len; i++)
+                prefix[len++] = (c->prefix)[i];
+
+            memcpy(c->prefix, prefix, len);
+            c->prefix_len += node->prefix_len + 1;
+        }
+
+        *ref = child;
+        free(node);
+        return;
+    }
+
+    // shrink with some room left, so add/remove don't flip layouts
+    art_node_t *new_node = NULL;
+
+    if (node->type == ART_NODE16 && node->num <= 3) {
+        art_node16_t *n = (art_node16_t *)node;
+        art_node4_t *m = (art_node4_t *)(new_node =
+                art_node_new(ART_NODE4));
+        if (m != NULL) {
+            memcpy(m->keys, n->keys, node->num);
+            memcpy(m->children, n->children, node->num * sizeof(void *));
+        }
+    } else if (node->type == ART_NODE48 && node->num <= 12) {
+        art_node48_t *n = (art_node48_t *)node;
+        art_node16_t *m = (art_node16_t *)(new_node =
+                art_node_new(ART_NODE16));
+        if (m != NULL) {
+            for (i = 0, j = 0; i < 256; i++) {
+                if ((n->index)[i] != 0) {
+                    (m->keys)[j] = i;
+                    (m->children)[j++] = (n->children)[(n->index)[i] - 1];
+                }
+            }
+        }
+    } else if (node->type == ART_NODE256 && node->num <= 37) {
+        art_node256_t *n = (art_node256_t *)node;
+        art_node48_t *m = (art_node48_t *)(new_node =
+                art_node_new(ART_NODE48));
+        if (m != NULL) {
+            for (i = 0, j = 0; i < 256; i++) {
+                if ((n->children)[i] != NULL) {
+                    (m->index)[i] = j + 1;
+                    (m->children)[j++] = (n->children)[i];
+                }
+            }
+        }
+    }
+
+    // no memory to shrink is fine, the node stays as is
+    if (new_node != NULL) {
+        art_node_copy_header(new_node, node);
+        *ref = new_node;
+        free(node);
+    }
+}
+
+/**
+ * Del a key under the tagged pointer at `ref`.
+ */
+static int
+art_delete(art_t *art, void **ref, uint8_t *key, size_t key_len,
+        size_t depth)
+{
+    void *p = *ref;
+
+    if (p == NULL)
+        return ART_ENOTFOUND;
+
+    if (ART_IS_LEAF(p)) {
+        if (!art_leaf_is(ART_LEAF(p), key, key_len))
+            return ART_ENOTFOUND;
+        free(ART_LEAF(p));
+        *ref = NULL;
+        art->size -= 1;
+        return ART_OK;
+    }
+
+    art_node_t *node = p;
+    size_t i;
+
+    for (i = 0; i < node->prefix_len && i < ART_PREFIX_MAX; i++)
+        if (depth + i >= key_len || (node->prefix)[i] != key[depth + i])
+            return ART_ENOTFOUND;
+    depth += node->prefix_len;
+
+    if (depth > key_len)
+        return ART_ENOTFOUND;
+
+    if (depth == key_len) {
+        if (node->leaf == NULL || !art_leaf_is(node->leaf, key, key_len))
+            return ART_ENOTFOUND;
+        free(node->leaf);
+        node->leaf = NULL;
+        art->size -= 1;
+        art_node_shrink(ref);
+        return ART_OK;
+    }
+
+    void **child = art_node_find(node, key[depth]);
+
+    if (child == NULL)
+        return ART_ENOTFOUND;
+
+    if (!ART_IS_LEAF(*child))
+        return art_delete(art, child, key, key_len, depth + 1);
+
+    if (!art_leaf_is(ART_LEAF(*child), key, key_len))
+        return ART_ENOTFOUND;
+
+    free(ART_LEAF(*child));
+    art_node_remove(node, key[depth]);
+    art->size -= 1;
+    art_node_shrink(ref);
+    return ART_OK;
+}
+
+/**
+ * Free the nodes and leaves under a tagged pointer.
+ */
+static void
+art_destroy(void *p)
+{
+    size_t i;
+
+    if (p == NULL)
+        return;
+
+    if (ART_IS_LEAF(p)) {
+        free(ART_LEAF(p));
+        return;
+    }
+
+    art_node_t *node = p;
+
+    free(node->leaf);
+
+    switch (node->type) {
+    case ART_NODE4:
+        for (i = 0; i < node->num; i++)
+            art_destroy(((art_node4_t *)node)->children[i]);
+        break;
+    case ART_NODE16:
+        for (i = 0; i < node->num; i++)
+            art_destroy(((art_node16_t *)node)->children[i]);
+        break;
+    case ART_NODE48:
+        for (i = 0; i < 48; i++)
+            art_destroy(((art_node48_t *)node)->children[i]);
+        break;
+    default:
+        for (i = 0; i < 256; i++)
+            art_destroy(((art_node256_t *)node)->children[i]);
+        break;
+    }
+
+    free(node);
+}
+
+/**
+ * Call `func` on the keys under a tagged pointer in order, returns the
+ * number of keys visited.
+ */
+static size_t
+art_walk(void *p, art_scan_func_t func, void *data)
+{
+    size_t count = 0, i;
+
+    if (ART_IS_LEAF(p)) {
+        art_leaf_t *leaf = ART_LEAF(p);
+        (func)(leaf->key, leaf->key_len, leaf->val, data);
+        return 1;
+    }
+
+    art_node_t *node = p;
+
+    if (node->leaf != NULL) {
+        (func)(node->leaf->key, node->leaf->key_len, node->leaf->val, data);
+        count++;
+    }
+
+    switch (node->type) {
+    case ART_NODE4:
+        for (i = 0; i < node->num; i++)
+            count += art_walk(((art_node4_t *)node)->children[i], func,
+                    data);
+        break;
+    case ART_NODE16:
+        for (i = 0; i < node->num; i++)
+            count += art_walk(((art_node16_t *)node)->children[i], func,
+                    data);
+        break;
+    case ART_NODE48: {
+        art_node48_t *n = (art_node48_t *)node;
+        for (i = 0; i < 256; i++)
+            if ((n->index)[i] != 0)
+                count += art_walk((n->children)[(n->index)[i] - 1], func,
+                        data);
+        break;
+    }
+    default: {
+        art_node256_t *n = (art_node256_t *)node;
+        for (i = 0; i < 256; i++)
+            if ((n->children)[i] != NULL)
+                count += art_walk((n->children)[i], func, data);
+        break;
+    }
+    }
+    return count;
+}
+
+/**
+ * New art.
+ */
+art_t *
+art_new(void)
+{
+    art_t *art = malloc(sizeof(art_t));
+
+    if (art != NULL) {
+        art->root = NULL;
+        art->size = 0;
+    }
+    return art;
+}
+
+/**
+ * Free art.
+ */
+void
+art_free(art_t *art)
+{
+    if (art != NULL) {
+        art_clear(art);
+        free(art);
+    }
+}
+
+/**
+ * Clear art.
+ */
+void
+art_clear(art_t *art)
+{
+    assert(art != NULL);
+    art_destroy(art->root);
+    art->root = NULL;
+    art->size = 0;
+}
+
+/**
+ * Set a key to art, O(key length).
+ */
+int
+art_set(art_t *art, uint8_t *key, size_t key_len, void *val)
+{
+    assert(art != NULL);
+    return art_insert(art, &art->root, key, key_len, 0, val);
+}
+
+/**
+ * Get the leaf of a key, NULL if not found.
+ */
+static art_leaf_t *
+art_lookup(art_t *art, uint8_t *key, size_t key_len)
+{
+    void *p = art->root;
+    size_t depth = 0, i;
+
+    while (p != NULL) {
+        if (ART_IS_LEAF(p)) {
+            if (art_leaf_is(ART_LEAF(p), key, key_len))
+                return ART_LEAF(p);
+            return NULL;
+        }
+
+        art_node_t *node = p;
+
+        // bytes beyond the kept prefix are checked on the leaf
+        for (i = 0; i < node->prefix_len && i < ART_PREFIX_MAX; i++)
+            if (depth + i >= key_len || (node->prefix)[i] != key[depth + i])
+                return NULL;
+        depth += node->prefix_len;
+
+        if (depth >= key_len) {
+            if (depth == key_len && node->leaf != NULL &&
+                    art_leaf_is(node->leaf, key, key_len))
+                return node->leaf;
+            return NULL;
+        }
+
+        void **child = art_node_find(node, key[depth++]);
+        p = child != NULL ? *child : NULL;
+    }
+    return NULL;
+}
+
+/**
+ * Get val by key, NULL if not found, O(key length).
+ */
+void *
+art_get(art_t *art, uint8_t *key, size_t key_len)
+{
+    assert(art != NULL);
+
+    art_leaf_t *leaf = art_lookup(art, key, key_len);
+
+    if (leaf != NULL)
+        return leaf->val;
+    return NULL;
+}
+
+/**
+ * Test if a key is in art.
+ */
+bool
+art_has(art_t *art, uint8_t *key, size_t key_len)
+{
+    assert(art != NULL);
+    return art_lookup(art, key, key_len) != NULL;
+}
+
+/**
+ * Del a key from art, O(key length).
+ */
+int
+art_del(art_t *art, uint8_t *key, size_t key_len)
+{
+    assert(art != NULL);
+    return art_delete(art, &art->root, key, key_len, 0);
+}
+
+/**
+ * Get art size (keys number).
+ */
+size_t
+art_size(art_t *art)
+{
+    assert(art != NULL);
+    return art->size;
+}
+
+/**
+ * Get the leaf of the longest key that is a prefix of `key` (`key`
+ * itself included), NULL if none, O(key length).
+ */
+art_leaf_t *
+art_longest_prefix(art_t *art, uint8_t *key, size_t key_len)
+{
+    assert(art != NULL);
+
+    void *p = art->root;
+    art_leaf_t *best = NULL;
+    size_t depth = 0, i;
+
+    while (p != NULL) {
+        if (ART_IS_LEAF(p)) {
+            if (art_leaf_prefixes(ART_LEAF(p), key, key_len))
+                best = ART_LEAF(p);
+            break;
+        }
+
+        art_node_t *node = p;
+
+        // longer keys under this node can't be prefixes of key
+        if (node->prefix_len > key_len - depth)
+            break;
+
+        for (i = 0; i < node->prefix_len && i < ART_PREFIX_MAX; i++)
+            if ((node->prefix)[i] != key[depth + i])
+                return best;
+        depth += node->prefix_len;
+
+        // candidates are checked on their full keys
+        if (node->leaf != NULL && art_leaf_prefixes(node->leaf, key,
+                    key_len))
+            best = node->leaf;
+
+        if (depth == key_len)
+            break;
+
+        void **child = art_node_find(node, key[depth++]);
+        p = child != NULL ? *child : NULL;
+    }
+    return best;
+}
+
+/**
+ * Call `func` on the keys starting with `prefix` in order (all keys for an
+ * empty prefix), returns the number of keys visited. The art must not be
+ * changed by `func`.
+ */
+size_t
+art_scan_prefix(art_t *art, uint8_t *prefix, size_t prefix_len,
+        art_scan_func_t func, void *data)
+{
+    assert(art != NULL && func != NULL);
+
+    void *p = art->root;
+    size_t depth = 0, i;
+
+    while (p != NULL) {
+        if (ART_IS_LEAF(p)) {
+            art_leaf_t *leaf = ART_LEAF(p);
+
+            if (leaf->key_len >= prefix_len &&
+                    memcmp(leaf->key, prefix, prefix_len) == 0)
+                return art_walk(p, func, data);
+            return 0;
+        }
+
+        art_node_t *node = p;
+
+        for (i = 0; i < node->prefix_len && i < ART_PREFIX_MAX &&
+                depth + i < prefix_len; i++)
+            if ((node->prefix)[i] != prefix[depth + i])
+                return 0;
+
+        // prefix ends in this node, keys under it share their first
+        // prefix_len bytes, check them on one leaf
+        if (depth + node->prefix_len >= prefix_len) {
+            art_leaf_t *leaf = art_min_leaf(p);
+
+            if (memcmp(leaf->key, prefix, prefix_len) == 0)
+                return art_walk(p, func, data);
+            return 0;
+        }
+
+        depth += node->prefix_len;
+
+        void **child = art_node_find(node, prefix[depth++]);
+        p = child != NULL ? *child : NULL;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Adaptive radix tree (byte string keys).
+ *
+ * Inner nodes grow and shrink between 4, 16, 48 and 256 children layouts
+ * as keys come and go, chains of single child nodes are compressed into
+ * node prefixes (the first `ART_PREFIX_MAX` bytes are kept in the node,
+ * longer prefixes are checked against a leaf). A key that is a prefix of
+ * other keys is kept in the node where it ends.
+ *
+ * Lookups cost O(key length) whatever the keys number, children are
+ * ordered by byte, so scans walk keys in memcmp order. Keys are not
+ * copied.
+ */
+
+#ifndef __ART_H
+#define __ART_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ART_PREFIX_MAX 10        // prefix bytes kept in a node
+
+typedef enum {
+    ART_OK = 0,
+    ART_ENOMEM = -1,        /* No memory error */
+    ART_ENOTFOUND = -2,     /* Key was not found */
+} art_error_t;
+
+typedef enum {
+    ART_NODE4 = 0,
+    ART_NODE16 = 1,
+    ART_NODE48 = 2,
+    ART_NODE256 = 3,
+} art_node_type_t;
+
+typedef struct art_leaf_st {
+    uint8_t *key;
+    size_t key_len;
+    void *val;
+} art_leaf_t;
+
+typedef struct art_node_st {
+    uint8_t type;                    /* art_node_type_t */
+    uint16_t num;                    /* children number */
+    size_t prefix_len;               /* compressed path length */
+    uint8_t prefix[ART_PREFIX_MAX];  /* compressed path, first bytes */
+    art_leaf_t *leaf;                /* key ending at this node, or NULL */
+} art_node_t;
+
+/* children are tagged pointers, the low bit is set for leaves */
+
+typedef struct art_node4_st {
+    art_node_t node;
+    uint8_t keys[4];                 /* sorted */
+    void *children[4];
+} art_node4_t;
+
+typedef struct art_node16_st {
+    art_node_t node;
+    uint8_t keys[16];                /* sorted */
+    void *children[16];
+} art_node16_t;
+
+typedef struct art_node48_st {
+    art_node_t node;
+    uint8_t index[256];              /* byte => slot + 1, 0 if none */
+    void *children[48];
+} art_node48_t;
+
+typedef struct art_node256_st {
+    art_node_t node;
+    void *children[256];
+} art_node256_t;
+
+typedef struct art_st {
+    void *root;                      /* tagged, or NULL */
+    size_t size;                     /* keys number */
+} art_t;
+
+typedef void (*art_scan_func_t)(uint8_t *, size_t, void *, void *);
+
+art_t *art_new(void);
+void art_free(art_t *);
+void art_clear(art_t *);
+int art_set(art_t *, uint8_t *, size_t, void *);
+void *art_get(art_t *, uint8_t *, size_t);
+bool art_has(art_t *, uint8_t *, size_t);
+int art_del(art_t *, uint8_t *, size_t);
+size_t art_size(art_t *);
+art_leaf_t *art_longest_prefix(art_t *, uint8_t *, size_t);
+size_t art_scan_prefix(art_t *, uint8_t *, size_t, art_scan_func_t,
+        void *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <math.h>
+
+#include "bloom.h"
+
+/* odd multipliers, one per word, spreading the hash to bit positions */
+static const uint32_t bloom_salts[BLOOM_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+/**
+ * Get the block of a hash by its high bits (multiply and shift instead of
+ * modulo), the low bits are left for the bits in the block.
+ */
+static bloom_block_t *
+bloom_block(bloom_t *bloom, uint64_t hash)
+{
+    return &(bloom->blocks)[((hash >> 32) * bloom->blocks_num) >> 32];
+}
+
+/**
+ * Get the bits of a hash in a block, one bit per word.
+ */
+static void
+bloom_mask(uint64_t hash, bloom_block_t *mask)
+{
+    size_t i;
+
+    for (i = 0; i < BLOOM_BLOCK_WORDS; i++)
+        (mask->words)[i] = 1U << (((uint32_t)hash * bloom_salts[i]) >> 27);
+}
+
+/**
+ * False positive probability of a filter with `bits` bits per key: keys
+ * per block are Poisson distributed, and a key with `j` keys in its block
+ * is a false positive if its bit in each word is set.
+ */
+static double
+bloom_fpp(double bits)
+{
+    double keys = BLOOM_BLOCK_WORDS * 32 / bits;  // keys per block
+    double p = exp(-keys), fpp = 0;
+    size_t j;
+
+    for (j = 0; j < keys * 4 + 32; j++) {
+        fpp += p * pow(1 - pow(1 - 1.0 / 32, j), BLOOM_BLOCK_WORDS);
+        p *= keys / (j + 1);
+    }
+    return fpp;
+}
+
+/**
+ * New bloom filter for `n` keys with false positive probability `fpp` (0
+ * for `BLOOM_FPP_DEFAULT`).
+ */
+bloom_t *
+bloom_new(size_t n, double fpp)
+{
+    assert(fpp >= 0 && fpp < 1);
+
+    if (fpp == 0)
+        fpp = BLOOM_FPP_DEFAULT;
+
+    bloom_t *bloom = malloc(sizeof(bloom_t));
+
+    if (bloom != NULL) {
+        // bits per key by bisection, blocks cost more than a plain filter
+        double lo = 1, hi = 64;
+
+        while (hi - lo > 0.01) {
+            double mid = (lo + hi) / 2;
+
+            if (bloom_fpp(mid) > fpp)
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        bloom->blocks_num = (size_t)(hi * n / (BLOOM_BLOCK_WORDS * 32)) + 1;
+        bloom->size = 0;
+        bloom->seed = hash_seed();
+
+        if (posix_memalign((void **)&bloom->blocks, 64,
+                    bloom->blocks_num * sizeof(bloom_block_t)) != 0) {
+            free(bloom);
+            return NULL;
+        }
+        bloom_clear(bloom);
+    }
+    return bloom;
+}
+
+/**
+ * Free bloom filter.
+ */
+void
+bloom_free(bloom_t *bloom)
+{
+    if (bloom != NULL) {
+        free(bloom->blocks);
+        free(bloom);
+    }
+}
+
+/**
+ * Clear bloom filter.
+ */
+void
+bloom_clear(bloom_t *bloom)
+{
+    assert(bloom != NULL);
+    memset(bloom->blocks, 0, bloom->blocks_num * sizeof(bloom_block_t));
+    bloom->size = 0;
+}
+
+/**
+ * Add a hash to bloom filter.
+ */
+void
+bloom_add_hash(bloom_t *bloom, uint64_t hash)
+{
+    assert(bloom != NULL);
+
+    bloom_block_t *block = bloom_block(bloom, hash);
+    bloom_block_t mask;
+    size_t i;
+
+    bloom_mask(hash, &mask);
+
+    for (i = 0; i < BLOOM_BLOCK_WORDS; i++)
+        (block->words)[i] |= (mask.words)[i];
+    bloom->size += 1;
+}
+
+/**
+ * Test if a hash may be in bloom filter, false means it was never added.
+ */
+bool
+bloom_has_hash(bloom_t *bloom, uint64_t hash)
+{
+    assert(bloom != NULL);
+
+    bloom_block_t *block = bloom_block(bloom, hash);
+    bloom_block_t mask;
+    uint32_t miss = 0;
+    size_t i;
+
+    bloom_mask(hash, &mask);
+
+    // no early exit, so the loop is vectorized
+    for (i = 0; i < BLOOM_BLOCK_WORDS; i++)
+        miss |= ~(block->words)[i] & (mask.words)[i];
+    return miss == 0;
+}
+
+/**
+ * Add a key to bloom filter.
+ */
+void
+bloom_add(bloom_t *bloom, uint8_t *key, size_t key_len)
+{
+    assert(bloom != NULL);
+    bloom_add_hash(bloom, hash_bytes(key, key_len, bloom->seed));
+}
+
+/**
+ * Test if a key may be in bloom filter, false means it was never added.
+ */
+bool
+bloom_has(bloom_t *bloom, uint8_t *key, size_t key_len)
+{
+    assert(bloom != NULL);
+    return bloom_has_hash(bloom, hash_bytes(key, key_len, bloom->seed));
+}
+
+/**
+ * Get the number of keys added.
+ */
+size_t
+bloom_size(bloom_t *bloom)
+{
+    assert(bloom != NULL);
+    return bloom->size;
+}
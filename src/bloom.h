@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Blocked bloom filter (split block).
+ *
+ * Each key sets 8 bits in one 32 bytes block, one bit in each of the
+ * block's 8 words, so a lookup touches one cache line. The 8 word tests
+ * are independent and written as a plain loop over the block, which
+ * compilers turn into SIMD instructions.
+ *
+ * To sit in front of a dict, feed the filter with the dict's hashes
+ * (`bloom_add_hash`, `bloom_has_hash` with `dict_hash`) and reuse the
+ * hash for `dict_lookup` when the filter says maybe.
+ */
+
+#ifndef __BLOOM_H
+#define __BLOOM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_BLOCK_WORDS 8      // 32 bits words per block, one bit each
+#define BLOOM_FPP_DEFAULT 0.01   // default false positive probability
+
+typedef struct bloom_block_st {
+    uint32_t words[BLOOM_BLOCK_WORDS];
+} bloom_block_t;
+
+typedef struct bloom_st {
+    bloom_block_t *blocks;           /* 32 bytes aligned */
+    size_t blocks_num;
+    size_t size;                     /* keys added */
+    uint64_t seed;                   /* hash seed */
+} bloom_t;
+
+bloom_t *bloom_new(size_t, double);
+void bloom_free(bloom_t *);
+void bloom_clear(bloom_t *);
+void bloom_add(bloom_t *, uint8_t *, size_t);
+bool bloom_has(bloom_t *, uint8_t *, size_t);
+void bloom_add_hash(bloom_t *, uint64_t);
+bool bloom_has_hash(bloom_t *, uint64_t);
+size_t bloom_size(bloom_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
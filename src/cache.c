@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cache.h"
+
+/**
+ * Unlink an entry from the recency list.
+ */
+static void
+cache_unlink(cache_t *cache, cache_entry_t *entry)
+{
+    if (entry->prev != NULL)
+        entry->prev->next = entry->next;
+    else
+        cache->head = entry->next;
+
+    if (entry->next != NULL)
+        entry->next->prev = entry->prev;
+    else
+        cache->tail = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+/**
+ * Link an entry as the most recently used.
+ */
+static void
+cache_link_head(cache_t *cache, cache_entry_t *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+
+    if (cache->head != NULL)
+        cache->head->prev = entry;
+    else
+        cache->tail = entry;
+
+    cache->head = entry;
+}
+
+/**
+ * Remove an entry from the cache, the evict callback is called.
+ */
+static void
+cache_remove(cache_t *cache, cache_entry_t *entry)
+{
+    cache_unlink(cache, entry);
+    dict_del_hashed(cache->dict, entry->key, entry->key_len, entry->hash);
+    cache->bytes -= entry->size;
+
+    if (cache->evict != NULL)
+        (cache->evict)(entry->key, entry->key_len, entry->val,
+                cache->evict_data);
+
+    pool_dealloc(cache->pool, entry);
+}
+
+/**
+ * Test if the cache is over its capacity.
+ */
+static bool
+cache_is_full(cache_t *cache)
+{
+    return (cache->cap > 0 && dict_size(cache->dict) > cache->cap) ||
+        (cache->cap_bytes > 0 && cache->bytes > cache->cap_bytes);
+}
+
+/**
+ * New cache holding at most `cap` entries and `cap_bytes` bytes, 0 for
+ * no limit.
+ */
+cache_t *
+cache_new(size_t cap, size_t cap_bytes)
+{
+    cache_t *cache = malloc(sizeof(cache_t));
+
+    if (cache != NULL) {
+        cache->dict = dict_new();
+        cache->pool = pool_new(sizeof(cache_entry_t));
+
+        if (cache->dict == NULL || cache->pool == NULL) {
+            dict_free(cache->dict);
+            pool_free(cache->pool);
+            free(cache);
+            return NULL;
+        }
+
+        cache->head = NULL;
+        cache->tail = NULL;
+        cache->cap = cap;
+        cache->cap_bytes = cap_bytes;
+        cache->bytes = 0;
+        cache->evict = NULL;
+        cache->evict_data = NULL;
+    }
+    return cache;
+}
+
+/**
+ * Free cache.
+ */
+void
+cache_free(cache_t *cache)
+{
+    if (cache != NULL) {
+        cache_clear(cache);
+        dict_free(cache->dict);
+        pool_free(cache->pool);
+        free(cache);
+    }
+}
+
+/**
+ * Clear cache, O(n) if there is an evict callback, else O(buckets).
+ */
+void
+cache_clear(cache_t *cache)
+{
+    assert(cache != NULL);
+
+    if (cache->evict != NULL) {
+        cache_entry_t *entry = cache->head;
+
+        while (entry != NULL) {
+            (cache->evict)(entry->key, entry->key_len, entry->val,
+                    cache->evict_data);
+            entry = entry->next;
+        }
+    }
+
+    dict_clear(cache->dict);
+    pool_clear(cache->pool);
+    cache->head = NULL;
+    cache->tail = NULL;
+    cache->bytes = 0;
+}
+
+/**
+ * Set the evict callback.
+ */
+void
+cache_on_evict(cache_t *cache, cache_evict_func_t evict, void *data)
+{
+    assert(cache != NULL);
+    cache->evict = evict;
+    cache->evict_data = data;
+}
+
+/**
+ * Set a key to cache charging `size` bytes, evicts the least recently used
+ * entries if the cache is full. An entry larger than `cap_bytes` is kept
+ * until the next set.
+ */
+int
+cache_set(cache_t *cache, uint8_t *key, size_t key_len, void *val,
+        size_t size)
+{
+    assert(cache != NULL);
+
+    uint64_t hash = dict_hash(cache->dict, key, key_len);
+    dict_node_t *node = dict_lookup(cache->dict, key, key_len, hash);
+    cache_entry_t *entry;
+
+    if (node != NULL) {
+        entry = node->val;
+
+        if (cache->evict != NULL && entry->val != val)
+            (cache->evict)(entry->key, entry->key_len, entry->val,
+                    cache->evict_data);
+
+        node->key = key;
+        entry->key = key;
+        entry->val = val;
+        cache->bytes = cache->bytes - entry->size + size;
+        entry->size = size;
+        cache_unlink(cache, entry);
+    } else {
+        entry = pool_alloc(cache->pool);
+
+        if (entry == NULL)
+            return CACHE_ENOMEM;
+
+        if (dict_set_hashed(cache->dict, key, key_len, hash, entry) !=
+                DICT_OK) {
+            pool_dealloc(cache->pool, entry);
+            return CACHE_ENOMEM;
+        }
+
+        entry->key = key;
+        entry->key_len = key_len;
+        entry->hash = hash;
+        entry->val = val;
+        entry->size = size;
+        cache->bytes += size;
+    }
+
+    cache_link_head(cache, entry);
+
+    while (cache_is_full(cache) && cache->tail != entry)
+        cache_remove(cache, cache->tail);
+    return CACHE_OK;
+}
+
+/**
+ * Get val from cache by key and mark it most recently used, O(1).
+ */
+void *
+cache_get(cache_t *cache, uint8_t *key, size_t key_len)
+{
+    assert(cache != NULL);
+
+    cache_entry_t *entry = dict_get(cache->dict, key, key_len);
+
+    if (entry == NULL)
+        return NULL;
+
+    if (entry != cache->head) {
+        cache_unlink(cache, entry);
+        cache_link_head(cache, entry);
+    }
+    return entry->val;
+}
+
+/**
+ * Test if a key is in the cache (recency is not changed).
+ */
+bool
+cache_has(cache_t *cache, uint8_t *key, size_t key_len)
+{
+    assert(cache != NULL);
+    return dict_has(cache->dict, key, key_len);
+}
+
+/**
+ * Del a key from cache.
+ */
+int
+cache_del(cache_t *cache, uint8_t *key, size_t key_len)
+{
+    assert(cache != NULL);
+
+    cache_entry_t *entry = dict_get(cache->dict, key, key_len);
+
+    if (entry == NULL)
+        return CACHE_ENOTFOUND;
+
+    cache_remove(cache, entry);
+    return CACHE_OK;
+}
+
+/**
+ * Get cache size (entries number).
+ */
+size_t
+cache_size(cache_t *cache)
+{
+    assert(cache != NULL);
+    return dict_size(cache->dict);
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * LRU cache (dict based).
+ *
+ * Entries are indexed by a dict and linked in recency order by their own
+ * prev/next pointers, so a hit is one dict lookup plus O(1) relinking.
+ * The cache is bounded by entries number and/or by bytes (the size given
+ * to each `cache_set`), least recently used entries are evicted first.
+ *
+ * The evict callback is called whenever an entry leaves the cache:
+ * evicted, deleted, replaced by `cache_set`, cleared or freed.
+ */
+
+#ifndef __CACHE_H
+#define __CACHE_H
+
+#include "dict.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CACHE_OK = 0,
+    CACHE_ENOMEM = -1,      /* No memory error */
+    CACHE_ENOTFOUND = -2,   /* Key was not found */
+} cache_error_t;
+
+typedef void (*cache_evict_func_t)(uint8_t *, size_t, void *, void *);
+
+typedef struct cache_entry_st {
+    uint8_t *key;
+    size_t key_len;
+    uint64_t hash;
+    void *val;
+    size_t size;                     /* bytes charged for this entry */
+    struct cache_entry_st *prev;     /* more recently used */
+    struct cache_entry_st *next;     /* less recently used */
+} cache_entry_t;
+
+typedef struct cache_st {
+    dict_t *dict;                    /* key => entry */
+    pool_t *pool;                    /* entries pool */
+    cache_entry_t *head;             /* most recently used */
+    cache_entry_t *tail;             /* least recently used */
+    size_t cap;                      /* max entries number, 0 for no limit */
+    size_t cap_bytes;                /* max bytes, 0 for no limit */
+    size_t bytes;                    /* bytes in use */
+    cache_evict_func_t evict;        /* evict callback */
+    void *evict_data;                /* evict callback data */
+} cache_t;
+
+cache_t *cache_new(size_t, size_t);
+void cache_free(cache_t *);
+void cache_clear(cache_t *);
+void cache_on_evict(cache_t *, cache_evict_func_t, void *);
+int cache_set(cache_t *, uint8_t *, size_t, void *, size_t);
+void *cache_get(cache_t *, uint8_t *, size_t);
+bool cache_has(cache_t *, uint8_t *, size_t);
+int cache_del(cache_t *, uint8_t *, size_t);
+size_t cache_size(cache_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cdict.h"
+
+/**
+ * Hash a key, all shards share the same hash function and seed.
+ */
+static uint64_t
+cdict_hash(cdict_t *cdict, uint8_t *key, size_t key_len)
+{
+    return dict_hash((cdict->shards)[0].dict, key, key_len);
+}
+
+/**
+ * Get the shard of a hash by its high bits, the low bits are left for the
+ * shard's buckets.
+ */
+static cdict_shard_t *
+cdict_shard(cdict_t *cdict, uint64_t hash)
+{
+    if (cdict->shard_bits == 0)
+        return cdict->shards;
+    return &(cdict->shards)[hash >> (64 - cdict->shard_bits)];
+}
+
+/**
+ * New cdict with at least `shards_num` shards (rounded up to power of 2),
+ * 0 for CDICT_SHARDS_DEFAULT.
+ */
+cdict_t *
+cdict_new(size_t shards_num)
+{
+    if (shards_num == 0)
+        shards_num = CDICT_SHARDS_DEFAULT;
+
+    cdict_t *cdict = malloc(sizeof(cdict_t));
+
+    if (cdict == NULL)
+        return NULL;
+
+    cdict->shards_num = 1;
+    cdict->shard_bits = 0;
+
+    while (cdict->shards_num < shards_num) {
+        cdict->shards_num *= 2;
+        cdict->shard_bits += 1;
+    }
+
+    void *shards;
+
+    if (posix_memalign(&shards, 64,
+                cdict->shards_num * sizeof(cdict_shard_t)) != 0) {
+        free(cdict);
+        return NULL;
+    }
+
+    cdict->shards = shards;
+
+    size_t index;
+
+    for (index = 0; index < cdict->shards_num; index++) {
+        cdict_shard_t *shard = &(cdict->shards)[index];
+        shard->dict = dict_new();
+
+        if (shard->dict == NULL) {
+            cdict->shards_num = index;
+            cdict_free(cdict);
+            return NULL;
+        }
+
+        // shards before this one are initialised, free them only
+        if (pthread_rwlock_init(&shard->lock, NULL) != 0) {
+            dict_free(shard->dict);
+            cdict->shards_num = index;
+            cdict_free(cdict);
+            return NULL;
+        }
+    }
+    return cdict;
+}
+
+/**
+ * Free cdict, no other threads should be using it.
+ */
+void
+cdict_free(cdict_t *cdict)
+{
+    if (cdict != NULL) {
+        size_t index;
+
+        for (index = 0; index < cdict->shards_num; index++) {
+            cdict_shard_t *shard = &(cdict->shards)[index];
+            pthread_rwlock_destroy(&shard->lock);
+            dict_free(shard->dict);
+        }
+
+        free(cdict->shards);
+        free(cdict);
+    }
+}
+
+/**
+ * Clear cdict, shard by shard.
+ */
+void
+cdict_clear(cdict_t *cdict)
+{
+    assert(cdict != NULL);
+
+    size_t index;
+
+    for (index = 0; index < cdict->shards_num; index++) {
+        cdict_shard_t *shard = &(cdict->shards)[index];
+        pthread_rwlock_wrlock(&shard->lock);
+        dict_clear(shard->dict);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
+
+/**
+ * Set a key to cdict.
+ */
+int
+cdict_set(cdict_t *cdict, uint8_t *key, size_t key_len, void *val)
+{
+    assert(cdict != NULL);
+
+    uint64_t hash = cdict_hash(cdict, key, key_len);
+    cdict_shard_t *shard = cdict_shard(cdict, hash);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    int result = dict_set_hashed(shard->dict, key, key_len, hash, val);
+    pthread_rwlock_unlock(&shard->lock);
+
+    if (result != DICT_OK)
+        return CDICT_ENOMEM;
+    return CDICT_OK;
+}
+
+/**
+ * Get val from cdict by key.
+ */
+void *
+cdict_get(cdict_t *cdict, uint8_t *key, size_t key_len)
+{
+    assert(cdict != NULL);
+
+    uint64_t hash = cdict_hash(cdict, key, key_len);
+    cdict_shard_t *shard = cdict_shard(cdict, hash);
+    void *val = NULL;
+
+    pthread_rwlock_rdlock(&shard->lock);
+    dict_node_t *node = dict_lookup(shard->dict, key, key_len, hash);
+    if (node != NULL)
+        val = node->val;
+    pthread_rwlock_unlock(&shard->lock);
+    return val;
+}
+
+/**
+ * Test if a key is in the cdict.
+ */
+bool
+cdict_has(cdict_t *cdict, uint8_t *key, size_t key_len)
+{
+    assert(cdict != NULL);
+
+    uint64_t hash = cdict_hash(cdict, key, key_len);
+    cdict_shard_t *shard = cdict_shard(cdict, hash);
+
+    pthread_rwlock_rdlock(&shard->lock);
+    bool result = dict_lookup(shard->dict, key, key_len, hash) != NULL;
+    pthread_rwlock_unlock(&shard->lock);
+    return result;
+}
+
+/**
+ * Del val from cdict by key.
+ */
+int
+cdict_del(cdict_t *cdict, uint8_t *key, size_t key_len)
+{
+    assert(cdict != NULL);
+
+    uint64_t hash = cdict_hash(cdict, key, key_len);
+    cdict_shard_t *shard = cdict_shard(cdict, hash);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    int result = dict_del_hashed(shard->dict, key, key_len, hash);
+    pthread_rwlock_unlock(&shard->lock);
+
+    if (result == DICT_ENOMEM)
+        return CDICT_ENOMEM;
+    if (result != DICT_OK)
+        return CDICT_ENOTFOUND;
+    return CDICT_OK;
+}
+
+/**
+ * Get cdict size (sum of shards' sizes, not a snapshot).
+ */
+size_t
+cdict_size(cdict_t *cdict)
+{
+    assert(cdict != NULL);
+
+    size_t index, size = 0;
+
+    for (index = 0; index < cdict->shards_num; index++) {
+        cdict_shard_t *shard = &(cdict->shards)[index];
+        pthread_rwlock_rdlock(&shard->lock);
+        size += dict_size(shard->dict);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+    return size;
+}
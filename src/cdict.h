@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Concurrent dict (sharded).
+ *
+ * Keys are spread over shards by the high bits of their hashes, each shard
+ * is a dict (resizing on its own) guarded by a reader-writer lock. Reads
+ * take the shard's read lock only and never rehash, so lookups on
+ * different keys (or the same key) run in parallel.
+ */
+
+#ifndef __CDICT_H
+#define __CDICT_H
+
+#include <pthread.h>
+
+#include "dict.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CDICT_SHARDS_DEFAULT 64  // default shards number
+
+typedef enum {
+    CDICT_OK = 0,
+    CDICT_ENOMEM = -1,      /* No memory error */
+    CDICT_ENOTFOUND = -2,   /* Key was not found */
+} cdict_error_t;
+
+typedef struct cdict_shard_st {
+    pthread_rwlock_t lock;
+    dict_t *dict;
+    uint8_t pad[64];                 /* no false sharing between shards */
+} cdict_shard_t;
+
+typedef struct cdict_st {
+    cdict_shard_t *shards;
+    size_t shards_num;               /* shards number (power of 2) */
+    size_t shard_bits;               /* log2(shards_num) */
+} cdict_t;
+
+cdict_t *cdict_new(size_t);
+void cdict_free(cdict_t *);
+void cdict_clear(cdict_t *);
+int cdict_set(cdict_t *, uint8_t *, size_t, void *);
+void *cdict_get(cdict_t *, uint8_t *, size_t);
+bool cdict_has(cdict_t *, uint8_t *, size_t);
+int cdict_del(cdict_t *, uint8_t *, size_t);
+size_t cdict_size(cdict_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cms.h"
+
+/**
+ * Get the counters of a hash, one per row.
+ */
+static void
+cms_slots(cms_t *cms, uint64_t hash, uint32_t **slots)
+{
+    uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32) | 1;
+    size_t i;
+
+    for (i = 0; i < cms->depth; i++)
+        slots[i] = cms->counters + i * cms->width +
+            ((h1 + i * h2) & (cms->width - 1));
+}
+
+/**
+ * New sketch with `depth` rows of `width` counters (0 for defaults),
+ * width is rounded up to a power of 2.
+ */
+cms_t *
+cms_new(size_t width, size_t depth)
+{
+    if (width == 0)
+        width = CMS_WIDTH_DEFAULT;
+    if (depth == 0)
+        depth = CMS_DEPTH_DEFAULT;
+
+    assert(depth <= CMS_DEPTH_MAX);
+
+    cms_t *cms = malloc(sizeof(cms_t));
+
+    if (cms != NULL) {
+        cms->width = 1;
+        while (cms->width < width)
+            cms->width <<= 1;
+
+        cms->depth = depth;
+        cms->seed = CMS_SEED;
+        cms->total = 0;
+        cms->counters = calloc(cms->width * depth, sizeof(uint32_t));
+
+        if (cms->counters == NULL) {
+            free(cms);
+            return NULL;
+        }
+    }
+    return cms;
+}
+
+/**
+ * Free sketch.
+ */
+void
+cms_free(cms_t *cms)
+{
+    if (cms != NULL) {
+        free(cms->counters);
+        free(cms);
+    }
+}
+
+/**
+ * Clear sketch.
+ */
+void
+cms_clear(cms_t *cms)
+{
+    assert(cms != NULL);
+    memset(cms->counters, 0, cms->width * cms->depth * sizeof(uint32_t));
+    cms->total = 0;
+}
+
+/**
+ * Add `count` to a hash, returns its new estimated count.
+ */
+uint64_t
+cms_add_hash(cms_t *cms, uint64_t hash, uint32_t count)
+{
+    assert(cms != NULL);
+
+    uint32_t *slots[CMS_DEPTH_MAX];
+    uint32_t min = UINT32_MAX;
+    size_t i;
+
+    cms_slots(cms, hash, slots);
+
+    for (i = 0; i < cms->depth; i++)
+        if (*slots[i] < min)
+            min = *slots[i];
+
+    uint32_t target = min > UINT32_MAX - count ? UINT32_MAX : min + count;
+
+    // conservative update: no counter goes over the new estimate
+    for (i = 0; i < cms->depth; i++)
+        if (*slots[i] < target)
+            *slots[i] = target;
+
+    cms->total += count;
+    return target;
+}
+
+/**
+ * Add `count` to a key, returns its new estimated count.
+ */
+uint64_t
+cms_add(cms_t *cms, uint8_t *key, size_t key_len, uint32_t count)
+{
+    assert(cms != NULL);
+    return cms_add_hash(cms, hash_bytes(key, key_len, cms->seed), count);
+}
+
+/**
+ * Get the estimated count of a hash.
+ */
+uint64_t
+cms_count_hash(cms_t *cms, uint64_t hash)
+{
+    assert(cms != NULL);
+
+    uint32_t *slots[CMS_DEPTH_MAX];
+    uint32_t min = UINT32_MAX;
+    size_t i;
+
+    cms_slots(cms, hash, slots);
+
+    for (i = 0; i < cms->depth; i++)
+        if (*slots[i] < min)
+            min = *slots[i];
+    return min;
+}
+
+/**
+ * Get the estimated count of a key.
+ */
+uint64_t
+cms_count(cms_t *cms, uint8_t *key, size_t key_len)
+{
+    assert(cms != NULL);
+    return cms_count_hash(cms, hash_bytes(key, key_len, cms->seed));
+}
+
+/**
+ * Merge `src` into `dst`, both must have the same sizes and seed.
+ */
+int
+cms_merge(cms_t *dst, cms_t *src)
+{
+    assert(dst != NULL && src != NULL);
+
+    size_t i;
+
+    if (dst->width != src->width || dst->depth != src->depth ||
+            dst->seed != src->seed)
+        return CMS_EMISMATCH;
+
+    for (i = 0; i < dst->width * dst->depth; i++) {
+        uint32_t a = (dst->counters)[i], b = (src->counters)[i];
+        (dst->counters)[i] = a > UINT32_MAX - b ? UINT32_MAX : a + b;
+    }
+    dst->total += src->total;
+    return CMS_OK;
+}
+
+/**
+ * Append sketch to buf: a header, then the counters.
+ */
+int
+cms_dump(cms_t *cms, buf_t *buf)
+{
+    assert(cms != NULL && buf != NULL);
+
+    cms_header_t header = {CMS_MAGIC, cms->width, cms->depth, cms->seed,
+        cms->total};
+
+    if (buf_put(buf, (uint8_t *)&header, sizeof(header)) != BUF_OK ||
+            buf_put(buf, (uint8_t *)cms->counters,
+                cms->width * cms->depth * sizeof(uint32_t)) != BUF_OK)
+        return CMS_ENOMEM;
+    return CMS_OK;
+}
+
+/**
+ * Load a sketch from a dump, NULL if no memory or the dump is invalid.
+ */
+cms_t *
+cms_load(uint8_t *data, size_t len)
+{
+    assert(data != NULL);
+
+    cms_header_t header;
+
+    if (len < sizeof(header))
+        return NULL;
+
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != CMS_MAGIC || header.width == 0 ||
+            (header.width & (header.width - 1)) != 0 ||
+            header.depth == 0 || header.depth > CMS_DEPTH_MAX ||
+            header.width > (len - sizeof(header)) / sizeof(uint32_t) ||
+            len - sizeof(header) != header.width * header.depth *
+            sizeof(uint32_t))
+        return NULL;
+
+    cms_t *cms = cms_new(header.width, header.depth);
+
+    if (cms != NULL) {
+        cms->seed = header.seed;
+        cms->total = header.total;
+        memcpy(cms->counters, data + sizeof(header),
+                len - sizeof(header));
+    }
+    return cms;
+}
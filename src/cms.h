@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Count-Min sketch, keys frequencies in fixed memory.
+ *
+ * `depth` rows of `width` counters, a key adds to one counter per row and
+ * its count is the minimum of them: never under the real count, over it
+ * by at most total / width * e with probability 1 - e^-depth. Adds are
+ * conservative (only the counters at the minimum grow), which keeps the
+ * overcount lower.
+ *
+ * Keys are hashed once by `hash_bytes` with a fixed seed (stored with the
+ * sketch), rows derive their counters from the two halves of the hash.
+ * Dumps are in host byte order.
+ */
+
+#ifndef __CMS_H
+#define __CMS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+#include "buf.h"
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CMS_MAGIC 0x3130534d430000ULL    // "\0\0CMS01"
+#define CMS_WIDTH_DEFAULT 2048
+#define CMS_DEPTH_DEFAULT 4
+#define CMS_DEPTH_MAX 16
+#define CMS_SEED 0x636f756e746d696eULL   // default hash seed
+
+typedef enum {
+    CMS_OK = 0,
+    CMS_ENOMEM = -1,        /* No memory error */
+    CMS_EMISMATCH = -2,     /* Sizes or seeds differ */
+} cms_error_t;
+
+typedef struct cms_header_st {
+    uint64_t magic;
+    uint64_t width;
+    uint64_t depth;
+    uint64_t seed;
+    uint64_t total;
+} cms_header_t;
+
+typedef struct cms_st {
+    size_t width;                    /* counters per row (power of 2) */
+    size_t depth;                    /* rows number */
+    uint32_t *counters;              /* depth * width, saturating */
+    uint64_t total;                  /* sum of all adds */
+    uint64_t seed;                   /* hash_bytes seed */
+} cms_t;
+
+cms_t *cms_new(size_t, size_t);
+void cms_free(cms_t *);
+void cms_clear(cms_t *);
+uint64_t cms_add(cms_t *, uint8_t *, size_t, uint32_t);
+uint64_t cms_add_hash(cms_t *, uint64_t, uint32_t);
+uint64_t cms_count(cms_t *, uint8_t *, size_t);
+uint64_t cms_count_hash(cms_t *, uint64_t);
+int cms_merge(cms_t *, cms_t *);
+int cms_dump(cms_t *, buf_t *);
+cms_t *cms_load(uint8_t *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,302 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "cuckoo.h"
+
+#define CUCKOO_LANES 0x0001000100010001ULL  // 1 in each 16 bits lane
+#define CUCKOO_HIGHS 0x8000800080008000ULL  // high bit of each lane
+
+/**
+ * Get the fingerprint of a hash (high bits, never 0).
+ */
+static uint16_t
+cuckoo_fingerprint(uint64_t hash)
+{
+    uint16_t fp = (uint16_t)(hash >> 48);
+    return fp != 0 ? fp : 1;
+}
+
+/**
+ * Get the other candidate bucket of a fingerprint, it's symmetric:
+ * alt(alt(index)) == index.
+ */
+static size_t
+cuckoo_alt_index(cuckoo_t *cuckoo, size_t index, uint16_t fp)
+{
+    return (index ^ (size_t)(fp * 0x5bd1e995U)) & (cuckoo->buckets_num - 1);
+}
+
+/**
+ * Get a bit mask with the high bit set of each lane of bucket equal to
+ * `fp` (the exact zero byte test, no false matches).
+ */
+static uint64_t
+cuckoo_match(uint64_t bucket, uint16_t fp)
+{
+    uint64_t x = bucket ^ (fp * CUCKOO_LANES);
+    return ~(((x & ~CUCKOO_HIGHS) + ~CUCKOO_HIGHS) | x | ~CUCKOO_HIGHS);
+}
+
+/**
+ * Get the lane (0..3) of the lowest bit set in a match mask.
+ */
+static size_t
+cuckoo_lane(uint64_t match)
+{
+    size_t lane = 0;
+
+    while ((match & 0x8000) == 0) {
+        match >>= 16;
+        lane++;
+    }
+    return lane;
+}
+
+/**
+ * Put a fingerprint to a free slot of a bucket, returns false if full.
+ */
+static bool
+cuckoo_bucket_put(cuckoo_t *cuckoo, size_t index, uint16_t fp)
+{
+    uint64_t match = cuckoo_match((cuckoo->buckets)[index], 0);
+
+    if (match == 0)
+        return false;
+    (cuckoo->buckets)[index] |= (uint64_t)fp << (cuckoo_lane(match) * 16);
+    return true;
+}
+
+/**
+ * Remove a fingerprint from a bucket, returns false if not there.
+ */
+static bool
+cuckoo_bucket_del(cuckoo_t *cuckoo, size_t index, uint16_t fp)
+{
+    uint64_t match = cuckoo_match((cuckoo->buckets)[index], fp);
+
+    if (match == 0)
+        return false;
+    (cuckoo->buckets)[index] &= ~((uint64_t)0xffff <<
+            (cuckoo_lane(match) * 16));
+    return true;
+}
+
+/**
+ * Next random number (xorshift64).
+ */
+static uint64_t
+cuckoo_rand(cuckoo_t *cuckoo)
+{
+    uint64_t x = cuckoo->rand;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return cuckoo->rand = x;
+}
+
+/**
+ * New cuckoo filter with room for about `n` keys.
+ */
+cuckoo_t *
+cuckoo_new(size_t n)
+{
+    cuckoo_t *cuckoo = malloc(sizeof(cuckoo_t));
+
+    if (cuckoo != NULL) {
+        size_t slots = (size_t)(n / CUCKOO_LOAD_LIMIT) + 1;
+
+        cuckoo->buckets_num = 1;
+        while (cuckoo->buckets_num * CUCKOO_BUCKET_SLOTS < slots)
+            cuckoo->buckets_num <<= 1;
+
+        cuckoo->buckets = malloc(cuckoo->buckets_num * sizeof(uint64_t));
+
+        if (cuckoo->buckets == NULL) {
+            free(cuckoo);
+            return NULL;
+        }
+
+        cuckoo->seed = hash_seed();
+        cuckoo->rand = cuckoo->seed | 1;
+        cuckoo_clear(cuckoo);
+    }
+    return cuckoo;
+}
+
+/**
+ * Free cuckoo filter.
+ */
+void
+cuckoo_free(cuckoo_t *cuckoo)
+{
+    if (cuckoo != NULL) {
+        free(cuckoo->buckets);
+        free(cuckoo);
+    }
+}
+
+/**
+ * Clear cuckoo filter.
+ */
+void
+cuckoo_clear(cuckoo_t *cuckoo)
+{
+    assert(cuckoo != NULL);
+    memset(cuckoo->buckets, 0, cuckoo->buckets_num * sizeof(uint64_t));
+    cuckoo->size = 0;
+    cuckoo->victim = 0;
+    cuckoo->victim_index = 0;
+}
+
+/**
+ * Add a hash to cuckoo filter, kicking fingerprints to their other bucket
+ * when both buckets are full.
+ */
+int
+cuckoo_add_hash(cuckoo_t *cuckoo, uint64_t hash)
+{
+    assert(cuckoo != NULL);
+
+    if (cuckoo->victim != 0)
+        return CUCKOO_EFULL;
+
+    uint16_t fp = cuckoo_fingerprint(hash);
+    size_t index = (size_t)hash & (cuckoo->buckets_num - 1);
+    size_t alt_index = cuckoo_alt_index(cuckoo, index, fp);
+    size_t kicks;
+
+    cuckoo->size += 1;
+
+    if (cuckoo_bucket_put(cuckoo, index, fp) ||
+            cuckoo_bucket_put(cuckoo, alt_index, fp))
+        return CUCKOO_OK;
+
+    if (cuckoo_rand(cuckoo) & 1)
+        index = alt_index;
+
+    for (kicks = 0; kicks < CUCKOO_KICKS_MAX; kicks++) {
+        size_t shift = (cuckoo_rand(cuckoo) % CUCKOO_BUCKET_SLOTS) * 16;
+        uint64_t *bucket = &(cuckoo->buckets)[index];
+        uint16_t kicked = (uint16_t)(*bucket >> shift);
+
+        *bucket = (*bucket & ~((uint64_t)0xffff << shift)) |
+            ((uint64_t)fp << shift);
+        fp = kicked;
+        index = cuckoo_alt_index(cuckoo, index, fp);
+
+        if (cuckoo_bucket_put(cuckoo, index, fp))
+            return CUCKOO_OK;
+    }
+
+    // the key is in, but the last kicked has no slot left
+    cuckoo->victim = fp;
+    cuckoo->victim_index = index;
+    return CUCKOO_OK;
+}
+
+/**
+ * Test if a hash may be in cuckoo filter, false means it's not in.
+ */
+bool
+cuckoo_has_hash(cuckoo_t *cuckoo, uint64_t hash)
+{
+    assert(cuckoo != NULL);
+
+    uint16_t fp = cuckoo_fingerprint(hash);
+    size_t index = (size_t)hash & (cuckoo->buckets_num - 1);
+    size_t alt_index = cuckoo_alt_index(cuckoo, index, fp);
+
+    if (cuckoo_match((cuckoo->buckets)[index], fp) != 0 ||
+            cuckoo_match((cuckoo->buckets)[alt_index], fp) != 0)
+        return true;
+    return cuckoo->victim == fp && (cuckoo->victim_index == index ||
+            cuckoo->victim_index == alt_index);
+}
+
+/**
+ * Del a hash from cuckoo filter.
+ */
+int
+cuckoo_del_hash(cuckoo_t *cuckoo, uint64_t hash)
+{
+    assert(cuckoo != NULL);
+
+    uint16_t fp = cuckoo_fingerprint(hash);
+    size_t index = (size_t)hash & (cuckoo->buckets_num - 1);
+    size_t alt_index = cuckoo_alt_index(cuckoo, index, fp);
+
+    if (cuckoo->victim == fp && (cuckoo->victim_index == index ||
+                cuckoo->victim_index == alt_index)) {
+        cuckoo->victim = 0;
+    } else if (!cuckoo_bucket_del(cuckoo, index, fp) &&
+            !cuckoo_bucket_del(cuckoo, alt_index, fp)) {
+        return CUCKOO_ENOTFOUND;
+    }
+
+    // a slot is free now, give it to the victim
+    if (cuckoo->victim != 0) {
+        size_t victim_alt_index = cuckoo_alt_index(cuckoo,
+                cuckoo->victim_index, cuckoo->victim);
+
+        if (cuckoo_bucket_put(cuckoo, cuckoo->victim_index,
+                    cuckoo->victim) ||
+                cuckoo_bucket_put(cuckoo, victim_alt_index, cuckoo->victim))
+            cuckoo->victim = 0;
+    }
+
+    cuckoo->size -= 1;
+    return CUCKOO_OK;
+}
+
+/**
+ * Add a key to cuckoo filter.
+ */
+int
+cuckoo_add(cuckoo_t *cuckoo, uint8_t *key, size_t key_len)
+{
+    assert(cuckoo != NULL);
+    return cuckoo_add_hash(cuckoo, hash_bytes(key, key_len, cuckoo->seed));
+}
+
+/**
+ * Test if a key may be in cuckoo filter, false means it's not in.
+ */
+bool
+cuckoo_has(cuckoo_t *cuckoo, uint8_t *key, size_t key_len)
+{
+    assert(cuckoo != NULL);
+    return cuckoo_has_hash(cuckoo, hash_bytes(key, key_len, cuckoo->seed));
+}
+
+/**
+ * Del a key from cuckoo filter, the key must have been added.
+ */
+int
+cuckoo_del(cuckoo_t *cuckoo, uint8_t *key, size_t key_len)
+{
+    assert(cuckoo != NULL);
+    return cuckoo_del_hash(cuckoo, hash_bytes(key, key_len, cuckoo->seed));
+}
+
+/**
+ * Get the number of keys in cuckoo filter.
+ */
+size_t
+cuckoo_size(cuckoo_t *cuckoo)
+{
+    assert(cuckoo != NULL);
+    return cuckoo->size;
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Cuckoo filter, an approximate membership filter supporting deletes.
+ *
+ * Keys are stored as 16 bits fingerprints in buckets of 4 slots (one
+ * uint64 per bucket), each key has two candidate buckets and the second
+ * is derived from the first and the fingerprint, so fingerprints can be
+ * kicked between buckets without the keys. A bucket is searched with a
+ * few word operations instead of a loop over the slots.
+ *
+ * Adding the same key more than once stores it more than once, delete
+ * only keys that were added. When there's no room left after
+ * `CUCKOO_KICKS_MAX` kicks, the last fingerprint kicked goes to a victim
+ * slot and further adds fail with `CUCKOO_EFULL`.
+ */
+
+#ifndef __CUCKOO_H
+#define __CUCKOO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CUCKOO_BUCKET_SLOTS 4    // fingerprints per bucket
+#define CUCKOO_LOAD_LIMIT 0.95   // expected max slots in use to size for
+#define CUCKOO_KICKS_MAX 500     // max kicks per add
+
+typedef enum {
+    CUCKOO_OK = 0,
+    CUCKOO_ENOMEM = -1,     /* No memory error */
+    CUCKOO_ENOTFOUND = -2,  /* Key was not found */
+    CUCKOO_EFULL = -3,      /* No room left */
+} cuckoo_error_t;
+
+typedef struct cuckoo_st {
+    uint64_t *buckets;               /* 4 fingerprints each, 0 is empty */
+    size_t buckets_num;              /* power of 2 */
+    size_t size;                     /* fingerprints stored */
+    uint16_t victim;                 /* fingerprint without a slot, or 0 */
+    size_t victim_index;             /* a candidate bucket of the victim */
+    uint64_t rand;                   /* kicks random state */
+    uint64_t seed;                   /* hash seed */
+} cuckoo_t;
+
+cuckoo_t *cuckoo_new(size_t);
+void cuckoo_free(cuckoo_t *);
+void cuckoo_clear(cuckoo_t *);
+int cuckoo_add(cuckoo_t *, uint8_t *, size_t);
+bool cuckoo_has(cuckoo_t *, uint8_t *, size_t);
+int cuckoo_del(cuckoo_t *, uint8_t *, size_t);
+int cuckoo_add_hash(cuckoo_t *, uint64_t);
+bool cuckoo_has_hash(cuckoo_t *, uint64_t);
+int cuckoo_del_hash(cuckoo_t *, uint64_t);
+size_t cuckoo_size(cuckoo_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -14,77 +14,101 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <time.h>
+
 #include "dict.h"
 
+#if defined(__GNUC__)
+#define DICT_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define DICT_PREFETCH(addr) ((void)(addr))
+#endif
+
 static size_t table_sizes[] = {
-    7,
-    17,
-    37,
-    79,
-    163,
-    331,
-    673,
-    1361,
-    2729,
-    5471,
-    10949,
-    21911,
-    43853,
-    87719,
-    175447,
-    350899,
-    701819,
-    1403641,
-    2807303,
-    5614657,
-    11229331,
-    44917381,
-    89834777,
-    179669557,
-    359339171,
-    718678369,
-    1437356741,
-    2147483647
+    8,
+    16,
+    32,
+    64,
+    128,
+    256,
+    512,
+    1024,
+    2048,
+    4096,
+    8192,
+    16384,
+    32768,
+    65536,
+    131072,
+    262144,
+    524288,
+    1048576,
+    2097152,
+    4194304,
+    8388608,
+    16777216,
+    33554432,
+    67108864,
+    134217728,
+    268435456,
+    536870912,
+    1073741824,
+    2147483648
 };
 
 static size_t table_size_index_max = sizeof(table_sizes) / \
                                      sizeof(table_sizes[0]) - 1;  // 28
 
 /**
- * BKDRHash
+ * Hash a key with the dict's hash function and seed.
  */
-static size_t
-bkdrhash(uint8_t *key, size_t key_len)
+uint64_t
+dict_hash(dict_t *dict, uint8_t *key, size_t key_len)
 {
-    size_t seed = 13131;  // 31 131 1313 13131..
-    size_t hash = 0;
-
-    for(; key_len > 0; key_len--)
-        hash = hash * seed + (*key++);
-    return (hash & 0x7FFFFFFF);
+    return (dict->hash)(key, key_len, dict->seed);
 }
 
 /**
- * Get table size index.
+ * Get table index by hash.
  */
-size_t
-get_table_index(size_t table_size_index, uint8_t *key, size_t key_len)
+static size_t
+get_table_index(size_t table_size_index, uint64_t hash)
 {
     assert(table_size_index <= table_size_index_max);
-    return bkdrhash(key, key_len) % table_sizes[table_size_index];
+    return (size_t)hash & (table_sizes[table_size_index] - 1);
+}
+
+/**
+ * New table.
+ */
+static dict_node_t **
+dict_table_new(size_t table_size_index)
+{
+    size_t table_size = table_sizes[table_size_index];
+    dict_node_t **table = malloc(table_size * sizeof(dict_node_t *));
+
+    if (table != NULL) {
+        size_t index;
+
+        for (index = 0; index < table_size; index++)
+            table[index] = NULL;
+    }
+    return table;
 }
 
 /**
- * New node.
+ * New node (from the dict's pool).
  */
 dict_node_t *
-dict_node_new(uint8_t *key, size_t key_len, void *val)
+dict_node_new(dict_t *dict, uint8_t *key, size_t key_len, uint64_t hash,
+        void *val)
 {
-    dict_node_t *node = malloc(sizeof(dict_node_t));
+    dict_node_t *node = pool_alloc(dict->pool);
 
     if (node != NULL) {
         node->key = key;
         node->key_len = key_len;
+        node->hash = hash;
         node->val = val;
         node->next = NULL;
     }
@@ -95,74 +119,364 @@ dict_node_new(uint8_t *key, size_t key_len, void *val)
  * Free node.
  */
 void
-dict_node_free(dict_node_t *node)
+dict_node_free(dict_t *dict, dict_node_t *node)
 {
     if (node != NULL)
-        free(node);
+        pool_dealloc(dict->pool, node);
 }
 
 /**
- * Resize && Rehash
+ * Get the smallest table size index holding `size` nodes under the load
+ * limit.
  */
-int
-dict_resize(dict_t *dict)
+static size_t
+dict_table_size_index_for(size_t size)
+{
+    size_t table_size_index = 0;
+
+    while (table_size_index < table_size_index_max &&
+            table_sizes[table_size_index] * DICT_LOAD_LIMIT < size)
+        table_size_index++;
+    return table_size_index;
+}
+
+/**
+ * Get the monotonic clock in nanoseconds.
+ */
+static uint64_t
+dict_clock_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Start resizing (growing or shrinking) to a table size index, the nodes
+ * are moved to the new table by `dict_rehash` bucket by bucket later. The
+ * clock is read here and when the last bucket is moved, not per step.
+ */
+static int
+dict_resize(dict_t *dict, size_t new_table_size_index)
 {
     assert(dict != NULL &&
             dict->table_size_index <= table_size_index_max);
-
-    size_t new_table_size_index = dict->table_size_index + 1;
+    assert(dict->rehash_table == NULL);
 
     if (new_table_size_index > table_size_index_max)
         return DICT_ENOMEM;
 
-    // new empty table
-    size_t new_table_size = table_sizes[new_table_size_index];
-    dict_node_t **new_table = malloc(new_table_size *
-            sizeof(dict_node_t *));
+    dict_node_t **new_table = dict_table_new(new_table_size_index);
 
-    size_t index;
+    if (new_table == NULL)
+        return DICT_ENOMEM;
 
-    for (index = 0; index < new_table_size; index++)
-        new_table[index] = NULL;
+    dict->rehash_table = dict->table;
+    dict->rehash_table_size_index = dict->table_size_index;
+    dict->rehash_index = 0;
+    dict->table = new_table;
+    dict->table_size_index = new_table_size_index;
+    dict->resizes += 1;
+    dict->rehash_start_ns = dict_clock_ns();
+    return DICT_OK;
+}
 
-    size_t table_size = table_sizes[dict->table_size_index];
+/**
+ * Move at most `n` buckets from the old table to the new table, nodes are
+ * relinked (not reallocated). Returns true if there are still buckets to
+ * rehash.
+ */
+static bool
+dict_rehash_buckets(dict_t *dict, size_t n)
+{
+    size_t rehash_table_size = table_sizes[dict->rehash_table_size_index];
+    size_t empty_visits = n * 10;  // max empty buckets to skip
 
-    // for each bucket in table
-    for (index = 0; index < table_size; index++) {
-        // for each node in this bucket
-        dict_node_t *node = (dict->table)[index];
+    while (n > 0 && dict->rehash_index < rehash_table_size) {
+        dict_node_t *node = (dict->rehash_table)[dict->rehash_index];
+
+        if (node == NULL) {
+            dict->rehash_index++;
+            if (--empty_visits == 0)
+                break;
+            continue;
+        }
 
+        // move each node in this bucket to the head of new bucket
         while (node != NULL) {
-            dict_node_t *new_node = dict_node_new(node->key,
-                    node->key_len, node->val);
+            dict_node_t *next_node = node->next;
+            size_t index = get_table_index(dict->table_size_index,
+                    node->hash);
+            node->next = (dict->table)[index];
+            (dict->table)[index] = node;
+            node = next_node;
+        }
 
-            if (new_node == NULL)
-                return DICT_ENOMEM;
+        (dict->rehash_table)[dict->rehash_index++] = NULL;
+        n--;
+    }
 
-            size_t new_index = get_table_index(
-                    new_table_size_index, new_node->key, new_node->key_len);
-            dict_node_t *cursor = new_table[new_index];
-
-            if (cursor == NULL)
-                // set head node
-                new_table[new_index] = new_node;
-            else {
-                while (cursor->next != NULL)
-                    cursor = cursor->next;
-                // set tail node
-                cursor->next = new_node;
-            }
+    if (dict->rehash_index < rehash_table_size)
+        return true;
 
-            dict_node_t *next_node = node->next;
-            dict_node_free(node);
-            node = next_node;
+    free(dict->rehash_table);
+    dict->rehash_table = NULL;
+    dict->rehash_table_size_index = 0;
+    dict->rehash_index = 0;
+    dict->rehash_ns += dict_clock_ns() - dict->rehash_start_ns;
+    return false;
+}
+
+/**
+ * Rehash at most `n` buckets, on top of the incremental steps. Returns
+ * true if there are still buckets to rehash. Nothing is rehashed while
+ * paused by iterators or a snapshot (returns false), they walk the tables
+ * as they are.
+ */
+bool
+dict_rehash(dict_t *dict, size_t n)
+{
+    assert(dict != NULL);
+
+    if (dict->rehash_table == NULL || dict->rehash_paused > 0)
+        return false;
+    return dict_rehash_buckets(dict, n);
+}
+
+/**
+ * Rehash a step if rehashing and not paused.
+ */
+static void
+dict_rehash_step(dict_t *dict)
+{
+    if (dict->rehash_table != NULL && dict->rehash_paused == 0)
+        dict_rehash_buckets(dict, DICT_REHASH_STEP);
+}
+
+/**
+ * Find the link (bucket head or previous node's next) to a key's node in a
+ * chain, returns NULL if not found. The cached hash and the key length are
+ * compared before the key bytes.
+ */
+static dict_node_t **
+dict_chain_find(dict_node_t **link, uint8_t *key, size_t key_len,
+        uint64_t hash)
+{
+    for (; *link != NULL; link = &(*link)->next) {
+        dict_node_t *node = *link;
+
+        if (node->hash == hash && node->key_len == key_len &&
+                memcmp(node->key, key, key_len) == 0)
+            return link;
+    }
+    return NULL;
+}
+
+/**
+ * Find the link to a key's node, the old table is also looked up if the
+ * key's bucket there is not rehashed yet. Returns NULL if not found.
+ */
+static dict_node_t **
+dict_find(dict_t *dict, uint8_t *key, size_t key_len, uint64_t hash)
+{
+    if (dict->rehash_table != NULL) {
+        size_t index = get_table_index(dict->rehash_table_size_index, hash);
+
+        if (index >= dict->rehash_index) {
+            dict_node_t **link = dict_chain_find(
+                    &(dict->rehash_table)[index], key, key_len, hash);
+
+            if (link != NULL)
+                return link;
         }
     }
+    return dict_chain_find(&(dict->table)[get_table_index(
+                dict->table_size_index, hash)], key, key_len, hash);
+}
 
-    free(dict->table);
+/**
+ * Copy a key into the dict's arena, returns NULL on no memory.
+ */
+static uint8_t *
+dict_key_copy(dict_t *dict, uint8_t *key, size_t key_len)
+{
+    uint8_t *copy = arena_alloc(dict->arena, key_len);
 
-    dict->table = new_table;
-    dict->table_size_index = new_table_size_index;
+    if (copy != NULL)
+        memcpy(copy, key, key_len);
+    return copy;
+}
+
+/**
+ * Store an owned key for a node: inline after the node if short enough,
+ * else in the arena (copied unless `key` already is an arena copy).
+ */
+static bool
+dict_node_own_key(dict_t *dict, dict_node_t *node, uint8_t *key,
+        bool copied)
+{
+    if (node->key_len <= DICT_KEY_INLINE) {
+        node->key = (uint8_t *)(node + 1);
+        memcpy(node->key, key, node->key_len);
+        return true;
+    }
+
+    node->key = copied ? key : dict_key_copy(dict, key, node->key_len);
+    return node->key != NULL;
+}
+
+/**
+ * Copy a bucket's chain if it's shared with the snapshot, so that it can
+ * be written. A bucket is shared while its head is still the one in the
+ * snapshot, the whole chain is copied at once, so a chain is either all
+ * shared or all the dict's own. Tables created after the snapshot are
+ * not shared.
+ */
+static int
+dict_bucket_unshare(dict_t *dict, dict_node_t **table, size_t index)
+{
+    dict_snapshot_t *snapshot = dict->snapshot;
+    dict_node_t *node = table[index];
+    size_t k;
+
+    if (node == NULL)
+        return DICT_OK;
+
+    for (k = 0; k < 2 && snapshot->origins[k] != table; k++);
+
+    if (k == 2 || (snapshot->tables[k])[index] != node)
+        return DICT_OK;
+
+    dict_node_t *head = NULL, **link = &head;
+
+    for (; node != NULL; node = node->next) {
+        dict_node_t *copy = dict_node_new(dict, node->key, node->key_len,
+                node->hash, node->val);
+
+        if (copy == NULL) {
+            while (head != NULL) {
+                copy = head->next;
+                dict_node_free(dict, head);
+                head = copy;
+            }
+            return DICT_ENOMEM;
+        }
+
+        // the shared node's key is either inline or an arena copy
+        if (dict->arena != NULL)
+            dict_node_own_key(dict, copy, node->key, true);
+
+        *link = copy;
+        link = &copy->next;
+    }
+
+    table[index] = head;
+    return DICT_OK;
+}
+
+/**
+ * Unshare the buckets a hash may live in, before writing them.
+ */
+static int
+dict_unshare(dict_t *dict, uint64_t hash)
+{
+    if (dict->rehash_table != NULL) {
+        size_t index = get_table_index(dict->rehash_table_size_index, hash);
+
+        if (index >= dict->rehash_index && dict_bucket_unshare(dict,
+                    dict->rehash_table, index) != DICT_OK)
+            return DICT_ENOMEM;
+    }
+    return dict_bucket_unshare(dict, dict->table, get_table_index(
+                dict->table_size_index, hash));
+}
+
+/**
+ * Hand the dict's nodes pool and keys arena over to its snapshot, before
+ * the dict releases them (clear or free). The dict goes on with no pool
+ * and the snapshot's spare arena, the snapshot no longer refers to it.
+ */
+static void
+dict_snapshot_detach(dict_t *dict)
+{
+    dict_snapshot_t *snapshot = dict->snapshot;
+    arena_t *spare = snapshot->arena;
+
+    snapshot->pool = dict->pool;
+    snapshot->arena = dict->arena;
+    snapshot->dict = NULL;
+    dict->pool = NULL;
+    dict->arena = spare;
+    dict->snapshot = NULL;
+    dict->rehash_paused -= 1;
+}
+
+/**
+ * Find the entry of a key in a small dict, returns NULL if not found. Key
+ * lengths are compared before the key bytes, no hashing.
+ */
+static dict_node_t *
+dict_small_find(dict_t *dict, uint8_t *key, size_t key_len)
+{
+    size_t index;
+
+    for (index = 0; index < dict->size; index++) {
+        dict_node_t *node = &(dict->small)[index];
+
+        if (node->key_len == key_len && memcmp(node->key, key, key_len) == 0)
+            return node;
+    }
+    return NULL;
+}
+
+/**
+ * Promote a small dict to a table, the entries are hashed and moved to
+ * nodes. The dict stays small on no memory.
+ */
+static int
+dict_promote(dict_t *dict)
+{
+    assert(dict->table == NULL);
+
+    // owned keys' nodes have room for inline keys
+    if (dict->pool == NULL)
+        dict->pool = pool_new(sizeof(dict_node_t) +
+                (dict->arena != NULL ? DICT_KEY_INLINE : 0));
+
+    if (dict->pool == NULL)
+        return DICT_ENOMEM;
+
+    size_t table_size_index = dict_table_size_index_for(DICT_SMALL_MAX + 1);
+    dict_node_t **table = dict_table_new(table_size_index);
+
+    if (table == NULL)
+        return DICT_ENOMEM;
+
+    size_t index;
+
+    for (index = 0; index < dict->size; index++) {
+        dict_node_t *small = &(dict->small)[index];
+        uint64_t hash = dict_hash(dict, small->key, small->key_len);
+        dict_node_t *node = dict_node_new(dict, small->key, small->key_len,
+                hash, small->val);
+
+        if (node == NULL) {
+            free(table);
+            pool_clear(dict->pool);
+            return DICT_ENOMEM;
+        }
+
+        if (dict->arena != NULL)
+            dict_node_own_key(dict, node, small->key, true);
+
+        dict_node_t **bucket = &table[get_table_index(table_size_index,
+                hash)];
+        node->next = *bucket;
+        *bucket = node;
+    }
+
+    dict->table = table;
+    dict->table_size_index = table_size_index;
     return DICT_OK;
 }
 
@@ -175,46 +489,58 @@ dict_new()
     dict_t *dict = malloc(sizeof(dict_t));
 
     if (dict != NULL) {
+        dict->size = 0;
         dict->table_size_index = 0;
-
-        size_t table_size = table_sizes[dict->table_size_index];
-        dict->table = malloc(table_size * sizeof(dict_node_t *));
-
-        if (dict->table == NULL)
-            return NULL;
-
-        size_t index;
-
-        for (index = 0; index < table_size; index++)
-            (dict->table)[index] = NULL;
+        dict->rehash_table = NULL;
+        dict->rehash_table_size_index = 0;
+        dict->rehash_index = 0;
+        dict->rehash_paused = 0;
+        dict->hash = &hash_bytes;
+        dict->seed = hash_seed();
+        dict->pool = NULL;
+        dict->arena = NULL;
+        dict->resizes = 0;
+        dict->rehash_ns = 0;
+        dict->rehash_start_ns = 0;
+        dict->snapshot = NULL;
+        dict->table = NULL;
     }
 
     return dict;
 }
 
 /**
- * Clear dict.
+ * Clear dict, nodes are released all at once and the dict becomes small
+ * again, O(slabs). An alive snapshot takes the nodes and keys over and
+ * stays readable.
  */
 void
 dict_clear(dict_t *dict)
 {
     assert(dict != NULL && dict->table_size_index <= table_size_index_max);
 
-    size_t index;
-    size_t table_size = table_sizes[dict->table_size_index];
-
-    for (index = 0; index < table_size; index++) {
-        dict_node_t *node = (dict->table)[index];
+    if (dict->snapshot != NULL)
+        dict_snapshot_detach(dict);
 
-        while (node != NULL) {
-            dict_node_t *next_node = node->next;
-            dict_node_free(node);
-            dict->size -= 1;
-            node = next_node;
-        }
+    if (dict->rehash_table != NULL) {
+        free(dict->rehash_table);
+        dict->rehash_table = NULL;
+        dict->rehash_table_size_index = 0;
+        dict->rehash_index = 0;
+    }
 
-        (dict->table)[index] = NULL;
+    if (dict->table != NULL) {
+        free(dict->table);
+        dict->table = NULL;
+        dict->table_size_index = 0;
+        if (dict->pool != NULL)
+            pool_clear(dict->pool);
     }
+
+    if (dict->arena != NULL)
+        arena_clear(dict->arena);
+
+    dict->size = 0;
 }
 
 /**
@@ -222,12 +548,17 @@ dict_clear(dict_t *dict)
  */
 void dict_free(dict_t *dict)
 {
-    dict_clear(dict);
-
-    if (dict->table != NULL)
-        free(dict->table);
-    if (dict != NULL)
+    if (dict != NULL) {
+        if (dict->snapshot != NULL)
+            dict_snapshot_detach(dict);
+        if (dict->rehash_table != NULL)
+            free(dict->rehash_table);
+        if (dict->table != NULL)
+            free(dict->table);
+        pool_free(dict->pool);
+        arena_free(dict->arena);
         free(dict);
+    }
 }
 
 /**
@@ -238,41 +569,89 @@ dict_set(dict_t *dict, uint8_t *key, size_t key_len, void *val)
 {
     assert(dict != NULL);
 
-    if ((table_sizes[dict->table_size_index] * DICT_LOAD_LIMIT < dict->size) &&
-            dict_resize(dict) != DICT_OK)
-        return DICT_ENOMEM;
+    // small dicts are not hashed until promoted
+    if (dict->table == NULL && (dict->size < DICT_SMALL_MAX ||
+                dict_small_find(dict, key, key_len) != NULL))
+        return dict_set_hashed(dict, key, key_len, 0, val);
+    return dict_set_hashed(dict, key, key_len, dict_hash(dict, key, key_len),
+            val);
+}
+
+/**
+ * Set a key to dict with its hash (by `dict_hash`) given.
+ */
+int
+dict_set_hashed(dict_t *dict, uint8_t *key, size_t key_len, uint64_t hash,
+        void *val)
+{
+    assert(dict != NULL);
 
-    size_t index = get_table_index(dict->table_size_index, key, key_len);
-    dict_node_t *node = (dict->table)[index];
+    if (dict->table == NULL) {
+        dict_node_t *node = dict_small_find(dict, key, key_len);
 
-    // try to find this key
-    while (node != NULL) {
-        if (memcmp(node->key, key, key_len) == 0) {
+        if (node != NULL) {
+            if (dict->arena == NULL)
+                node->key = key;
+            node->val = val;
+            return DICT_OK;
+        }
+
+        // the hash is not used (recomputed on promotion)
+        if (dict->size < DICT_SMALL_MAX) {
+            if (dict->arena != NULL &&
+                    (key = dict_key_copy(dict, key, key_len)) == NULL)
+                return DICT_ENOMEM;
+
+            node = &(dict->small)[dict->size++];
             node->key = key;
             node->key_len = key_len;
+            node->hash = hash;
             node->val = val;
+            node->next = NULL;
             return DICT_OK;
         }
-        node = node->next;
+
+        if (dict_promote(dict) != DICT_OK)
+            return DICT_ENOMEM;
     }
 
-    // new node if not found
-    dict_node_t *new_node = dict_node_new(key, key_len, val);
+    if (dict->rehash_table == NULL && dict->rehash_paused == 0 &&
+            (table_sizes[dict->table_size_index] * DICT_LOAD_LIMIT <
+             dict->size) &&
+            dict_resize(dict, dict->table_size_index + 1) != DICT_OK)
+        return DICT_ENOMEM;
+
+    dict_rehash_step(dict);
 
-    if (new_node == NULL)
+    if (dict->snapshot != NULL && dict_unshare(dict, hash) != DICT_OK)
         return DICT_ENOMEM;
 
-    node = (dict->table)[index]; // rewind to head
+    dict_node_t **link = dict_find(dict, key, key_len, hash);
 
-    if (node == NULL) {
-        // if head node is empty
-        (dict->table)[index] = new_node;
-    } else {
-        // append new node to tail
-        while (node->next != NULL)
-            node = node->next;
-        node->next = new_node;
+    if (link != NULL) {
+        dict_node_t *node = *link;
+        if (dict->arena == NULL)
+            node->key = key;
+        node->val = val;
+        return DICT_OK;
     }
+
+    // new node if not found
+    dict_node_t *node = dict_node_new(dict, key, key_len, hash, val);
+
+    if (node == NULL)
+        return DICT_ENOMEM;
+
+    if (dict->arena != NULL && !dict_node_own_key(dict, node, key, false)) {
+        dict_node_free(dict, node);
+        return DICT_ENOMEM;
+    }
+
+    // new nodes always go to the head of the new table's bucket
+    dict_node_t **bucket = &(dict->table)[get_table_index(
+            dict->table_size_index, hash)];
+    node->next = *bucket;
+    *bucket = node;
     dict->size += 1;
     return DICT_OK;
 }
@@ -285,16 +664,18 @@ dict_get(dict_t *dict, uint8_t *key, size_t key_len)
 {
     assert(dict != NULL);
 
-    size_t index = get_table_index(dict->table_size_index, key, key_len);
-    dict_node_t *node = (dict->table)[index];
+    dict_node_t *node;
 
-    while (node != NULL) {
-        if (memcmp(node->key, key, key_len) == 0)
-            return node->val;
-        node = node->next;
+    if (dict->table == NULL) {
+        node = dict_small_find(dict, key, key_len);
+    } else {
+        dict_rehash_step(dict);
+        node = dict_lookup(dict, key, key_len, dict_hash(dict, key, key_len));
     }
 
-    return NULL;
+    if (node == NULL)
+        return NULL;
+    return node->val;
 }
 
 /**
@@ -305,16 +686,159 @@ dict_has(dict_t *dict, uint8_t *key, size_t key_len)
 {
     assert(dict != NULL);
 
-    size_t index = get_table_index(dict->table_size_index, key, key_len);
-    dict_node_t *node = (dict->table)[index];
+    if (dict->table == NULL)
+        return dict_small_find(dict, key, key_len) != NULL;
 
-    while (node != NULL) {
-        if (memcmp(node->key, key, key_len) == 0)
-            return true;
-        node = node->next;
+    dict_rehash_step(dict);
+
+    return dict_lookup(dict, key, key_len,
+            dict_hash(dict, key, key_len)) != NULL;
+}
+
+/**
+ * Lookup the node of a key with its hash given, returns NULL if not found.
+ * Unlike `dict_get`, it never rehashes, so the dict is not modified. The
+ * hash is not used by small dicts.
+ */
+dict_node_t *
+dict_lookup(dict_t *dict, uint8_t *key, size_t key_len, uint64_t hash)
+{
+    assert(dict != NULL);
+
+    if (dict->table == NULL)
+        return dict_small_find(dict, key, key_len);
+
+    dict_node_t **link = dict_find(dict, key, key_len, hash);
+
+    if (link == NULL)
+        return NULL;
+    return *link;
+}
+
+/**
+ * Prefetch the buckets a hash may live in.
+ */
+static void
+dict_prefetch_buckets(dict_t *dict, uint64_t hash)
+{
+    if (dict->rehash_table != NULL) {
+        size_t index = get_table_index(dict->rehash_table_size_index, hash);
+
+        if (index >= dict->rehash_index)
+            DICT_PREFETCH(&(dict->rehash_table)[index]);
     }
+    DICT_PREFETCH(&(dict->table)[get_table_index(dict->table_size_index,
+                hash)]);
+}
 
-    return false;
+/**
+ * Prefetch the head nodes of the buckets a hash may live in.
+ */
+static void
+dict_prefetch_nodes(dict_t *dict, uint64_t hash)
+{
+    if (dict->rehash_table != NULL) {
+        size_t index = get_table_index(dict->rehash_table_size_index, hash);
+
+        if (index >= dict->rehash_index &&
+                (dict->rehash_table)[index] != NULL)
+            DICT_PREFETCH((dict->rehash_table)[index]);
+    }
+
+    dict_node_t *node = (dict->table)[get_table_index(
+            dict->table_size_index, hash)];
+
+    if (node != NULL)
+        DICT_PREFETCH(node);
+}
+
+/**
+ * Get vals of `n` keys, vals of keys not found are set to NULL. Keys are
+ * resolved DICT_BATCH_SIZE at a time: hash all, prefetch buckets, prefetch
+ * nodes, then lookup, so the cache misses of a batch overlap.
+ */
+void
+dict_get_many(dict_t *dict, uint8_t **keys, size_t *key_lens, void **vals,
+        size_t n)
+{
+    assert(dict != NULL);
+
+    uint64_t hashes[DICT_BATCH_SIZE];
+    size_t start, i;
+
+    if (dict->table == NULL) {
+        for (i = 0; i < n; i++) {
+            dict_node_t *node = dict_small_find(dict, keys[i], key_lens[i]);
+            vals[i] = node != NULL ? node->val : NULL;
+        }
+        return;
+    }
+
+    dict_rehash_step(dict);
+
+    for (start = 0; start < n; start += DICT_BATCH_SIZE) {
+        size_t m = n - start < DICT_BATCH_SIZE ? n - start : DICT_BATCH_SIZE;
+
+        for (i = 0; i < m; i++) {
+            hashes[i] = dict_hash(dict, keys[start + i],
+                    key_lens[start + i]);
+            dict_prefetch_buckets(dict, hashes[i]);
+        }
+
+        for (i = 0; i < m; i++)
+            dict_prefetch_nodes(dict, hashes[i]);
+
+        for (i = 0; i < m; i++) {
+            dict_node_t *node = dict_lookup(dict, keys[start + i],
+                    key_lens[start + i], hashes[i]);
+            vals[start + i] = node != NULL ? node->val : NULL;
+        }
+    }
+}
+
+/**
+ * Set `n` keys, batched and prefetched like `dict_get_many`. Stops at the
+ * first error.
+ */
+int
+dict_set_many(dict_t *dict, uint8_t **keys, size_t *key_lens, void **vals,
+        size_t n)
+{
+    assert(dict != NULL);
+
+    uint64_t hashes[DICT_BATCH_SIZE];
+    size_t start = 0, i;
+
+    // small dicts are filled key by key until promoted
+    for (; start < n && dict->table == NULL; start++) {
+        int result = dict_set(dict, keys[start], key_lens[start],
+                vals[start]);
+
+        if (result != DICT_OK)
+            return result;
+    }
+
+    for (; start < n; start += DICT_BATCH_SIZE) {
+        size_t m = n - start < DICT_BATCH_SIZE ? n - start : DICT_BATCH_SIZE;
+
+        for (i = 0; i < m; i++) {
+            hashes[i] = dict_hash(dict, keys[start + i],
+                    key_lens[start + i]);
+            dict_prefetch_buckets(dict, hashes[i]);
+        }
+
+        for (i = 0; i < m; i++)
+            dict_prefetch_nodes(dict, hashes[i]);
+
+        for (i = 0; i < m; i++) {
+            int result = dict_set_hashed(dict, keys[start + i],
+                    key_lens[start + i], hashes[i], vals[start + i]);
+
+            if (result != DICT_OK)
+                return result;
+        }
+    }
+    return DICT_OK;
 }
 
 /**
@@ -325,27 +849,223 @@ dict_del(dict_t *dict, uint8_t *key, size_t key_len)
 {
     assert(dict != NULL);
 
-    size_t index = get_table_index(dict->table_size_index, key, key_len);
-    dict_node_t *node = (dict->table)[index];
-    dict_node_t *prev = NULL;
+    if (dict->table == NULL)
+        return dict_del_hashed(dict, key, key_len, 0);
+    return dict_del_hashed(dict, key, key_len, dict_hash(dict, key, key_len));
+}
 
-    while (node != NULL) {
-        if (memcmp(node->key, key, key_len) == 0) {
-            if (prev == NULL)
-                // if the first node
-                (dict->table)[index] = node->next;
-            else
-                prev->next = node->next;
-            free(node);
-            dict->size -= 1;
+/**
+ * Del val from dict by key with its hash given. May fail on no memory
+ * while a snapshot is alive (the key's bucket is copied first).
+ */
+int
+dict_del_hashed(dict_t *dict, uint8_t *key, size_t key_len, uint64_t hash)
+{
+    assert(dict != NULL);
+
+    if (dict->table == NULL) {
+        dict_node_t *node = dict_small_find(dict, key, key_len);
+
+        if (node == NULL)
+            return DICT_ENOTFOUND;
+
+        // keep the order, entries after it shift down
+        size_t index = node - dict->small;
+        memmove(node, node + 1, (dict->size - index - 1) *
+                sizeof(dict_node_t));
+        dict->size -= 1;
+        return DICT_OK;
+    }
+
+    dict_rehash_step(dict);
+
+    if (dict->snapshot != NULL && dict_unshare(dict, hash) != DICT_OK)
+        return DICT_ENOMEM;
+
+    dict_node_t **link = dict_find(dict, key, key_len, hash);
+
+    if (link == NULL)
+        return DICT_ENOTFOUND;
+
+    dict_node_t *node = *link;
+    *link = node->next;
+    dict_node_free(dict, node);
+    dict->size -= 1;
+
+    // shrink (to load below half the limit) if too sparse, a failed
+    // allocation just keeps the larger table
+    if (dict->rehash_table == NULL && dict->rehash_paused == 0 &&
+            dict->table_size_index > 0 &&
+            dict->size < table_sizes[dict->table_size_index] *
+            DICT_SHRINK_LIMIT)
+        dict_resize(dict, dict_table_size_index_for(dict->size * 2));
+    return DICT_OK;
+}
+
+/**
+ * Make room for at least `n` keys without growing, the table is resized
+ * at most once (incrementally). A no-op while iterators are alive.
+ */
+int
+dict_reserve(dict_t *dict, size_t n)
+{
+    assert(dict != NULL);
+
+    if (dict->rehash_paused > 0)
+        return DICT_OK;
+
+    if (dict->table == NULL) {
+        if (n <= DICT_SMALL_MAX)
             return DICT_OK;
+        if (dict_promote(dict) != DICT_OK)
+            return DICT_ENOMEM;
+    }
+
+    size_t table_size_index = dict_table_size_index_for(n);
+
+    if (table_size_index <= dict->table_size_index)
+        return DICT_OK;
+
+    while (dict_rehash(dict, 1024));
+    return dict_resize(dict, table_size_index);
+}
+
+/**
+ * Reverse the bits of a cursor.
+ */
+static size_t
+rev(size_t v)
+{
+    size_t s = 8 * sizeof(v);
+    size_t mask = ~(size_t)0;
+
+    while ((s >>= 1) > 0) {
+        mask ^= (mask << s);
+        v = ((v >> s) & mask) | ((v << s) & ~mask);
+    }
+    return v;
+}
+
+/**
+ * Call `func` on each node of a bucket, the next node is fetched before the
+ * call so that `func` may delete the visited key.
+ */
+static void
+dict_scan_bucket(dict_node_t *node, dict_scan_func_t func, void *data)
+{
+    while (node != NULL) {
+        dict_node_t *next_node = node->next;
+        func(node->key, node->key_len, node->val, data);
+        node = next_node;
+    }
+}
+
+/**
+ * Scan the dict a bucket (of the smaller table) at a time, start with cursor
+ * 0 and call again with the returned cursor until it returns 0.
+ *
+ * The cursor is increased from its high bits (reverse binary), so buckets
+ * already visited stay visited when the table grows or shrinks between
+ * calls: every key present during the whole scan is returned at least
+ * once (maybe more). `func` may delete the key it visits, but not others.
+ */
+size_t
+dict_scan(dict_t *dict, size_t cursor, dict_scan_func_t func, void *data)
+{
+    assert(dict != NULL && func != NULL);
+
+    if (dict->size == 0)
+        return 0;
+
+    // small dicts are scanned in one call, backwards so that deleting the
+    // visited key doesn't shift unvisited ones
+    if (dict->table == NULL) {
+        size_t index;
+
+        for (index = dict->size; index > 0; index--) {
+            dict_node_t *node = &(dict->small)[index - 1];
+            func(node->key, node->key_len, node->val, data);
         }
+        return 0;
+    }
+
+    dict->rehash_paused += 1;
+
+    if (dict->rehash_table == NULL) {
+        size_t mask = table_sizes[dict->table_size_index] - 1;
+
+        dict_scan_bucket((dict->table)[cursor & mask], func, data);
+
+        // increase the reversed cursor
+        cursor |= ~mask;
+        cursor = rev(cursor);
+        cursor++;
+        cursor = rev(cursor);
+    } else {
+        dict_node_t **t0 = dict->rehash_table;
+        dict_node_t **t1 = dict->table;
+        size_t m0 = table_sizes[dict->rehash_table_size_index] - 1;
+        size_t m1 = table_sizes[dict->table_size_index] - 1;
+
+        // make t0 the smaller table
+        if (m0 > m1) {
+            dict_node_t **t = t0;
+            size_t m = m0;
+            t0 = t1;
+            t1 = t;
+            m0 = m1;
+            m1 = m;
+        }
+
+        dict_scan_bucket(t0[cursor & m0], func, data);
 
-        prev = node;
-        node = node->next;
+        // all buckets in the larger table expanded from the cursor
+        do {
+            dict_scan_bucket(t1[cursor & m1], func, data);
+            cursor |= ~m1;
+            cursor = rev(cursor);
+            cursor++;
+            cursor = rev(cursor);
+        } while (cursor & (m0 ^ m1));
     }
 
-    return DICT_ENOTFOUND;
+    dict->rehash_paused -= 1;
+    return cursor;
+}
+
+/**
+ * Use a hash function for an empty dict.
+ */
+void
+dict_use_hash(dict_t *dict, hash_func_t hash)
+{
+    assert(dict != NULL && hash != NULL && dict->size == 0);
+    dict->hash = hash;
+}
+
+/**
+ * Have an empty dict copy the keys it stores, keys are released on
+ * `dict_clear`/`dict_free` all at once (keys deleted or replaced before
+ * that keep their arena memory until then).
+ */
+int
+dict_own_keys(dict_t *dict)
+{
+    assert(dict != NULL && dict->size == 0);
+
+    if (dict->arena != NULL)
+        return DICT_OK;
+
+    dict->arena = arena_new();
+
+    if (dict->arena == NULL)
+        return DICT_ENOMEM;
+
+    // nodes are allocated larger from now on
+    dict_clear(dict);
+    pool_free(dict->pool);
+    dict->pool = NULL;
+    return DICT_OK;
 }
 
 /**
@@ -359,7 +1079,88 @@ dict_size(dict_t *dict)
 }
 
 /**
- * New dict iterator.
+ * Get the buckets number of the dict's table, 0 if small.
+ */
+size_t
+dict_table_size(dict_t *dict)
+{
+    assert(dict != NULL);
+
+    if (dict->table == NULL)
+        return 0;
+    return table_sizes[dict->table_size_index];
+}
+
+/**
+ * Add the chains of a table to stats.
+ */
+static void
+dict_stats_table(dict_node_t **table, size_t table_size, size_t from,
+        dict_stats_t *stats, size_t *chains_used)
+{
+    size_t index;
+
+    for (index = from; index < table_size; index++) {
+        dict_node_t *node = table[index];
+        size_t len = 0;
+
+        for (; node != NULL; node = node->next)
+            len++;
+
+        if (len > 0)
+            *chains_used += 1;
+        if (len > stats->chain_max)
+            stats->chain_max = len;
+        stats->chains[len < DICT_STATS_CHAINS ? len :
+            DICT_STATS_CHAINS - 1] += 1;
+    }
+}
+
+/**
+ * Get dict stats, O(buckets). Buckets already rehashed in the old table
+ * are not counted.
+ */
+void
+dict_stats(dict_t *dict, dict_stats_t *stats)
+{
+    assert(dict != NULL && stats != NULL);
+
+    size_t chains_used = 0;
+
+    memset(stats, 0, sizeof(dict_stats_t));
+    stats->size = dict->size;
+    stats->resizes = dict->resizes;
+    stats->rehash_ns = dict->rehash_ns;
+
+    if (dict->pool != NULL)
+        stats->node_bytes = dict->pool->cap;
+    if (dict->arena != NULL)
+        stats->key_bytes = dict->arena->cap;
+
+    if (dict->table == NULL)
+        return;
+
+    stats->table_size = table_sizes[dict->table_size_index];
+    dict_stats_table(dict->table, stats->table_size, 0, stats,
+            &chains_used);
+
+    if (dict->rehash_table != NULL) {
+        stats->rehash_table_size = table_sizes[
+            dict->rehash_table_size_index];
+        dict_stats_table(dict->rehash_table, stats->rehash_table_size,
+                dict->rehash_index, stats, &chains_used);
+    }
+
+    stats->load = (double)dict->size / stats->table_size;
+    stats->table_bytes = (stats->table_size + stats->rehash_table_size) *
+        sizeof(dict_node_t *);
+
+    if (chains_used > 0)
+        stats->chain_avg = (double)dict->size / chains_used;
+}
+
+/**
+ * New dict iterator, rehashing is paused until the iterator is freed.
  */
 dict_iterator_t *
 dict_iterator_new(dict_t *dict)
@@ -369,9 +1170,9 @@ dict_iterator_new(dict_t *dict)
     dict_iterator_t *iterator = malloc(sizeof(dict_iterator_t));
 
     if (iterator != NULL) {
-        iterator->node = NULL;
-        iterator->index = 0;
         iterator->dict = dict;
+        dict->rehash_paused += 1;
+        dict_iterator_reset(iterator);
     }
     return iterator;
 }
@@ -382,8 +1183,11 @@ dict_iterator_new(dict_t *dict)
 void
 dict_iterator_free(dict_iterator_t *iterator)
 {
-    if (iterator != NULL)
+    if (iterator != NULL) {
+        assert(iterator->dict->rehash_paused > 0);
+        iterator->dict->rehash_paused -= 1;
         free(iterator);
+    }
 }
 
 /**
@@ -393,17 +1197,34 @@ int
 dict_iterator_next(dict_iterator_t *iterator, uint8_t **key_addr, \
         size_t *key_len_addr, void **val_addr)
 {
-    assert(iterator != NULL && iterator->dict != NULL &&
-            iterator->dict->table != NULL &&
-            iterator->dict->table_size_index <= table_size_index_max);
+    assert(iterator != NULL && iterator->dict != NULL);
+
+    dict_t *dict = iterator->dict;
 
-    size_t table_size = table_sizes[iterator->dict->table_size_index];
+    // small dict entries are walked backwards, like dict_scan
+    if (iterator->table == NULL) {
+        if (iterator->index == 0)
+            return DICT_ENOTFOUND;
+
+        dict_node_t *node = &(dict->small)[--iterator->index];
+        *key_addr = node->key;
+        *key_len_addr = node->key_len;
+        *val_addr = node->val;
+        return DICT_OK;
+    }
 
     // seek to a Non-NULL node
     while(iterator->node == NULL) {
-        if (iterator->index == table_size)
-            return DICT_ENOTFOUND;
-        iterator->node = (iterator->dict->table)[iterator->index++];
+        if (iterator->index == iterator->table_size) {
+            if (iterator->table == dict->table)
+                return DICT_ENOTFOUND;
+            // old table done, walk the new table
+            iterator->table = dict->table;
+            iterator->table_size = table_sizes[dict->table_size_index];
+            iterator->index = 0;
+            continue;
+        }
+        iterator->node = (iterator->table)[iterator->index++];
     }
 
     // fetch data
@@ -423,8 +1244,208 @@ dict_iterator_next(dict_iterator_t *iterator, uint8_t **key_addr, \
 void
 dict_iterator_reset(dict_iterator_t *iterator)
 {
-    assert(iterator != NULL);
+    assert(iterator != NULL && iterator->dict != NULL);
+
+    dict_t *dict = iterator->dict;
+
+    if (dict->table == NULL) {
+        iterator->table = NULL;
+        iterator->table_size = 0;
+        iterator->node = NULL;
+        iterator->index = dict->size;
+        return;
+    }
+
+    if (dict->rehash_table != NULL) {
+        iterator->table = dict->rehash_table;
+        iterator->table_size = table_sizes[dict->rehash_table_size_index];
+    } else {
+        iterator->table = dict->table;
+        iterator->table_size = table_sizes[dict->table_size_index];
+    }
 
     iterator->node = NULL;
     iterator->index = 0;
 }
+
+/**
+ * Copy a table's bucket heads into a snapshot.
+ */
+static bool
+dict_snapshot_table(dict_snapshot_t *snapshot, size_t k,
+        dict_node_t **table, size_t table_size_index)
+{
+    size_t table_size = table_sizes[table_size_index];
+
+    (snapshot->tables)[k] = malloc(table_size * sizeof(dict_node_t *));
+
+    if ((snapshot->tables)[k] == NULL)
+        return false;
+
+    memcpy((snapshot->tables)[k], table, table_size *
+            sizeof(dict_node_t *));
+    (snapshot->origins)[k] = table;
+    (snapshot->sizes)[k] = table_size;
+    return true;
+}
+
+/**
+ * New snapshot of the dict's keys and vals as they are now, O(buckets), no
+ * node or key is copied. At most one snapshot is alive per dict.
+ *
+ * The snapshot may be read by another thread while the dict is used (only
+ * by the dict's API: nodes got by `dict_lookup` must not be written), the
+ * keys not owned by the dict must stay valid. Writes copy the chain of the
+ * buckets they touch on first use, and the table doesn't resize until the
+ * snapshot is freed.
+ */
+dict_snapshot_t *
+dict_snapshot_new(dict_t *dict)
+{
+    assert(dict != NULL && dict->snapshot == NULL);
+
+    dict_snapshot_t *snapshot = malloc(sizeof(dict_snapshot_t));
+
+    if (snapshot == NULL)
+        return NULL;
+
+    snapshot->dict = dict;
+    snapshot->size = dict->size;
+    snapshot->pool = NULL;
+    snapshot->arena = NULL;
+    snapshot->tables[0] = NULL;
+    snapshot->tables[1] = NULL;
+    snapshot->origins[0] = NULL;
+    snapshot->origins[1] = NULL;
+    snapshot->sizes[0] = 0;
+    snapshot->sizes[1] = 0;
+
+    // the dict needs a new arena if its keys go to the snapshot on clear,
+    // get it now so that clearing can't fail
+    if (dict->arena != NULL && (snapshot->arena = arena_new()) == NULL)
+        goto fail;
+
+    if (dict->table == NULL) {
+        memcpy(snapshot->small, dict->small, dict->size *
+                sizeof(dict_node_t));
+    } else if (!dict_snapshot_table(snapshot, 0, dict->table,
+                dict->table_size_index) || (dict->rehash_table != NULL &&
+                !dict_snapshot_table(snapshot, 1, dict->rehash_table,
+                    dict->rehash_table_size_index))) {
+        goto fail;
+    }
+
+    dict->snapshot = snapshot;
+    dict->rehash_paused += 1;
+    dict_snapshot_reset(snapshot);
+    return snapshot;
+fail:
+    free(snapshot->tables[0]);
+    arena_free(snapshot->arena);
+    free(snapshot);
+    return NULL;
+}
+
+/**
+ * Free a snapshot, in the dict's thread unless the dict was cleared or
+ * freed since (then the snapshot frees the nodes and keys it took over).
+ * Chains the dict copied are released, O(buckets).
+ */
+void
+dict_snapshot_free(dict_snapshot_t *snapshot)
+{
+    if (snapshot == NULL)
+        return;
+
+    dict_t *dict = snapshot->dict;
+    size_t k, index;
+
+    if (dict != NULL) {
+        assert(dict->snapshot == snapshot && dict->rehash_paused > 0);
+
+        for (k = 0; k < 2; k++) {
+            for (index = 0; index < (snapshot->sizes)[k]; index++) {
+                dict_node_t *node = (snapshot->tables)[k][index];
+
+                // copied by the dict, only the snapshot refers to it
+                if (node == (snapshot->origins)[k][index])
+                    continue;
+
+                while (node != NULL) {
+                    dict_node_t *next_node = node->next;
+                    dict_node_free(dict, node);
+                    node = next_node;
+                }
+            }
+        }
+
+        dict->snapshot = NULL;
+        dict->rehash_paused -= 1;
+    }
+
+    free(snapshot->tables[0]);
+    free(snapshot->tables[1]);
+    pool_free(snapshot->pool);
+    arena_free(snapshot->arena);
+    free(snapshot);
+}
+
+/**
+ * Get snapshot size (keys number when taken).
+ */
+size_t
+dict_snapshot_size(dict_snapshot_t *snapshot)
+{
+    assert(snapshot != NULL);
+    return snapshot->size;
+}
+
+/**
+ * Get next key and val of a snapshot, returns DICT_ENOTFOUND at the end.
+ */
+int
+dict_snapshot_next(dict_snapshot_t *snapshot, uint8_t **key_addr,
+        size_t *key_len_addr, void **val_addr)
+{
+    assert(snapshot != NULL);
+
+    dict_node_t *node;
+
+    if (snapshot->sizes[0] == 0) {
+        if (snapshot->index == 0)
+            return DICT_ENOTFOUND;
+        node = &(snapshot->small)[--snapshot->index];
+    } else {
+        while (snapshot->node == NULL) {
+            if (snapshot->index == (snapshot->sizes)[snapshot->table]) {
+                if (snapshot->table == 1 || snapshot->sizes[1] == 0)
+                    return DICT_ENOTFOUND;
+                snapshot->table = 1;
+                snapshot->index = 0;
+                continue;
+            }
+            snapshot->node = (snapshot->tables)[snapshot->table][
+                snapshot->index++];
+        }
+        node = snapshot->node;
+        snapshot->node = node->next;
+    }
+
+    *key_addr = node->key;
+    *key_len_addr = node->key_len;
+    *val_addr = node->val;
+    return DICT_OK;
+}
+
+/**
+ * Reset a snapshot to walk it again.
+ */
+void
+dict_snapshot_reset(dict_snapshot_t *snapshot)
+{
+    assert(snapshot != NULL);
+
+    snapshot->node = NULL;
+    snapshot->table = 0;
+    snapshot->index = snapshot->sizes[0] == 0 ? snapshot->size : 0;
+}
@@ -15,10 +15,28 @@
  */
 
 /**
- * BKDRHash hashtable implementation (list based).
+ * Hashtable implementation (list based).
+ *
+ * Tables are sized by powers of 2, keys are hashed by seeded wyhash by
+ * default, see `dict_use_hash` to pick another hash function.
+ *
+ * Small dicts (at most DICT_SMALL_MAX keys) keep their entries in an array
+ * inside the dict_t, scanned linearly without hashing, and are promoted to
+ * a table on the first key past it. The table and the nodes pool are not
+ * allocated until then.
+ *
+ * By default the dict stores the caller's key pointers, see `dict_own_keys`
+ * to have the dict copy keys: keys up to DICT_KEY_INLINE bytes are stored
+ * inline in their nodes, longer ones in an arena owned by the dict.
+ *
+ * `dict_snapshot_new` takes a point-in-time view of the dict that another
+ * thread can read while the dict keeps being written: the bucket arrays
+ * are copied, the nodes are shared until a write copies their bucket's
+ * chain (copy on write). Rehashing is paused while the snapshot is alive.
  */
 
 #ifndef __DICT_H
+#define __DICT_H
 
 #include <memory.h>
 #include <stdint.h>
@@ -26,12 +44,21 @@
 #include <assert.h>
 
 #include "bool.h"
+#include "arena.h"
+#include "hash.h"
+#include "pool.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define DICT_LOAD_LIMIT 0.75 // load factor limit
+#define DICT_SHRINK_LIMIT 0.1 // shrink below this load factor
+#define DICT_REHASH_STEP 1    // buckets to migrate per operation
+#define DICT_BATCH_SIZE 16    // keys per batch in dict_get_many/set_many
+#define DICT_SMALL_MAX 8      // max keys of a small dict (no table)
+#define DICT_KEY_INLINE 16    // max owned key length stored in the node
+#define DICT_STATS_CHAINS 8   // chain lengths in the dict_stats histogram
 
 typedef enum {
     DICT_OK = 0,
@@ -42,19 +69,69 @@ typedef enum {
 typedef struct dict_node_st {
     uint8_t *key;
     size_t key_len;
+    uint64_t hash;                   /* cached key hash */
     void *val;
     struct dict_node_st *next;
 } dict_node_t;
 
 typedef struct dict_st {
-    dict_node_t **table;            /* buckets table */
+    dict_node_t **table;            /* buckets table, NULL if small */
     size_t size;                     /* buckets table size */
     size_t table_size_index;         /* index in table_sizes */
+    dict_node_t **rehash_table;      /* old table in rehashing, or NULL */
+    size_t rehash_table_size_index;  /* index in table_sizes */
+    size_t rehash_index;             /* next bucket to rehash */
+    size_t rehash_paused;            /* number of iterators pausing rehash */
+    hash_func_t hash;                /* hash function */
+    uint64_t seed;                   /* hash seed */
+    pool_t *pool;                    /* nodes pool, NULL if never promoted */
+    arena_t *arena;                  /* owned keys arena, or NULL */
+    size_t resizes;                  /* resizes started (grow or shrink) */
+    uint64_t rehash_ns;              /* nanoseconds from resize start to
+                                        rehash end, summed */
+    uint64_t rehash_start_ns;        /* clock when the rehash started */
+    struct dict_snapshot_st *snapshot;  /* alive snapshot, or NULL */
+    dict_node_t small[DICT_SMALL_MAX];  /* entries of a small dict */
 } dict_t;
 
+typedef struct dict_snapshot_st {
+    dict_t *dict;                    /* dict snapshotted, NULL if detached */
+    dict_node_t **tables[2];         /* bucket heads at snapshot time */
+    dict_node_t **origins[2];        /* dict tables they were copied from */
+    size_t sizes[2];                 /* buckets, 0 if no table */
+    dict_node_t small[DICT_SMALL_MAX];  /* entries of a small dict */
+    size_t size;                     /* keys number */
+    pool_t *pool;                    /* nodes, owned once detached */
+    arena_t *arena;                  /* keys once detached, else a spare
+                                        arena for the dict, or NULL */
+    dict_node_t *node;               /* next node to walk */
+    size_t table;                    /* table walking on */
+    size_t index;                    /* next bucket (or small entry) */
+} dict_snapshot_t;
+
+typedef struct dict_stats_st {
+    size_t size;                     /* keys number */
+    size_t table_size;               /* buckets, 0 if small */
+    size_t rehash_table_size;        /* old table buckets, 0 if none */
+    double load;                     /* keys per bucket */
+    size_t chains[DICT_STATS_CHAINS];  /* buckets by chain length, the last
+                                          one counts longer chains too */
+    size_t chain_max;                /* longest chain */
+    double chain_avg;                /* avg length of non-empty chains */
+    size_t resizes;                  /* resizes started */
+    uint64_t rehash_ns;              /* nanoseconds of finished rehashes */
+    size_t table_bytes;              /* bytes of bucket tables */
+    size_t node_bytes;               /* bytes of nodes (pool slabs) */
+    size_t key_bytes;                /* bytes of owned keys (arena) */
+} dict_stats_t;
+
+typedef void (*dict_scan_func_t)(uint8_t *, size_t, void *, void *);
+
 typedef struct dict_iterator_st {
     dict_node_t *node;
     dict_t *dict;
+    dict_node_t **table;             /* table walking on, NULL if small */
+    size_t table_size;
     size_t index;
 } dict_iterator_t;
 
@@ -66,10 +143,28 @@ void *dict_get(dict_t *, uint8_t *, size_t);
 bool dict_has(dict_t *, uint8_t *, size_t);
 int dict_del(dict_t *, uint8_t *, size_t);
 size_t dict_size(dict_t *);
+size_t dict_table_size(dict_t *);
+void dict_stats(dict_t *, dict_stats_t *);
+bool dict_rehash(dict_t *, size_t);
+void dict_use_hash(dict_t *, hash_func_t);
+int dict_own_keys(dict_t *);
+uint64_t dict_hash(dict_t *, uint8_t *, size_t);
+int dict_set_hashed(dict_t *, uint8_t *, size_t, uint64_t, void *);
+int dict_del_hashed(dict_t *, uint8_t *, size_t, uint64_t);
+int dict_reserve(dict_t *, size_t);
+dict_node_t *dict_lookup(dict_t *, uint8_t *, size_t, uint64_t);
+void dict_get_many(dict_t *, uint8_t **, size_t *, void **, size_t);
+int dict_set_many(dict_t *, uint8_t **, size_t *, void **, size_t);
+size_t dict_scan(dict_t *, size_t, dict_scan_func_t, void *);
 dict_iterator_t *dict_iterator_new(dict_t *);
 void dict_iterator_free(dict_iterator_t *);
 int dict_iterator_next(dict_iterator_t *, uint8_t **, size_t *, void **);
 void dict_iterator_reset(dict_iterator_t *);
+dict_snapshot_t *dict_snapshot_new(dict_t *);
+void dict_snapshot_free(dict_snapshot_t *);
+size_t dict_snapshot_size(dict_snapshot_t *);
+int dict_snapshot_next(dict_snapshot_t *, uint8_t **, size_t *, void **);
+void dict_snapshot_reset(dict_snapshot_t *);
 
 #ifdef __cplusplus
 }
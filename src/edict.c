@@ -0,0 +1,395 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <time.h>
+
+#include "edict.h"
+
+/**
+ * Swap two heap items and fix their indexes.
+ */
+static void
+edict_heap_swap(edict_t *edict, size_t i, size_t j)
+{
+    edict_entry_t *entry = (edict->heap)[i];
+    (edict->heap)[i] = (edict->heap)[j];
+    (edict->heap)[j] = entry;
+    (edict->heap)[i]->heap_index = i;
+    (edict->heap)[j]->heap_index = j;
+}
+
+/**
+ * Move a heap item up until its parent is not later.
+ */
+static void
+edict_heap_up(edict_t *edict, size_t index)
+{
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+
+        if ((edict->heap)[parent]->deadline <=
+                (edict->heap)[index]->deadline)
+            break;
+        edict_heap_swap(edict, parent, index);
+        index = parent;
+    }
+}
+
+/**
+ * Move a heap item down until its children are not earlier.
+ */
+static void
+edict_heap_down(edict_t *edict, size_t index)
+{
+    while (1) {
+        size_t left = 2 * index + 1, right = left + 1, min = index;
+
+        if (left < edict->heap_size && (edict->heap)[left]->deadline <
+                (edict->heap)[min]->deadline)
+            min = left;
+        if (right < edict->heap_size && (edict->heap)[right]->deadline <
+                (edict->heap)[min]->deadline)
+            min = right;
+        if (min == index)
+            break;
+        edict_heap_swap(edict, index, min);
+        index = min;
+    }
+}
+
+/**
+ * Make room in the heap for one more entry.
+ */
+static int
+edict_heap_reserve(edict_t *edict)
+{
+    if (edict->heap_size == edict->heap_cap) {
+        size_t cap = edict->heap_cap * 2;
+
+        if (cap < EDICT_HEAP_CAP_MIN)
+            cap = EDICT_HEAP_CAP_MIN;
+
+        edict_entry_t **heap = realloc(edict->heap,
+                cap * sizeof(edict_entry_t *));
+
+        if (heap == NULL)
+            return EDICT_ENOMEM;
+
+        edict->heap = heap;
+        edict->heap_cap = cap;
+    }
+    return EDICT_OK;
+}
+
+/**
+ * Push an entry to the heap.
+ */
+static int
+edict_heap_push(edict_t *edict, edict_entry_t *entry)
+{
+    if (edict_heap_reserve(edict) != EDICT_OK)
+        return EDICT_ENOMEM;
+
+    entry->heap_index = edict->heap_size;
+    (edict->heap)[edict->heap_size++] = entry;
+    edict_heap_up(edict, entry->heap_index);
+    return EDICT_OK;
+}
+
+/**
+ * Remove an entry from the heap.
+ */
+static void
+edict_heap_remove(edict_t *edict, edict_entry_t *entry)
+{
+    size_t index = entry->heap_index;
+
+    edict->heap_size -= 1;
+
+    if (index == edict->heap_size)
+        return;
+
+    edict_heap_swap(edict, index, edict->heap_size);
+    edict_heap_up(edict, index);
+    edict_heap_down(edict, index);
+}
+
+/**
+ * Remove an entry from the edict.
+ */
+static void
+edict_remove(edict_t *edict, edict_entry_t *entry)
+{
+    if (entry->deadline > 0)
+        edict_heap_remove(edict, entry);
+    dict_del_hashed(edict->dict, entry->key, entry->key_len, entry->hash);
+    pool_dealloc(edict->pool, entry);
+}
+
+/**
+ * Find an entry by key, expired entry is removed and NULL is returned.
+ */
+static edict_entry_t *
+edict_find(edict_t *edict, uint8_t *key, size_t key_len)
+{
+    edict_entry_t *entry = dict_get(edict->dict, key, key_len);
+
+    if (entry != NULL && entry->deadline > 0 &&
+            entry->deadline <= (edict->clock)()) {
+        edict_remove(edict, entry);
+        return NULL;
+    }
+    return entry;
+}
+
+/**
+ * Get current monotonic time in milliseconds, the default clock.
+ */
+uint64_t
+edict_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * New empty edict.
+ */
+edict_t *
+edict_new()
+{
+    edict_t *edict = malloc(sizeof(edict_t));
+
+    if (edict != NULL) {
+        edict->dict = dict_new();
+        edict->pool = pool_new(sizeof(edict_entry_t));
+
+        if (edict->dict == NULL || edict->pool == NULL) {
+            dict_free(edict->dict);
+            pool_free(edict->pool);
+            free(edict);
+            return NULL;
+        }
+
+        edict->heap = NULL;
+        edict->heap_size = 0;
+        edict->heap_cap = 0;
+        edict->clock = &edict_time;
+    }
+    return edict;
+}
+
+/**
+ * Free edict.
+ */
+void
+edict_free(edict_t *edict)
+{
+    if (edict != NULL) {
+        dict_free(edict->dict);
+        pool_free(edict->pool);
+        free(edict->heap);
+        free(edict);
+    }
+}
+
+/**
+ * Clear edict.
+ */
+void
+edict_clear(edict_t *edict)
+{
+    assert(edict != NULL);
+    dict_clear(edict->dict);
+    pool_clear(edict->pool);
+    edict->heap_size = 0;
+}
+
+/**
+ * Use another clock (milliseconds), edict must be empty.
+ */
+void
+edict_use_clock(edict_t *edict, edict_clock_func_t clock)
+{
+    assert(edict != NULL && clock != NULL);
+    assert(edict_size(edict) == 0);
+    edict->clock = clock;
+}
+
+/**
+ * Set a key to edict expiring at `deadline` (0 for never). On no memory
+ * the edict is unchanged (an existing key keeps its val and deadline).
+ */
+int
+edict_set(edict_t *edict, uint8_t *key, size_t key_len, void *val,
+        uint64_t deadline)
+{
+    assert(edict != NULL);
+
+    uint64_t hash = dict_hash(edict->dict, key, key_len);
+    dict_node_t *node = dict_lookup(edict->dict, key, key_len, hash);
+    edict_entry_t *entry;
+
+    if (node != NULL) {
+        entry = node->val;
+
+        // room in the heap first, so that a failed update changes nothing
+        if (entry->deadline == 0 && deadline > 0 &&
+                edict_heap_reserve(edict) != EDICT_OK)
+            return EDICT_ENOMEM;
+
+        node->key = key;
+        entry->key = key;
+        entry->val = val;
+
+        if (entry->deadline > 0 && deadline > 0) {
+            uint64_t old = entry->deadline;
+            entry->deadline = deadline;
+
+            if (deadline < old)
+                edict_heap_up(edict, entry->heap_index);
+            else
+                edict_heap_down(edict, entry->heap_index);
+            return EDICT_OK;
+        }
+
+        if (entry->deadline > 0)
+            edict_heap_remove(edict, entry);
+        entry->deadline = deadline;
+
+        // can't fail, reserved above
+        if (deadline > 0)
+            edict_heap_push(edict, entry);
+        return EDICT_OK;
+    }
+
+    entry = pool_alloc(edict->pool);
+
+    if (entry == NULL)
+        return EDICT_ENOMEM;
+
+    entry->key = key;
+    entry->key_len = key_len;
+    entry->hash = hash;
+    entry->val = val;
+    entry->deadline = deadline;
+
+    if (deadline > 0 && edict_heap_push(edict, entry) != EDICT_OK) {
+        pool_dealloc(edict->pool, entry);
+        return EDICT_ENOMEM;
+    }
+
+    if (dict_set_hashed(edict->dict, key, key_len, hash, entry) != DICT_OK) {
+        if (deadline > 0)
+            edict_heap_remove(edict, entry);
+        pool_dealloc(edict->pool, entry);
+        return EDICT_ENOMEM;
+    }
+    return EDICT_OK;
+}
+
+/**
+ * Get val from edict by key, NULL if not found or expired.
+ */
+void *
+edict_get(edict_t *edict, uint8_t *key, size_t key_len)
+{
+    assert(edict != NULL);
+
+    edict_entry_t *entry = edict_find(edict, key, key_len);
+
+    if (entry != NULL)
+        return entry->val;
+    return NULL;
+}
+
+/**
+ * Test if a key is in the edict and not expired.
+ */
+bool
+edict_has(edict_t *edict, uint8_t *key, size_t key_len)
+{
+    assert(edict != NULL);
+    return edict_find(edict, key, key_len) != NULL;
+}
+
+/**
+ * Del a key from edict.
+ */
+int
+edict_del(edict_t *edict, uint8_t *key, size_t key_len)
+{
+    assert(edict != NULL);
+
+    edict_entry_t *entry = edict_find(edict, key, key_len);
+
+    if (entry == NULL)
+        return EDICT_ENOTFOUND;
+
+    edict_remove(edict, entry);
+    return EDICT_OK;
+}
+
+/**
+ * Get the deadline of a key, 0 if the key never expires or is not found.
+ */
+uint64_t
+edict_deadline(edict_t *edict, uint8_t *key, size_t key_len)
+{
+    assert(edict != NULL);
+
+    edict_entry_t *entry = edict_find(edict, key, key_len);
+
+    if (entry != NULL)
+        return entry->deadline;
+    return 0;
+}
+
+/**
+ * Remove at most `limit` expired keys (0 for no limit), O(k log n). Returns
+ * the number of keys removed.
+ */
+size_t
+edict_expire(edict_t *edict, size_t limit)
+{
+    assert(edict != NULL);
+
+    uint64_t now = (edict->clock)();
+    size_t count = 0;
+
+    while (edict->heap_size > 0 && (limit == 0 || count < limit)) {
+        edict_entry_t *entry = (edict->heap)[0];
+
+        if (entry->deadline > now)
+            break;
+
+        edict_remove(edict, entry);
+        count += 1;
+    }
+    return count;
+}
+
+/**
+ * Get edict size, expired keys not yet removed are counted.
+ */
+size_t
+edict_size(edict_t *edict)
+{
+    assert(edict != NULL);
+    return dict_size(edict->dict);
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Expiring dict (dict based).
+ *
+ * Each key may carry a deadline (absolute milliseconds on the edict's
+ * clock, 0 for never). Expired keys are dropped lazily when accessed, and
+ * `edict_expire` reclaims the rest in bounded slices: keys with deadlines
+ * are kept in a min-heap by deadline, so the cost scales with the number
+ * of expirations rather than the dict size.
+ */
+
+#ifndef __EDICT_H
+#define __EDICT_H
+
+#include "dict.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EDICT_HEAP_CAP_MIN 16  // min heap capacity
+
+typedef enum {
+    EDICT_OK = 0,
+    EDICT_ENOMEM = -1,      /* No memory error */
+    EDICT_ENOTFOUND = -2,   /* Key was not found */
+} edict_error_t;
+
+typedef uint64_t (*edict_clock_func_t)(void);
+
+typedef struct edict_entry_st {
+    uint8_t *key;
+    size_t key_len;
+    uint64_t hash;
+    void *val;
+    uint64_t deadline;               /* 0 for never expires */
+    size_t heap_index;               /* position in heap if deadline > 0 */
+} edict_entry_t;
+
+typedef struct edict_st {
+    dict_t *dict;                    /* key => entry */
+    pool_t *pool;                    /* entries pool */
+    edict_entry_t **heap;            /* min-heap by deadline */
+    size_t heap_size;
+    size_t heap_cap;
+    edict_clock_func_t clock;        /* clock in milliseconds */
+} edict_t;
+
+uint64_t edict_time(void);
+edict_t *edict_new();
+void edict_free(edict_t *);
+void edict_clear(edict_t *);
+void edict_use_clock(edict_t *, edict_clock_func_t);
+int edict_set(edict_t *, uint8_t *, size_t, void *, uint64_t);
+void *edict_get(edict_t *, uint8_t *, size_t);
+bool edict_has(edict_t *, uint8_t *, size_t);
+int edict_del(edict_t *, uint8_t *, size_t);
+uint64_t edict_deadline(edict_t *, uint8_t *, size_t);
+size_t edict_expire(edict_t *, size_t);
+size_t edict_size(edict_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
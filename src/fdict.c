@@ -0,0 +1,369 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "fdict.h"
+
+typedef struct fdict_key_st {
+    uint8_t *key;
+    size_t key_len;
+    void *val;
+    uint64_t hash;
+    size_t slot;
+} fdict_key_t;
+
+/**
+ * Get the bucket of a key hash. Buckets are skewed: 60% of the keys go to
+ * the first 30% of the buckets, dense buckets are placed first while most
+ * slots are free, which leaves fewer keys for the crowded end.
+ */
+static size_t
+fdict_bucket(fdict_t *fdict, uint64_t hash)
+{
+    size_t dense = fdict->buckets * 3 / 10 + 1;
+
+    if ((hash >> 32) < (uint64_t)(0.6 * 4294967296.0))
+        return (uint32_t)hash % dense;
+    return dense + (uint32_t)hash % (fdict->buckets - dense);
+}
+
+/**
+ * Get the position of a key hash placed by a pilot, in [0, slots).
+ */
+static size_t
+fdict_position(fdict_t *fdict, uint64_t hash, uint32_t pilot)
+{
+    return hash_u64(hash, pilot) % fdict->slots;
+}
+
+/**
+ * Get the slot of a key hash, in [0, size).
+ */
+static size_t
+fdict_slot(fdict_t *fdict, uint64_t hash)
+{
+    size_t position = fdict_position(fdict, hash,
+            (fdict->pilots)[fdict_bucket(fdict, hash)]);
+
+    if (position < fdict->size)
+        return position;
+    return (fdict->remap)[position - fdict->size];
+}
+
+/**
+ * Get the offset of a slot's key, or the keys end for slot `size`.
+ */
+static size_t
+fdict_offset(fdict_t *fdict, size_t slot)
+{
+    if (fdict->offsets32 != NULL)
+        return (fdict->offsets32)[slot];
+    return (fdict->offsets64)[slot];
+}
+
+/**
+ * Set the offset of a slot's key.
+ */
+static void
+fdict_set_offset(fdict_t *fdict, size_t slot, size_t offset)
+{
+    if (fdict->offsets32 != NULL)
+        (fdict->offsets32)[slot] = offset;
+    else
+        (fdict->offsets64)[slot] = offset;
+}
+
+/**
+ * Hash keys with the fdict's seed and sort them by bucket into `sorted`,
+ * `starts` is filled with each bucket's first key (buckets + 1).
+ */
+static void
+fdict_sort(fdict_t *fdict, fdict_key_t *keys, fdict_key_t *sorted,
+        size_t *starts, size_t *cursors)
+{
+    size_t i;
+
+    memset(starts, 0, (fdict->buckets + 1) * sizeof(size_t));
+
+    for (i = 0; i < fdict->size; i++) {
+        keys[i].hash = hash_bytes(keys[i].key, keys[i].key_len, fdict->seed);
+        starts[fdict_bucket(fdict, keys[i].hash) + 1] += 1;
+    }
+
+    for (i = 0; i < fdict->buckets; i++)
+        starts[i + 1] += starts[i];
+
+    memcpy(cursors, starts, fdict->buckets * sizeof(size_t));
+
+    for (i = 0; i < fdict->size; i++)
+        sorted[cursors[fdict_bucket(fdict, keys[i].hash)]++] = keys[i];
+}
+
+/**
+ * Order buckets by size desc into `order`.
+ */
+static void
+fdict_order(fdict_t *fdict, size_t *starts, size_t *order)
+{
+    size_t i, len, max_len = 0, cursor = 0;
+
+    for (i = 0; i < fdict->buckets; i++)
+        if (starts[i + 1] - starts[i] > max_len)
+            max_len = starts[i + 1] - starts[i];
+
+    for (len = max_len + 1; len-- > 0;)
+        for (i = 0; i < fdict->buckets; i++)
+            if (starts[i + 1] - starts[i] == len)
+                order[cursor++] = i;
+}
+
+/**
+ * Find pilots for all buckets (larger buckets first, while there are many
+ * free positions), `keys` are sorted by bucket. Returns false if some
+ * bucket can't be placed with this seed.
+ */
+static bool
+fdict_place(fdict_t *fdict, fdict_key_t *keys, size_t *starts,
+        size_t *order, uint64_t *taken, size_t *positions)
+{
+    size_t i, j, k;
+
+    memset(taken, 0, (fdict->slots / 64 + 1) * sizeof(uint64_t));
+
+    for (i = 0; i < fdict->buckets; i++) {
+        size_t bucket = order[i];
+        size_t start = starts[bucket], len = starts[bucket + 1] - start;
+        uint32_t pilot;
+
+        if (len == 0)
+            break;
+
+        for (pilot = 0; pilot < FDICT_PILOT_MAX; pilot++) {
+            for (j = 0; j < len; j++) {
+                size_t position = fdict_position(fdict,
+                        keys[start + j].hash, pilot);
+
+                if (taken[position / 64] & (1ULL << (position % 64)))
+                    break;
+                for (k = 0; k < j; k++)
+                    if (positions[k] == position)
+                        break;
+                if (k < j)
+                    break;
+                positions[j] = position;
+            }
+
+            if (j == len)
+                break;
+        }
+
+        if (pilot == FDICT_PILOT_MAX)
+            return false;
+
+        for (j = 0; j < len; j++)
+            taken[positions[j] / 64] |= 1ULL << (positions[j] % 64);
+        (fdict->pilots)[bucket] = pilot;
+    }
+
+    // map taken positions beyond size to the free slots below size
+    size_t slot = 0;
+
+    for (i = fdict->size; i < fdict->slots; i++) {
+        if (!(taken[i / 64] & (1ULL << (i % 64))))
+            continue;
+        while (taken[slot / 64] & (1ULL << (slot % 64)))
+            slot++;
+        (fdict->remap)[i - fdict->size] = slot++;
+    }
+    return true;
+}
+
+/**
+ * Pack keys and vals in slot order, offsets are 32 bits unless the keys
+ * take more than 4 GiB.
+ */
+static bool
+fdict_pack(fdict_t *fdict, fdict_key_t *keys, size_t keys_bytes)
+{
+    size_t i;
+
+    if (keys_bytes <= UINT32_MAX)
+        fdict->offsets32 = calloc(fdict->size + 1, sizeof(uint32_t));
+    else
+        fdict->offsets64 = calloc(fdict->size + 1, sizeof(uint64_t));
+
+    fdict->keys = malloc(keys_bytes > 0 ? keys_bytes : 1);
+
+    if ((fdict->offsets32 == NULL && fdict->offsets64 == NULL) ||
+            fdict->keys == NULL)
+        return false;
+
+    for (i = 0; i < fdict->size; i++) {
+        keys[i].slot = fdict_slot(fdict, keys[i].hash);
+        fdict_set_offset(fdict, keys[i].slot + 1, keys[i].key_len);
+    }
+
+    for (i = 0; i < fdict->size; i++)
+        fdict_set_offset(fdict, i + 1,
+                fdict_offset(fdict, i + 1) + fdict_offset(fdict, i));
+
+    for (i = 0; i < fdict->size; i++) {
+        memcpy(fdict->keys + fdict_offset(fdict, keys[i].slot), keys[i].key,
+                keys[i].key_len);
+        (fdict->vals)[keys[i].slot] = keys[i].val;
+    }
+    return true;
+}
+
+/**
+ * Find the slot of a key, returns `size` if not found.
+ */
+static size_t
+fdict_find(fdict_t *fdict, uint8_t *key, size_t key_len)
+{
+    if (fdict->size == 0)
+        return 0;
+
+    uint64_t hash = hash_bytes(key, key_len, fdict->seed);
+    size_t slot = fdict_slot(fdict, hash);
+    size_t offset = fdict_offset(fdict, slot);
+
+    if (fdict_offset(fdict, slot + 1) - offset == key_len &&
+            memcmp(fdict->keys + offset, key, key_len) == 0)
+        return slot;
+    return fdict->size;
+}
+
+/**
+ * Build a frozen dict from a dict's current keys, O(n) expected. Keys are
+ * copied, vals are shared. Returns NULL on no memory.
+ */
+fdict_t *
+dict_freeze(dict_t *dict)
+{
+    assert(dict != NULL);
+
+    fdict_t *fdict = calloc(1, sizeof(fdict_t));
+
+    if (fdict == NULL)
+        return NULL;
+
+    size_t n = dict_size(dict);
+
+    fdict->size = n;
+    fdict->slots = n + n / FDICT_SLOTS_SPARE + 1;
+    fdict->buckets = n / FDICT_BUCKET_KEYS + 2;
+    fdict->pilots = calloc(fdict->buckets, sizeof(uint32_t));
+    fdict->remap = calloc(fdict->slots - n, sizeof(size_t));
+    fdict->vals = malloc((n + 1) * sizeof(void *));
+
+    fdict_key_t *keys = malloc((n + 1) * sizeof(fdict_key_t));
+    fdict_key_t *sorted = malloc((n + 1) * sizeof(fdict_key_t));
+    size_t *starts = malloc((fdict->buckets + 1) * sizeof(size_t));
+    size_t *order = malloc(fdict->buckets * sizeof(size_t));
+    size_t *positions = malloc((n + 1) * sizeof(size_t));
+    uint64_t *taken = malloc((fdict->slots / 64 + 1) * sizeof(uint64_t));
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+
+    bool ok = fdict->pilots != NULL && fdict->remap != NULL &&
+        fdict->vals != NULL && keys != NULL &&
+        sorted != NULL && starts != NULL && order != NULL &&
+        positions != NULL && taken != NULL && iterator != NULL;
+
+    size_t i = 0, keys_bytes = 0, try = 0;
+
+    if (ok) {
+        while (dict_iterator_next(iterator, &keys[i].key, &keys[i].key_len,
+                    &keys[i].val) == DICT_OK)
+            keys_bytes += keys[i++].key_len;
+
+        for (try = 0; try < FDICT_SEED_TRIES; try++) {
+            fdict->seed = hash_u64(hash_seed(), try);
+            fdict_sort(fdict, keys, sorted, starts, order);
+            fdict_order(fdict, starts, order);
+
+            if (fdict_place(fdict, sorted, starts, order, taken, positions))
+                break;
+        }
+    }
+
+    ok = ok && try < FDICT_SEED_TRIES && fdict_pack(fdict, keys, keys_bytes);
+
+    dict_iterator_free(iterator);
+    free(keys);
+    free(sorted);
+    free(starts);
+    free(order);
+    free(positions);
+    free(taken);
+
+    if (!ok) {
+        fdict_free(fdict);
+        return NULL;
+    }
+    return fdict;
+}
+
+/**
+ * Free fdict.
+ */
+void
+fdict_free(fdict_t *fdict)
+{
+    if (fdict != NULL) {
+        free(fdict->pilots);
+        free(fdict->remap);
+        free(fdict->offsets32);
+        free(fdict->offsets64);
+        free(fdict->keys);
+        free(fdict->vals);
+        free(fdict);
+    }
+}
+
+/**
+ * Get val from fdict by key, one probe.
+ */
+void *
+fdict_get(fdict_t *fdict, uint8_t *key, size_t key_len)
+{
+    assert(fdict != NULL);
+
+    size_t slot = fdict_find(fdict, key, key_len);
+
+    if (slot < fdict->size)
+        return (fdict->vals)[slot];
+    return NULL;
+}
+
+/**
+ * Test if a key is in the fdict.
+ */
+bool
+fdict_has(fdict_t *fdict, uint8_t *key, size_t key_len)
+{
+    assert(fdict != NULL);
+    return fdict_find(fdict, key, key_len) < fdict->size;
+}
+
+/**
+ * Get fdict size.
+ */
+size_t
+fdict_size(fdict_t *fdict)
+{
+    assert(fdict != NULL);
+    return fdict->size;
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Frozen dict (minimal perfect hash, read only).
+ *
+ * `dict_freeze` builds an immutable copy of a dict: keys are hashed into
+ * buckets, each bucket gets a pilot such that its keys land on free
+ * positions (hash and displace, CHD/PTHash style). Positions are ~1% more
+ * than keys to keep building fast, the few taken positions beyond `size`
+ * are remapped to the free slots below it, so every key owns exactly one
+ * of the `size` slots and a lookup is always a single probe.
+ *
+ * Keys are copied and packed contiguously in slot order. Besides the key
+ * bytes, each key stores a val pointer and a 4 bytes key offset (8 bytes
+ * only if the packed keys exceed 4 GiB), plus a 32 bits pilot per
+ * FDICT_BUCKET_KEYS keys and a remapped slot per FDICT_SLOTS_SPARE keys:
+ * about 13 bytes per key on 64 bits.
+ */
+
+#ifndef __FDICT_H
+#define __FDICT_H
+
+#include "dict.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FDICT_BUCKET_KEYS 4         // average keys per bucket
+#define FDICT_SLOTS_SPARE 100       // 1 spare position per 100 keys
+#define FDICT_PILOT_MAX (1 << 24)   // max pilot before trying another seed
+#define FDICT_SEED_TRIES 16         // max seeds to try
+
+typedef struct fdict_st {
+    size_t size;                     /* keys number (= slots number) */
+    size_t slots;                    /* positions number, >= size */
+    size_t buckets;                  /* buckets number */
+    uint64_t seed;                   /* hash seed */
+    uint32_t *pilots;                /* pilot per bucket */
+    size_t *remap;                   /* positions >= size => free slots */
+    uint32_t *offsets32;             /* key offsets by slot, size + 1 */
+    uint64_t *offsets64;             /* used instead if keys are >4 GiB */
+    uint8_t *keys;                   /* packed keys */
+    void **vals;                     /* vals by slot */
+} fdict_t;
+
+fdict_t *dict_freeze(dict_t *);
+void fdict_free(fdict_t *);
+void *fdict_get(fdict_t *, uint8_t *, size_t);
+bool fdict_has(fdict_t *, uint8_t *, size_t);
+size_t fdict_size(fdict_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
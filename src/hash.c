@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hash.h"
+
+/* wyhash secrets */
+static const uint64_t wyp[4] = {
+    0x2d358dccaa6c78a5ULL,
+    0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL,
+    0x4d5a2da51de1aa47ULL,
+};
+
+static _Atomic uint64_t process_seed = 0;  // 0 until initialized
+
+/**
+ * 64x64 => 128 bits multiply, returns low bits in `a` and high in `b`.
+ */
+static void
+wymum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/**
+ * Multiply and fold.
+ */
+static uint64_t
+wymix(uint64_t a, uint64_t b)
+{
+    wymum(&a, &b);
+    return a ^ b;
+}
+
+static uint64_t
+wyr8(uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static uint64_t
+wyr4(uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint64_t
+wyr3(uint8_t *p, size_t k)
+{
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) |
+        p[k - 1];
+}
+
+/**
+ * Get a new random (non zero) seed, read from /dev/urandom (falls back to
+ * the clock, pid and a counter). For seeds stored outside the process,
+ * which must not reveal `hash_seed`.
+ */
+uint64_t
+hash_seed_new(void)
+{
+    static _Atomic uint64_t calls = 0;
+    uint64_t s = 0;
+    FILE *stream = fopen("/dev/urandom", "r");
+
+    if (stream != NULL) {
+        if (fread(&s, sizeof(s), 1, stream) != 1)
+            s = 0;
+        fclose(stream);
+    }
+
+    if (s == 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        s = wymix(((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec) ^
+                wyp[0], ((uint64_t)getpid() << 32) ^ atomic_fetch_add(
+                    &calls, 1) ^ wyp[1]);
+    }
+    return s != 0 ? s : wyp[0];
+}
+
+/**
+ * Get the per-process random seed, by `hash_seed_new` on first call.
+ * Thread safe: threads racing on the first call all return the seed
+ * stored first.
+ */
+uint64_t
+hash_seed(void)
+{
+    uint64_t seed = atomic_load(&process_seed);
+
+    if (seed != 0)
+        return seed;
+
+    uint64_t s = hash_seed_new();
+
+    // on failure `seed` is set to the winner's seed
+    if (!atomic_compare_exchange_strong(&process_seed, &seed, s))
+        return seed;
+    return s;
+}
+
+/**
+ * wyhash (final version 4), processes 8 bytes per multiply.
+ */
+uint64_t
+hash_bytes(uint8_t *key, size_t key_len, uint64_t seed)
+{
+    uint8_t *p = key;
+    uint64_t a, b;
+
+    seed ^= wymix(seed ^ wyp[0], wyp[1]);
+
+    if (key_len <= 16) {
+        if (key_len >= 4) {
+            a = (wyr4(p) << 32) | wyr4(p + ((key_len >> 3) << 2));
+            b = (wyr4(p + key_len - 4) << 32) |
+                wyr4(p + key_len - 4 - ((key_len >> 3) << 2));
+        } else if (key_len > 0) {
+            a = wyr3(p, key_len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = key_len;
+
+        if (i >= 48) {
+            uint64_t see1 = seed, see2 = seed;
+
+            do {
+                seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+                see1 = wymix(wyr8(p + 16) ^ wyp[2], wyr8(p + 24) ^ see1);
+                see2 = wymix(wyr8(p + 32) ^ wyp[3], wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16) {
+            seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+
+        a = wyr8(p + i - 16);
+        b = wyr8(p + i - 8);
+    }
+
+    a ^= wyp[1];
+    b ^= seed;
+    wymum(&a, &b);
+    return wymix(a ^ wyp[0] ^ key_len, b ^ wyp[1]);
+}
+
+/**
+ * Hash an integer, one multiply.
+ */
+uint64_t
+hash_u64(uint64_t key, uint64_t seed)
+{
+    return wymix(key ^ wyp[0], seed ^ wyp[1]);
+}
+
+/**
+ * Hash 4 or 8 bytes keys as integers, other keys by `hash_bytes`.
+ */
+uint64_t
+hash_int(uint8_t *key, size_t key_len, uint64_t seed)
+{
+    if (key_len == 8)
+        return hash_u64(wyr8(key), seed ^ 8);
+    if (key_len == 4)
+        return hash_u64(wyr4(key), seed ^ 4);
+    return hash_bytes(key, key_len, seed);
+}
+
+/**
+ * BKDRHash (one byte per multiply).
+ */
+uint64_t
+hash_bkdr(uint8_t *key, size_t key_len, uint64_t seed)
+{
+    uint64_t hash = seed;
+
+    for (; key_len > 0; key_len--)
+        hash = hash * 13131 + (*key++);  // 31 131 1313 13131..
+    return hash;
+}
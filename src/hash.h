@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Seeded hash functions.
+ *
+ *   hash_bytes   wyhash, 8 bytes per multiply, default for dict
+ *   hash_int     fast path for 4 or 8 bytes keys (integers)
+ *   hash_bkdr    the old BKDRHash, byte by byte
+ *
+ * All hash functions share the `hash_func_t` signature, the seed should be
+ * random (see `hash_seed`) so that keys colliding in one process don't
+ * collide in another.
+ */
+
+#ifndef __HASH_H
+#define __HASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t (*hash_func_t)(uint8_t *, size_t, uint64_t);
+
+uint64_t hash_seed(void);
+uint64_t hash_seed_new(void);
+uint64_t hash_bytes(uint8_t *, size_t, uint64_t);
+uint64_t hash_int(uint8_t *, size_t, uint64_t);
+uint64_t hash_bkdr(uint8_t *, size_t, uint64_t);
+uint64_t hash_u64(uint64_t, uint64_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
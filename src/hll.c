@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <math.h>
+
+#include "hll.h"
+
+/**
+ * Get the registers number.
+ */
+static size_t
+hll_registers_num(hll_t *hll)
+{
+    return (size_t)1 << hll->precision;
+}
+
+/**
+ * Turn a sparse hll dense.
+ */
+static int
+hll_densify(hll_t *hll)
+{
+    uint8_t *registers = calloc(hll_registers_num(hll), sizeof(uint8_t));
+    size_t i;
+
+    if (registers == NULL)
+        return HLL_ENOMEM;
+
+    for (i = 0; i < hll->sparse_size; i++)
+        registers[(hll->sparse)[i] >> 8] = (hll->sparse)[i] & 0xff;
+
+    free(hll->sparse);
+    hll->sparse = NULL;
+    hll->sparse_size = 0;
+    hll->sparse_cap = 0;
+    hll->registers = registers;
+    return HLL_OK;
+}
+
+/**
+ * Set a register to `value` if larger.
+ */
+static int
+hll_update(hll_t *hll, size_t index, uint8_t value)
+{
+    if (hll->registers != NULL) {
+        if ((hll->registers)[index] < value)
+            (hll->registers)[index] = value;
+        return HLL_OK;
+    }
+
+    // binary search the first pair not less than index
+    size_t lo = 0, hi = hll->sparse_size;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (((hll->sparse)[mid] >> 8) < index)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < hll->sparse_size && ((hll->sparse)[lo] >> 8) == index) {
+        if (((hll->sparse)[lo] & 0xff) < value)
+            (hll->sparse)[lo] = (uint32_t)index << 8 | value;
+        return HLL_OK;
+    }
+
+    // sparse pairs are 4 bytes, dense registers 1 byte
+    if (hll->sparse_size >= hll_registers_num(hll) / 16) {
+        if (hll_densify(hll) != HLL_OK)
+            return HLL_ENOMEM;
+        return hll_update(hll, index, value);
+    }
+
+    if (hll->sparse_size == hll->sparse_cap) {
+        size_t cap = hll->sparse_cap > 0 ? hll->sparse_cap * 2 : 16;
+        uint32_t *sparse = realloc(hll->sparse, cap * sizeof(uint32_t));
+
+        if (sparse == NULL)
+            return HLL_ENOMEM;
+        hll->sparse = sparse;
+        hll->sparse_cap = cap;
+    }
+
+    memmove(hll->sparse + lo + 1, hll->sparse + lo,
+            (hll->sparse_size - lo) * sizeof(uint32_t));
+    (hll->sparse)[lo] = (uint32_t)index << 8 | value;
+    hll->sparse_size += 1;
+    return HLL_OK;
+}
+
+/**
+ * New hll of precision `precision` (0 for `HLL_PRECISION_DEFAULT`).
+ */
+hll_t *
+hll_new(size_t precision)
+{
+    if (precision == 0)
+        precision = HLL_PRECISION_DEFAULT;
+
+    assert(precision >= HLL_PRECISION_MIN &&
+            precision <= HLL_PRECISION_MAX);
+
+    hll_t *hll = malloc(sizeof(hll_t));
+
+    if (hll != NULL) {
+        hll->precision = precision;
+        hll->seed = HLL_SEED;
+        hll->registers = NULL;
+        hll->sparse = NULL;
+        hll->sparse_size = 0;
+        hll->sparse_cap = 0;
+    }
+    return hll;
+}
+
+/**
+ * Free hll.
+ */
+void
+hll_free(hll_t *hll)
+{
+    if (hll != NULL) {
+        free(hll->registers);
+        free(hll->sparse);
+        free(hll);
+    }
+}
+
+/**
+ * Clear hll, back to the sparse encoding.
+ */
+void
+hll_clear(hll_t *hll)
+{
+    assert(hll != NULL);
+    free(hll->registers);
+    hll->registers = NULL;
+    hll->sparse_size = 0;
+}
+
+/**
+ * Add a hash to hll: the high bits pick the register, the position of
+ * the first set bit in the rest is the value.
+ */
+int
+hll_add_hash(hll_t *hll, uint64_t hash)
+{
+    assert(hll != NULL);
+
+    size_t index = hash >> (64 - hll->precision);
+    uint64_t rest = hash << hll->precision |
+        (uint64_t)1 << (hll->precision - 1);  // stop the count
+    uint8_t value = __builtin_clzll(rest) + 1;
+
+    return hll_update(hll, index, value);
+}
+
+/**
+ * Add a key to hll.
+ */
+int
+hll_add(hll_t *hll, uint8_t *key, size_t key_len)
+{
+    assert(hll != NULL);
+    return hll_add_hash(hll, hash_bytes(key, key_len, hll->seed));
+}
+
+/**
+ * Estimate the number of distinct keys added, O(registers) if dense.
+ */
+uint64_t
+hll_count(hll_t *hll)
+{
+    assert(hll != NULL);
+
+    double m = hll_registers_num(hll);
+    double sum = 0;
+    size_t zeros, i;
+
+    if (hll->registers == NULL) {
+        zeros = m - hll->sparse_size;
+        for (i = 0; i < hll->sparse_size; i++)
+            sum += ldexp(1, -(int)((hll->sparse)[i] & 0xff));
+        sum += zeros;
+    } else {
+        for (i = 0, zeros = 0; i < m; i++) {
+            sum += ldexp(1, -(int)(hll->registers)[i]);
+            if ((hll->registers)[i] == 0)
+                zeros++;
+        }
+    }
+
+    double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 :
+        0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    // linear counting for small sets, no large range correction is
+    // needed with 64 bits hashes
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / zeros);
+    return (uint64_t)(estimate + 0.5);
+}
+
+/**
+ * Merge `src` into `dst`, both must have the same precision and seed.
+ */
+int
+hll_merge(hll_t *dst, hll_t *src)
+{
+    assert(dst != NULL && src != NULL);
+
+    size_t i;
+
+    if (dst->precision != src->precision || dst->seed != src->seed)
+        return HLL_EMISMATCH;
+
+    if (src->registers == NULL) {
+        for (i = 0; i < src->sparse_size; i++)
+            if (hll_update(dst, (src->sparse)[i] >> 8,
+                        (src->sparse)[i] & 0xff) != HLL_OK)
+                return HLL_ENOMEM;
+        return HLL_OK;
+    }
+
+    if (dst->registers == NULL && hll_densify(dst) != HLL_OK)
+        return HLL_ENOMEM;
+
+    for (i = 0; i < hll_registers_num(dst); i++)
+        if ((dst->registers)[i] < (src->registers)[i])
+            (dst->registers)[i] = (src->registers)[i];
+    return HLL_OK;
+}
+
+/**
+ * Append hll to buf: a header, then the registers or the sparse pairs.
+ */
+int
+hll_dump(hll_t *hll, buf_t *buf)
+{
+    assert(hll != NULL && buf != NULL);
+
+    hll_header_t header = {HLL_MAGIC, hll->precision, hll->seed,
+        hll->registers != NULL, hll->sparse_size};
+
+    if (buf_put(buf, (uint8_t *)&header, sizeof(header)) != BUF_OK)
+        return HLL_ENOMEM;
+
+    if (hll->registers != NULL) {
+        if (buf_put(buf, hll->registers, hll_registers_num(hll)) != BUF_OK)
+            return HLL_ENOMEM;
+    } else if (hll->sparse_size > 0) {
+        if (buf_put(buf, (uint8_t *)hll->sparse,
+                    hll->sparse_size * sizeof(uint32_t)) != BUF_OK)
+            return HLL_ENOMEM;
+    }
+    return HLL_OK;
+}
+
+/**
+ * Load a hll from a dump, NULL if no memory or the dump is invalid.
+ */
+hll_t *
+hll_load(uint8_t *data, size_t len)
+{
+    assert(data != NULL);
+
+    hll_header_t header;
+
+    if (len < sizeof(header))
+        return NULL;
+
+    memcpy(&header, data, sizeof(header));
+    data += sizeof(header);
+    len -= sizeof(header);
+
+    if (header.magic != HLL_MAGIC ||
+            header.precision < HLL_PRECISION_MIN ||
+            header.precision > HLL_PRECISION_MAX)
+        return NULL;
+
+    size_t m = (size_t)1 << header.precision;
+    size_t expect = header.dense ? m : header.sparse_size * sizeof(uint32_t);
+    size_t i;
+
+    if (header.dense > 1 || (header.dense && header.sparse_size != 0) ||
+            header.sparse_size > m / 16 || len != expect)
+        return NULL;
+
+    hll_t *hll = hll_new(header.precision);
+
+    if (hll == NULL)
+        return NULL;
+
+    hll->seed = header.seed;
+
+    if (header.dense) {
+        hll->registers = malloc(m);
+        if (hll->registers == NULL) {
+            hll_free(hll);
+            return NULL;
+        }
+        memcpy(hll->registers, data, m);
+    } else if (header.sparse_size > 0) {
+        hll->sparse = malloc(len);
+        if (hll->sparse == NULL) {
+            hll_free(hll);
+            return NULL;
+        }
+        memcpy(hll->sparse, data, len);
+        hll->sparse_size = header.sparse_size;
+        hll->sparse_cap = header.sparse_size;
+
+        // pairs must be sorted by register
+        for (i = 0; i < hll->sparse_size; i++) {
+            if (((hll->sparse)[i] >> 8) >= m || (i > 0 &&
+                        (hll->sparse)[i] >> 8 <= (hll->sparse)[i - 1] >> 8)) {
+                hll_free(hll);
+                return NULL;
+            }
+        }
+    }
+    return hll;
+}
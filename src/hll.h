@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * HyperLogLog, distinct keys counting in fixed memory.
+ *
+ * A hll of precision p has 2^p registers (6 bits values, one byte each)
+ * and a standard error of about 1.04 / sqrt(2^p), 0.81% for the default
+ * p = 14 in 16kb. Small sets use the sparse encoding, a sorted array of
+ * (register, value) pairs that turns dense once it would take 1/4 of the
+ * dense registers.
+ *
+ * Keys are hashed by `hash_bytes` with a fixed seed (stored with the
+ * hll), so hlls built in different processes can be merged. Dumps are in
+ * host byte order.
+ */
+
+#ifndef __HLL_H
+#define __HLL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+#include "buf.h"
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HLL_MAGIC 0x31304c4c480000ULL    // "\0\0HLL01"
+#define HLL_PRECISION_MIN 4
+#define HLL_PRECISION_MAX 18
+#define HLL_PRECISION_DEFAULT 14
+#define HLL_SEED 0x68797065726c6f67ULL   // default hash seed
+
+typedef enum {
+    HLL_OK = 0,
+    HLL_ENOMEM = -1,        /* No memory error */
+    HLL_EMISMATCH = -2,     /* Precisions or seeds differ */
+} hll_error_t;
+
+typedef struct hll_header_st {
+    uint64_t magic;
+    uint64_t precision;
+    uint64_t seed;
+    uint64_t dense;                  /* 1 if dense, 0 if sparse */
+    uint64_t sparse_size;            /* pairs number if sparse */
+} hll_header_t;
+
+typedef struct hll_st {
+    size_t precision;                /* log2(registers number) */
+    uint64_t seed;                   /* hash_bytes seed */
+    uint8_t *registers;              /* dense registers, or NULL */
+    uint32_t *sparse;                /* sorted register << 8 | value */
+    size_t sparse_size;
+    size_t sparse_cap;
+} hll_t;
+
+hll_t *hll_new(size_t);
+void hll_free(hll_t *);
+void hll_clear(hll_t *);
+int hll_add(hll_t *, uint8_t *, size_t);
+int hll_add_hash(hll_t *, uint64_t);
+uint64_t hll_count(hll_t *);
+int hll_merge(hll_t *, hll_t *);
+int hll_dump(hll_t *, buf_t *);
+hll_t *hll_load(uint8_t *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,402 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "htable.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define CTRL_EMPTY ((int8_t)-128)   // 0b10000000
+#define CTRL_DELETED ((int8_t)-2)   // 0b11111110
+
+/**
+ * Max entries number a table with `cap` slots can hold (7/8).
+ */
+static size_t
+cap_to_growth(size_t cap)
+{
+    return cap - cap / 8;
+}
+
+/**
+ * Match a group's control bytes against `ch`, returns a bitmask with one bit
+ * per matched slot.
+ */
+static uint32_t
+group_match(int8_t *group, int8_t ch)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl,
+                _mm_set1_epi8(ch)));
+#else
+    uint32_t mask = 0;
+    size_t i;
+
+    for (i = 0; i < HTABLE_GROUP_WIDTH; i++)
+        if (group[i] == ch)
+            mask |= 1U << i;
+    return mask;
+#endif
+}
+
+/**
+ * Match a group's empty or deleted slots.
+ */
+static uint32_t
+group_match_free(int8_t *group)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    size_t i;
+
+    for (i = 0; i < HTABLE_GROUP_WIDTH; i++)
+        if (group[i] < 0)
+            mask |= 1U << i;
+    return mask;
+#endif
+}
+
+/**
+ * Allocate control bytes and slots for `cap` slots in one block.
+ */
+static int
+htable_alloc(htable_t *htable, size_t cap)
+{
+    assert(cap >= HTABLE_CAP_MIN && (cap & (cap - 1)) == 0);
+
+    int8_t *ctrl = malloc(cap + cap * sizeof(htable_slot_t));
+
+    if (ctrl == NULL)
+        return HTABLE_ENOMEM;
+
+    memset(ctrl, CTRL_EMPTY, cap);
+    htable->ctrl = ctrl;
+    htable->slots = (htable_slot_t *)(ctrl + cap);
+    htable->cap = cap;
+    htable->growth_left = cap_to_growth(cap) - htable->size;
+    return HTABLE_OK;
+}
+
+/**
+ * Find the slot index of a key, returns `htable->cap` if not found.
+ */
+static size_t
+htable_find(htable_t *htable, uint8_t *key, size_t key_len, uint64_t hash)
+{
+    size_t mask = htable->cap / HTABLE_GROUP_WIDTH - 1;
+    size_t group = (hash >> 7) & mask;
+    size_t step = 0;
+    int8_t h2 = (int8_t)(hash & 0x7F);
+
+    while (1) {
+        int8_t *ctrl = htable->ctrl + group * HTABLE_GROUP_WIDTH;
+        uint32_t match = group_match(ctrl, h2);
+
+        while (match != 0) {
+            size_t index = group * HTABLE_GROUP_WIDTH +
+                __builtin_ctz(match);
+            htable_slot_t *slot = &(htable->slots)[index];
+
+            if (slot->hash == hash && slot->key_len == key_len &&
+                    memcmp(slot->key, key, key_len) == 0)
+                return index;
+            match &= match - 1;
+        }
+
+        // an empty slot stops the probe sequence
+        if (group_match(ctrl, CTRL_EMPTY) != 0)
+            return htable->cap;
+
+        // triangular probing visits every group
+        group = (group + ++step) & mask;
+    }
+}
+
+/**
+ * Find the first empty or deleted slot for a hash.
+ */
+static size_t
+htable_find_free(htable_t *htable, uint64_t hash)
+{
+    size_t mask = htable->cap / HTABLE_GROUP_WIDTH - 1;
+    size_t group = (hash >> 7) & mask;
+    size_t step = 0;
+
+    while (1) {
+        uint32_t match = group_match_free(htable->ctrl +
+                group * HTABLE_GROUP_WIDTH);
+
+        if (match != 0)
+            return group * HTABLE_GROUP_WIDTH + __builtin_ctz(match);
+        group = (group + ++step) & mask;
+    }
+}
+
+/**
+ * Resize && Rehash, grows if the table is more than half full, else just
+ * drops the deleted slots.
+ */
+static int
+htable_resize(htable_t *htable)
+{
+    assert(htable != NULL);
+
+    int8_t *ctrl = htable->ctrl;
+    htable_slot_t *slots = htable->slots;
+    size_t cap = htable->cap;
+    size_t new_cap = cap;
+
+    if (htable->size * 2 > cap_to_growth(cap))
+        new_cap = cap * 2;
+
+    if (htable_alloc(htable, new_cap) != HTABLE_OK)
+        return HTABLE_ENOMEM;
+
+    size_t index;
+
+    for (index = 0; index < cap; index++) {
+        if (ctrl[index] < 0)
+            continue;
+
+        size_t new_index = htable_find_free(htable, slots[index].hash);
+        (htable->ctrl)[new_index] = ctrl[index];
+        (htable->slots)[new_index] = slots[index];
+    }
+
+    free(ctrl);
+    return HTABLE_OK;
+}
+
+/**
+ * New htable.
+ */
+htable_t *
+htable_new(void)
+{
+    htable_t *htable = malloc(sizeof(htable_t));
+
+    if (htable != NULL) {
+        htable->size = 0;
+        htable->seed = hash_seed();
+
+        if (htable_alloc(htable, HTABLE_CAP_MIN) != HTABLE_OK) {
+            free(htable);
+            return NULL;
+        }
+    }
+    return htable;
+}
+
+/**
+ * Free htable.
+ */
+void
+htable_free(htable_t *htable)
+{
+    if (htable != NULL) {
+        if (htable->ctrl != NULL)
+            free(htable->ctrl);
+        free(htable);
+    }
+}
+
+/**
+ * Clear htable, O(cap).
+ */
+void
+htable_clear(htable_t *htable)
+{
+    assert(htable != NULL);
+
+    memset(htable->ctrl, CTRL_EMPTY, htable->cap);
+    htable->size = 0;
+    htable->growth_left = cap_to_growth(htable->cap);
+}
+
+/**
+ * Set a key to htable.
+ */
+int
+htable_set(htable_t *htable, uint8_t *key, size_t key_len, void *val)
+{
+    assert(htable != NULL);
+
+    uint64_t hash = hash_bytes(key, key_len, htable->seed);
+    size_t index = htable_find(htable, key, key_len, hash);
+
+    if (index != htable->cap) {
+        htable_slot_t *slot = &(htable->slots)[index];
+        slot->key = key;
+        slot->val = val;
+        return HTABLE_OK;
+    }
+
+    index = htable_find_free(htable, hash);
+
+    // taking an empty slot (not a deleted one) consumes growth
+    if ((htable->ctrl)[index] == CTRL_EMPTY && htable->growth_left == 0) {
+        if (htable_resize(htable) != HTABLE_OK)
+            return HTABLE_ENOMEM;
+        index = htable_find_free(htable, hash);
+    }
+
+    if ((htable->ctrl)[index] == CTRL_EMPTY)
+        htable->growth_left -= 1;
+
+    htable_slot_t *slot = &(htable->slots)[index];
+    slot->key = key;
+    slot->key_len = key_len;
+    slot->hash = hash;
+    slot->val = val;
+    (htable->ctrl)[index] = (int8_t)(hash & 0x7F);
+    htable->size += 1;
+    return HTABLE_OK;
+}
+
+/**
+ * Get val from htable by key.
+ */
+void *
+htable_get(htable_t *htable, uint8_t *key, size_t key_len)
+{
+    assert(htable != NULL);
+
+    size_t index = htable_find(htable, key, key_len,
+            hash_bytes(key, key_len, htable->seed));
+
+    if (index == htable->cap)
+        return NULL;
+    return (htable->slots)[index].val;
+}
+
+/**
+ * Test if a key is in the htable.
+ */
+bool
+htable_has(htable_t *htable, uint8_t *key, size_t key_len)
+{
+    assert(htable != NULL);
+
+    return htable_find(htable, key, key_len,
+            hash_bytes(key, key_len, htable->seed)) != htable->cap;
+}
+
+/**
+ * Del val from htable by key.
+ */
+int
+htable_del(htable_t *htable, uint8_t *key, size_t key_len)
+{
+    assert(htable != NULL);
+
+    size_t index = htable_find(htable, key, key_len,
+            hash_bytes(key, key_len, htable->seed));
+
+    if (index == htable->cap)
+        return HTABLE_ENOTFOUND;
+
+    // a group with an empty slot was never full, so no probe sequence
+    // ever passed through it, the slot can be marked empty again.
+    int8_t *group = htable->ctrl + (index & ~(size_t)(HTABLE_GROUP_WIDTH - 1));
+
+    if (group_match(group, CTRL_EMPTY) != 0) {
+        (htable->ctrl)[index] = CTRL_EMPTY;
+        htable->growth_left += 1;
+    } else {
+        (htable->ctrl)[index] = CTRL_DELETED;
+    }
+
+    htable->size -= 1;
+    return HTABLE_OK;
+}
+
+/**
+ * Get htable size.
+ */
+size_t
+htable_size(htable_t *htable)
+{
+    assert(htable != NULL);
+    return htable->size;
+}
+
+/**
+ * New htable iterator.
+ */
+htable_iterator_t *
+htable_iterator_new(htable_t *htable)
+{
+    assert(htable != NULL);
+
+    htable_iterator_t *iterator = malloc(sizeof(htable_iterator_t));
+
+    if (iterator != NULL) {
+        iterator->htable = htable;
+        iterator->index = 0;
+    }
+    return iterator;
+}
+
+/**
+ * Free htable iterator.
+ */
+void
+htable_iterator_free(htable_iterator_t *iterator)
+{
+    if (iterator != NULL)
+        free(iterator);
+}
+
+/**
+ * Get next key and val.
+ */
+int
+htable_iterator_next(htable_iterator_t *iterator, uint8_t **key_addr,
+        size_t *key_len_addr, void **val_addr)
+{
+    assert(iterator != NULL && iterator->htable != NULL);
+
+    htable_t *htable = iterator->htable;
+
+    // seek to a full slot
+    while (iterator->index < htable->cap &&
+            (htable->ctrl)[iterator->index] < 0)
+        iterator->index++;
+
+    if (iterator->index == htable->cap)
+        return HTABLE_ENOTFOUND;
+
+    htable_slot_t *slot = &(htable->slots)[iterator->index++];
+    *key_addr = slot->key;
+    *key_len_addr = slot->key_len;
+    *val_addr = slot->val;
+    return HTABLE_OK;
+}
+
+/**
+ * Reset a htable iterator.
+ */
+void
+htable_iterator_reset(htable_iterator_t *iterator)
+{
+    assert(iterator != NULL);
+    iterator->index = 0;
+}
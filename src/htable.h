@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Open addressing hashtable implementation (swiss table).
+ *
+ * Same api as dict, but entries are stored inline in a flat slots array,
+ * each slot has one control byte, control bytes are scanned 16 at a time
+ * (with SSE2 if available).
+ *
+ *   control byte: 0b1000_0000  empty
+ *                 0b1111_1110  deleted
+ *                 0b0xxx_xxxx  full (lowest 7 bits of hash)
+ */
+
+#ifndef __HTABLE_H
+#define __HTABLE_H
+
+#include <memory.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "bool.h"
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTABLE_GROUP_WIDTH 16   // slots per probe group
+#define HTABLE_CAP_MIN 16       // min slots (one group)
+
+typedef enum {
+    HTABLE_OK = 0,
+    HTABLE_ENOMEM = -1,      /* No memory error */
+    HTABLE_ENOTFOUND = -2,   /* Key was not found */
+} htable_error_t;
+
+typedef struct htable_slot_st {
+    uint8_t *key;
+    size_t key_len;
+    uint64_t hash;
+    void *val;
+} htable_slot_t;
+
+typedef struct htable_st {
+    int8_t *ctrl;                    /* control bytes, one per slot */
+    htable_slot_t *slots;            /* flat slots array */
+    size_t cap;                      /* slots number (power of 2) */
+    size_t size;                     /* entries number */
+    size_t growth_left;              /* inserts left before rehash */
+    uint64_t seed;                   /* hash seed */
+} htable_t;
+
+typedef struct htable_iterator_st {
+    htable_t *htable;
+    size_t index;
+} htable_iterator_t;
+
+htable_t *htable_new(void);
+void htable_free(htable_t *);
+void htable_clear(htable_t *);
+int htable_set(htable_t *, uint8_t *, size_t, void *);
+void *htable_get(htable_t *, uint8_t *, size_t);
+bool htable_has(htable_t *, uint8_t *, size_t);
+int htable_del(htable_t *, uint8_t *, size_t);
+size_t htable_size(htable_t *);
+htable_iterator_t *htable_iterator_new(htable_t *);
+void htable_iterator_free(htable_iterator_t *);
+int htable_iterator_next(htable_iterator_t *, uint8_t **, size_t *, void **);
+void htable_iterator_reset(htable_iterator_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,386 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "idict.h"
+
+/**
+ * Get the bucket index of a key in a table.
+ */
+static size_t
+idict_index(idict_t *idict, size_t table_size, uint64_t key)
+{
+    return (size_t)hash_u64(key, idict->seed) & (table_size - 1);
+}
+
+/**
+ * New table (all buckets empty).
+ */
+static idict_node_t **
+idict_table_new(size_t table_size)
+{
+    return calloc(table_size, sizeof(idict_node_t *));
+}
+
+/**
+ * Start resizing to double size, the nodes are moved to the new table by
+ * `idict_rehash` bucket by bucket later.
+ */
+static int
+idict_resize(idict_t *idict)
+{
+    assert(idict->rehash_table == NULL);
+
+    idict_node_t **table = idict_table_new(idict->table_size * 2);
+
+    if (table == NULL)
+        return IDICT_ENOMEM;
+
+    idict->rehash_table = idict->table;
+    idict->rehash_table_size = idict->table_size;
+    idict->rehash_index = 0;
+    idict->table = table;
+    idict->table_size *= 2;
+    return IDICT_OK;
+}
+
+/**
+ * Rehash at most `n` buckets from the old table to the new table. Returns
+ * true if there are still buckets to rehash. Nothing is rehashed while
+ * iterators pause rehashing (returns false).
+ */
+bool
+idict_rehash(idict_t *idict, size_t n)
+{
+    assert(idict != NULL);
+
+    if (idict->rehash_table == NULL || idict->rehash_paused > 0)
+        return false;
+
+    size_t empty_visits = n * 10;  // max empty buckets to skip
+
+    while (n > 0 && idict->rehash_index < idict->rehash_table_size) {
+        idict_node_t *node = (idict->rehash_table)[idict->rehash_index];
+
+        if (node == NULL) {
+            idict->rehash_index++;
+            if (--empty_visits == 0)
+                break;
+            continue;
+        }
+
+        while (node != NULL) {
+            idict_node_t *next_node = node->next;
+            size_t index = idict_index(idict, idict->table_size, node->key);
+            node->next = (idict->table)[index];
+            (idict->table)[index] = node;
+            node = next_node;
+        }
+
+        (idict->rehash_table)[idict->rehash_index++] = NULL;
+        n--;
+    }
+
+    if (idict->rehash_index < idict->rehash_table_size)
+        return true;
+
+    free(idict->rehash_table);
+    idict->rehash_table = NULL;
+    idict->rehash_table_size = 0;
+    idict->rehash_index = 0;
+    return false;
+}
+
+/**
+ * Rehash a step if rehashing and not paused.
+ */
+static void
+idict_rehash_step(idict_t *idict)
+{
+    if (idict->rehash_table != NULL && idict->rehash_paused == 0)
+        idict_rehash(idict, IDICT_REHASH_STEP);
+}
+
+/**
+ * Find the link to a key's node, the old table is also looked up if the
+ * key's bucket there is not rehashed yet. Returns NULL if not found.
+ */
+static idict_node_t **
+idict_find(idict_t *idict, uint64_t key)
+{
+    idict_node_t **link;
+
+    if (idict->rehash_table != NULL) {
+        size_t index = idict_index(idict, idict->rehash_table_size, key);
+
+        if (index >= idict->rehash_index) {
+            for (link = &(idict->rehash_table)[index]; *link != NULL;
+                    link = &(*link)->next)
+                if ((*link)->key == key)
+                    return link;
+        }
+    }
+
+    for (link = &(idict->table)[idict_index(idict, idict->table_size, key)];
+            *link != NULL; link = &(*link)->next)
+        if ((*link)->key == key)
+            return link;
+    return NULL;
+}
+
+/**
+ * New idict.
+ */
+idict_t *
+idict_new()
+{
+    idict_t *idict = malloc(sizeof(idict_t));
+
+    if (idict != NULL) {
+        idict->table_size = IDICT_TABLE_SIZE_MIN;
+        idict->rehash_table = NULL;
+        idict->rehash_table_size = 0;
+        idict->rehash_index = 0;
+        idict->rehash_paused = 0;
+        idict->size = 0;
+        idict->seed = hash_seed();
+        idict->pool = pool_new(sizeof(idict_node_t));
+        idict->table = idict_table_new(idict->table_size);
+
+        if (idict->pool == NULL || idict->table == NULL) {
+            pool_free(idict->pool);
+            free(idict->table);
+            free(idict);
+            return NULL;
+        }
+    }
+    return idict;
+}
+
+/**
+ * Free idict.
+ */
+void
+idict_free(idict_t *idict)
+{
+    if (idict != NULL) {
+        free(idict->rehash_table);
+        free(idict->table);
+        pool_free(idict->pool);
+        free(idict);
+    }
+}
+
+/**
+ * Clear idict, nodes are released all at once, O(buckets).
+ */
+void
+idict_clear(idict_t *idict)
+{
+    assert(idict != NULL);
+
+    if (idict->rehash_table != NULL) {
+        free(idict->rehash_table);
+        idict->rehash_table = NULL;
+        idict->rehash_table_size = 0;
+        idict->rehash_index = 0;
+    }
+
+    memset(idict->table, 0, idict->table_size * sizeof(idict_node_t *));
+    pool_clear(idict->pool);
+    idict->size = 0;
+}
+
+/**
+ * Set a key to idict.
+ */
+int
+idict_set(idict_t *idict, uint64_t key, void *val)
+{
+    assert(idict != NULL);
+
+    if (idict->rehash_table == NULL && idict->rehash_paused == 0 &&
+            idict->size >= idict->table_size * IDICT_LOAD_LIMIT &&
+            idict_resize(idict) != IDICT_OK)
+        return IDICT_ENOMEM;
+
+    idict_rehash_step(idict);
+
+    idict_node_t **link = idict_find(idict, key);
+
+    if (link != NULL) {
+        (*link)->val = val;
+        return IDICT_OK;
+    }
+
+    idict_node_t *node = pool_alloc(idict->pool);
+
+    if (node == NULL)
+        return IDICT_ENOMEM;
+
+    idict_node_t **bucket = &(idict->table)[idict_index(idict,
+            idict->table_size, key)];
+    node->key = key;
+    node->val = val;
+    node->next = *bucket;
+    *bucket = node;
+    idict->size += 1;
+    return IDICT_OK;
+}
+
+/**
+ * Get val from idict by key.
+ */
+void *
+idict_get(idict_t *idict, uint64_t key)
+{
+    assert(idict != NULL);
+
+    idict_rehash_step(idict);
+
+    idict_node_t **link = idict_find(idict, key);
+
+    if (link == NULL)
+        return NULL;
+    return (*link)->val;
+}
+
+/**
+ * Test if a key is in the idict.
+ */
+bool
+idict_has(idict_t *idict, uint64_t key)
+{
+    assert(idict != NULL);
+
+    idict_rehash_step(idict);
+
+    return idict_find(idict, key) != NULL;
+}
+
+/**
+ * Del val from idict by key.
+ */
+int
+idict_del(idict_t *idict, uint64_t key)
+{
+    assert(idict != NULL);
+
+    idict_rehash_step(idict);
+
+    idict_node_t **link = idict_find(idict, key);
+
+    if (link == NULL)
+        return IDICT_ENOTFOUND;
+
+    idict_node_t *node = *link;
+    *link = node->next;
+    pool_dealloc(idict->pool, node);
+    idict->size -= 1;
+    return IDICT_OK;
+}
+
+/**
+ * Get idict size.
+ */
+size_t
+idict_size(idict_t *idict)
+{
+    assert(idict != NULL);
+    return idict->size;
+}
+
+/**
+ * New idict iterator, rehashing is paused until the iterator is freed.
+ */
+idict_iterator_t *
+idict_iterator_new(idict_t *idict)
+{
+    assert(idict != NULL);
+
+    idict_iterator_t *iterator = malloc(sizeof(idict_iterator_t));
+
+    if (iterator != NULL) {
+        iterator->idict = idict;
+        idict->rehash_paused += 1;
+        idict_iterator_reset(iterator);
+    }
+    return iterator;
+}
+
+/**
+ * Free idict iterator.
+ */
+void
+idict_iterator_free(idict_iterator_t *iterator)
+{
+    if (iterator != NULL) {
+        assert(iterator->idict->rehash_paused > 0);
+        iterator->idict->rehash_paused -= 1;
+        free(iterator);
+    }
+}
+
+/**
+ * Get next key and val.
+ */
+int
+idict_iterator_next(idict_iterator_t *iterator, uint64_t *key_addr,
+        void **val_addr)
+{
+    assert(iterator != NULL && iterator->idict != NULL);
+
+    idict_t *idict = iterator->idict;
+
+    while (iterator->node == NULL) {
+        if (iterator->index == iterator->table_size) {
+            if (iterator->table == idict->table)
+                return IDICT_ENOTFOUND;
+            // old table done, walk the new table
+            iterator->table = idict->table;
+            iterator->table_size = idict->table_size;
+            iterator->index = 0;
+            continue;
+        }
+        iterator->node = (iterator->table)[iterator->index++];
+    }
+
+    *key_addr = iterator->node->key;
+    *val_addr = iterator->node->val;
+    iterator->node = iterator->node->next;
+    return IDICT_OK;
+}
+
+/**
+ * Reset an idict iterator.
+ */
+void
+idict_iterator_reset(idict_iterator_t *iterator)
+{
+    assert(iterator != NULL && iterator->idict != NULL);
+
+    idict_t *idict = iterator->idict;
+
+    if (idict->rehash_table != NULL) {
+        iterator->table = idict->rehash_table;
+        iterator->table_size = idict->rehash_table_size;
+    } else {
+        iterator->table = idict->table;
+        iterator->table_size = idict->table_size;
+    }
+
+    iterator->node = NULL;
+    iterator->index = 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Integer keyed hashtable (uint64 => pointer).
+ *
+ * Same design as dict: power of 2 tables, pooled nodes and incremental
+ * rehashing, but keys are stored inline in the nodes, hashed by the
+ * `hash_u64` mixer and compared as one integer.
+ */
+
+#ifndef __IDICT_H
+#define __IDICT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+#include "hash.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IDICT_TABLE_SIZE_MIN 8   // min table size
+#define IDICT_LOAD_LIMIT 1       // max nodes per bucket on average
+#define IDICT_REHASH_STEP 1      // buckets to migrate per operation
+
+typedef enum {
+    IDICT_OK = 0,
+    IDICT_ENOMEM = -1,      /* No memory error */
+    IDICT_ENOTFOUND = -2,   /* Key was not found */
+} idict_error_t;
+
+typedef struct idict_node_st {
+    uint64_t key;
+    void *val;
+    struct idict_node_st *next;
+} idict_node_t;
+
+typedef struct idict_st {
+    idict_node_t **table;            /* buckets table */
+    size_t table_size;               /* power of 2 */
+    idict_node_t **rehash_table;     /* old table in rehashing, or NULL */
+    size_t rehash_table_size;
+    size_t rehash_index;             /* next bucket to rehash */
+    size_t rehash_paused;            /* number of iterators pausing rehash */
+    size_t size;                     /* nodes number */
+    uint64_t seed;                   /* hash seed */
+    pool_t *pool;                    /* nodes pool */
+} idict_t;
+
+typedef struct idict_iterator_st {
+    idict_node_t *node;
+    idict_t *idict;
+    idict_node_t **table;            /* table walking on */
+    size_t table_size;
+    size_t index;
+} idict_iterator_t;
+
+idict_t *idict_new();
+void idict_free(idict_t *);
+void idict_clear(idict_t *);
+int idict_set(idict_t *, uint64_t, void *);
+void *idict_get(idict_t *, uint64_t);
+bool idict_has(idict_t *, uint64_t);
+int idict_del(idict_t *, uint64_t);
+size_t idict_size(idict_t *);
+bool idict_rehash(idict_t *, size_t);
+idict_iterator_t *idict_iterator_new(idict_t *);
+void idict_iterator_free(idict_iterator_t *);
+int idict_iterator_next(idict_iterator_t *, uint64_t *, void **);
+void idict_iterator_reset(idict_iterator_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "intern.h"
+
+/**
+ * Get the header of a canonical string.
+ */
+static intern_header_t *
+intern_header(uint8_t *str)
+{
+    return (intern_header_t *)str - 1;
+}
+
+/**
+ * New empty intern table.
+ */
+intern_t *
+intern_new()
+{
+    intern_t *interns = malloc(sizeof(intern_t));
+
+    if (interns != NULL) {
+        interns->dict = dict_new();
+        interns->arena = arena_new();
+        interns->strs = NULL;
+        interns->cap = 0;
+
+        if (interns->dict == NULL || interns->arena == NULL) {
+            dict_free(interns->dict);
+            arena_free(interns->arena);
+            free(interns);
+            return NULL;
+        }
+    }
+    return interns;
+}
+
+/**
+ * Free intern table and all canonical strings.
+ */
+void
+intern_free(intern_t *interns)
+{
+    if (interns != NULL) {
+        dict_free(interns->dict);
+        arena_free(interns->arena);
+        free(interns->strs);
+        free(interns);
+    }
+}
+
+/**
+ * Clear intern table, canonical strings are released all at once and IDs
+ * start from 0 again.
+ */
+void
+intern_clear(intern_t *interns)
+{
+    assert(interns != NULL);
+    dict_clear(interns->dict);
+    arena_clear(interns->arena);
+}
+
+/**
+ * Intern a byte range, returns its canonical string (the same pointer for
+ * equal bytes), or NULL on no memory.
+ */
+uint8_t *
+intern_put(intern_t *interns, uint8_t *data, size_t len)
+{
+    assert(interns != NULL);
+
+    uint64_t hash = dict_hash(interns->dict, data, len);
+    dict_node_t *node = dict_lookup(interns->dict, data, len, hash);
+
+    if (node != NULL)
+        return node->val;
+
+    size_t id = dict_size(interns->dict);
+
+    if (id == interns->cap) {
+        size_t cap = interns->cap * 2;
+
+        if (cap < INTERN_IDS_CAP_MIN)
+            cap = INTERN_IDS_CAP_MIN;
+
+        uint8_t **strs = realloc(interns->strs, cap * sizeof(uint8_t *));
+
+        if (strs == NULL)
+            return NULL;
+
+        interns->strs = strs;
+        interns->cap = cap;
+    }
+
+    intern_header_t *header = arena_alloc(interns->arena,
+            sizeof(intern_header_t) + len + 1);
+
+    if (header == NULL)
+        return NULL;
+
+    uint8_t *str = (uint8_t *)(header + 1);
+
+    header->id = id;
+    header->len = len;
+    memcpy(str, data, len);
+    str[len] = 0;
+
+    if (dict_set_hashed(interns->dict, str, len, hash, str) != DICT_OK)
+        return NULL;
+
+    (interns->strs)[id] = str;
+    return str;
+}
+
+/**
+ * Get the canonical string of a byte range without interning it, NULL if
+ * not interned.
+ */
+uint8_t *
+intern_get(intern_t *interns, uint8_t *data, size_t len)
+{
+    assert(interns != NULL);
+
+    dict_node_t *node = dict_lookup(interns->dict, data, len,
+            dict_hash(interns->dict, data, len));
+
+    if (node != NULL)
+        return node->val;
+    return NULL;
+}
+
+/**
+ * Get the canonical string by ID, NULL if out of range.
+ */
+uint8_t *
+intern_str(intern_t *interns, size_t id)
+{
+    assert(interns != NULL);
+
+    if (id >= dict_size(interns->dict))
+        return NULL;
+    return (interns->strs)[id];
+}
+
+/**
+ * Get the ID of a canonical string.
+ */
+size_t
+intern_id(uint8_t *str)
+{
+    assert(str != NULL);
+    return intern_header(str)->id;
+}
+
+/**
+ * Get the length of a canonical string.
+ */
+size_t
+intern_len(uint8_t *str)
+{
+    assert(str != NULL);
+    return intern_header(str)->len;
+}
+
+/**
+ * Get the number of interned strings.
+ */
+size_t
+intern_size(intern_t *interns)
+{
+    assert(interns != NULL);
+    return dict_size(interns->dict);
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * String interning (dict based).
+ *
+ *   uint8_t *a = intern_put(interns, (uint8_t *)"foo", 3);
+ *   uint8_t *b = intern_put(interns, buf->data, buf->size);
+ *   if (a == b) ... // equal strings share one canonical copy
+ *
+ * Canonical strings are copied once into an arena, NUL terminated, and
+ * stay valid until `intern_clear`/`intern_free`. Each gets a sequential ID
+ * (from 0), stored before its bytes with its length, so both are O(1).
+ */
+
+#ifndef __INTERN_H
+#define __INTERN_H
+
+#include "arena.h"
+#include "dict.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTERN_IDS_CAP_MIN 64  // min capacity of the ids array
+
+typedef struct intern_header_st {
+    size_t id;
+    size_t len;
+} intern_header_t;
+
+typedef struct intern_st {
+    dict_t *dict;                    /* bytes => canonical string */
+    arena_t *arena;                  /* canonical strings */
+    uint8_t **strs;                  /* canonical strings by id */
+    size_t cap;                      /* capacity of strs */
+} intern_t;
+
+intern_t *intern_new();
+void intern_free(intern_t *);
+void intern_clear(intern_t *);
+uint8_t *intern_put(intern_t *, uint8_t *, size_t);
+uint8_t *intern_get(intern_t *, uint8_t *, size_t);
+uint8_t *intern_str(intern_t *, size_t);
+size_t intern_id(uint8_t *);
+size_t intern_len(uint8_t *);
+size_t intern_size(intern_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
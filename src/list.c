@@ -17,12 +17,12 @@
 #include "list.h"
 
 /**
- * New list node.
+ * New list node (from the list's pool).
  */
 list_node_t *
-list_node_new(void *data)
+list_node_new(list_t *list, void *data)
 {
-    list_node_t *node = malloc(sizeof(list_node_t));
+    list_node_t *node = pool_alloc(list->pool);
 
     if (node != NULL) {
         node->data = data;
@@ -36,10 +36,10 @@ list_node_new(void *data)
  * Free list node.
  */
 void
-list_node_free(list_node_t *node)
+list_node_free(list_t *list, list_node_t *node)
 {
     if (node != NULL)
-        free(node);
+        pool_dealloc(list->pool, node);
 }
 
 /**
@@ -54,6 +54,12 @@ list_new(void)
         list->head = NULL;
         list->tail = NULL;
         list->size = 0;
+        list->pool = pool_new(sizeof(list_node_t));
+
+        if (list->pool == NULL) {
+            free(list);
+            return NULL;
+        }
     }
     return list;
 }
@@ -65,19 +71,22 @@ void
 list_free(list_t *list)
 {
     if (list != NULL) {
-        list_clear(list);
+        pool_free(list->pool);
         free(list);
     }
 }
 
 /**
- * Clear list.
+ * Clear list, nodes are released all at once, O(slabs).
  */
 void
 list_clear(list_t *list)
 {
     assert(list != NULL);
-    while(list_lpop(list) != NULL);
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+    pool_clear(list->pool);
 }
 
 /**
@@ -88,7 +97,7 @@ list_lpush(list_t *list, void *item)
 {
     assert(list != NULL);
 
-    list_node_t *node = list_node_new(item);
+    list_node_t *node = list_node_new(list, item);
 
     if (node == NULL)
         return LIST_ENOMEM;
@@ -118,7 +127,7 @@ list_rpush(list_t *list, void *item)
 {
     assert(list != NULL);
 
-    list_node_t *node = list_node_new(item);
+    list_node_t *node = list_node_new(list, item);
 
     if(node == NULL)
         return LIST_ENOMEM;
@@ -168,7 +177,7 @@ list_lpop(list_t *list)
     list->size -= 1;
 
     void *data = head->data;
-    list_node_free(head);
+    list_node_free(list, head);
     return data;
 }
 
@@ -200,7 +209,7 @@ list_rpop(list_t *list)
     list->size -= 1;
 
     void *data = tail->data;
-    list_node_free(tail);
+    list_node_free(list, tail);
     return data;
 }
 
@@ -325,7 +334,7 @@ list_del(list_t *list, size_t index)
             else
                 list->tail = prev;
             list->size -= 1;
-            list_node_free(node);
+            list_node_free(list, node);
             return LIST_OK;
         }
         node = node->next;
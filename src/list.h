@@ -34,6 +34,8 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include "pool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -54,14 +56,15 @@ typedef struct list_st {
     list_node_t *head;
     list_node_t *tail;
     size_t size;
+    pool_t *pool;                    /* nodes pool */
 } list_t;
 
 typedef struct list_iterator_st {
     list_node_t *node;
 } list_iterator_t;
 
-list_node_t *list_node_new(void *);
-void list_node_free(list_node_t *);
+list_node_t *list_node_new(list_t *, void *);
+void list_node_free(list_t *, list_node_t *);
 list_t *list_new(void);
 void list_free(list_t *);
 void list_clear(list_t *);
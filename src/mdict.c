@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mdict.h"
+
+/**
+ * Get the 8 bytes aligned size of a record.
+ */
+static uint64_t
+mdict_record_size(uint64_t key_len, uint64_t val_len)
+{
+    return (sizeof(mdict_record_t) + key_len + val_len + 7) & ~(uint64_t)7;
+}
+
+/**
+ * Write the records of a dict into `data` (mapped file of `file_size`
+ * bytes), `offsets` holds each bucket's size in bytes and is reused as
+ * write cursors.
+ */
+static int
+mdict_fill(dict_t *dict, mdict_val_func_t val_func, uint8_t *data,
+        uint64_t *offsets, mdict_header_t *header)
+{
+    uint64_t *index = (uint64_t *)(data + header->index_offset);
+    uint8_t *records = data + header->data_offset;
+    uint64_t mask = header->buckets - 1, bucket, offset = 0;
+
+    for (bucket = 0; bucket < header->buckets; bucket++) {
+        index[bucket] = offset;
+        offset += offsets[bucket];
+        offsets[bucket] = index[bucket];
+    }
+    index[header->buckets] = offset;
+
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+
+    if (iterator == NULL)
+        return MDICT_ENOMEM;
+
+    uint8_t *key, *val;
+    size_t key_len;
+    void *dict_val;
+
+    while (dict_iterator_next(iterator, &key, &key_len, &dict_val) ==
+            DICT_OK) {
+        uint64_t hash = hash_bytes(key, key_len, header->seed);
+        uint64_t val_len = val_func(dict_val, &val);
+        mdict_record_t *record = (mdict_record_t *)
+            (records + offsets[hash & mask]);
+
+        record->hash = hash;
+        record->key_len = key_len;
+        record->val_len = val_len;
+        memcpy(record + 1, key, key_len);
+        memcpy((uint8_t *)(record + 1) + key_len, val, val_len);
+        offsets[hash & mask] += mdict_record_size(key_len, val_len);
+    }
+
+    dict_iterator_free(iterator);
+    memcpy(data, header, sizeof(mdict_header_t));
+    return MDICT_OK;
+}
+
+/**
+ * Sync the directory of `path`, so that a rename into it is durable.
+ */
+static int
+mdict_sync_dir(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    size_t len = slash == NULL ? 1 : slash == path ? 1 : slash - path;
+    char *dir = malloc(len + 1);
+
+    if (dir == NULL)
+        return MDICT_ENOMEM;
+
+    memcpy(dir, slash == NULL ? "." : path, len);
+    dir[len] = '\0';
+
+    int result = MDICT_EFILE;
+    int fd = open(dir, O_RDONLY);
+
+    if (fd >= 0) {
+        if (fsync(fd) == 0)
+            result = MDICT_OK;
+        close(fd);
+    }
+
+    free(dir);
+    return result;
+}
+
+/**
+ * Dump a dict to file at `path`, vals are converted to bytes by
+ * `val_func`. The file is written to `path.tmp`, synced to disk and then
+ * renamed, so readers never see a partial file, even after a crash.
+ */
+int
+mdict_dump(dict_t *dict, const char *path, mdict_val_func_t val_func)
+{
+    assert(dict != NULL && path != NULL && val_func != NULL);
+
+    mdict_header_t header;
+
+    header.magic = MDICT_MAGIC;
+    header.seed = hash_seed_new();  // readers of the file mustn't learn
+                                    // the process seed
+    header.size = dict_size(dict);
+    header.buckets = 1;
+    header.reserved = 0;
+
+    while (header.buckets < header.size)
+        header.buckets *= 2;
+
+    uint64_t *offsets = calloc(header.buckets, sizeof(uint64_t));
+
+    if (offsets == NULL)
+        return MDICT_ENOMEM;
+
+    // pass 1: bytes per bucket
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+
+    if (iterator == NULL) {
+        free(offsets);
+        return MDICT_ENOMEM;
+    }
+
+    uint8_t *key, *val;
+    size_t key_len;
+    void *dict_val;
+    uint64_t records_size = 0;
+
+    while (dict_iterator_next(iterator, &key, &key_len, &dict_val) ==
+            DICT_OK) {
+        uint64_t hash = hash_bytes(key, key_len, header.seed);
+        uint64_t bytes = mdict_record_size(key_len,
+                val_func(dict_val, &val));
+        offsets[hash & (header.buckets - 1)] += bytes;
+        records_size += bytes;
+    }
+
+    dict_iterator_free(iterator);
+
+    header.index_offset = sizeof(mdict_header_t);
+    header.data_offset = header.index_offset +
+        (header.buckets + 1) * sizeof(uint64_t);
+    header.file_size = header.data_offset + records_size;
+
+    // pass 2: write records to the mapped file
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp = malloc(tmp_len);
+
+    if (tmp == NULL) {
+        free(offsets);
+        return MDICT_ENOMEM;
+    }
+
+    snprintf(tmp, tmp_len, "%s.tmp", path);
+
+    int result = MDICT_EFILE;
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (fd >= 0) {
+        if (ftruncate(fd, header.file_size) == 0) {
+            uint8_t *data = mmap(NULL, header.file_size,
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            if (data != MAP_FAILED) {
+                result = mdict_fill(dict, val_func, data, offsets, &header);
+
+                if (result == MDICT_OK &&
+                        msync(data, header.file_size, MS_SYNC) != 0)
+                    result = MDICT_EFILE;
+                munmap(data, header.file_size);
+            }
+        }
+
+        if (result == MDICT_OK && fsync(fd) != 0)
+            result = MDICT_EFILE;
+        if (close(fd) != 0 && result == MDICT_OK)
+            result = MDICT_EFILE;
+
+        if (result == MDICT_OK && rename(tmp, path) != 0)
+            result = MDICT_EFILE;
+        if (result != MDICT_OK)
+            unlink(tmp);
+        else
+            result = mdict_sync_dir(path);
+    }
+
+    free(tmp);
+    free(offsets);
+    return result;
+}
+
+/**
+ * Test if a mapped file's header is valid and its sections fit the file,
+ * O(1). Bucket offsets are checked by lookups.
+ */
+static bool
+mdict_valid(uint8_t *data, uint64_t file_size)
+{
+    mdict_header_t *header = (mdict_header_t *)data;
+
+    if (header->magic != MDICT_MAGIC || header->file_size != file_size ||
+            header->buckets == 0 ||
+            (header->buckets & (header->buckets - 1)) != 0 ||
+            header->buckets >= file_size / sizeof(uint64_t) ||
+            header->index_offset != sizeof(mdict_header_t) ||
+            header->data_offset != header->index_offset +
+            (header->buckets + 1) * sizeof(uint64_t) ||
+            header->data_offset > file_size)
+        return false;
+
+    uint64_t *index = (uint64_t *)(data + header->index_offset);
+    return index[header->buckets] == file_size - header->data_offset;
+}
+
+/**
+ * Open a dumped dict read only, returns NULL on error (errno is set,
+ * EINVAL for a malformed header or sections not fitting the file).
+ */
+mdict_t *
+mdict_open(const char *path)
+{
+    assert(path != NULL);
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    if ((size_t)st.st_size < sizeof(mdict_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    uint8_t *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return NULL;
+
+    mdict_header_t *header = (mdict_header_t *)data;
+
+    if (!mdict_valid(data, st.st_size)) {
+        munmap(data, st.st_size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    mdict_t *mdict = malloc(sizeof(mdict_t));
+
+    if (mdict == NULL) {
+        munmap(data, st.st_size);
+        return NULL;
+    }
+
+    mdict->data = data;
+    mdict->data_size = st.st_size;
+    mdict->header = header;
+    mdict->index = (uint64_t *)(data + header->index_offset);
+    mdict->records = data + header->data_offset;
+    return mdict;
+}
+
+/**
+ * Close a mdict.
+ */
+void
+mdict_close(mdict_t *mdict)
+{
+    if (mdict != NULL) {
+        munmap(mdict->data, mdict->data_size);
+        free(mdict);
+    }
+}
+
+/**
+ * Get val from mdict by key, the val's length is set to `val_len_addr`
+ * (if not NULL). Returns NULL if not found, the val points into the
+ * mapping and is valid until `mdict_close`. A bucket out of the records
+ * or a record running past its bucket (corrupt file) ends the lookup.
+ */
+uint8_t *
+mdict_get(mdict_t *mdict, uint8_t *key, size_t key_len,
+        size_t *val_len_addr)
+{
+    assert(mdict != NULL);
+
+    mdict_header_t *header = mdict->header;
+    uint64_t hash = hash_bytes(key, key_len, header->seed);
+    uint64_t bucket = hash & (header->buckets - 1);
+    uint64_t offset = (mdict->index)[bucket];
+    uint64_t end = (mdict->index)[bucket + 1];
+
+    if (offset > end || end > mdict->data_size - header->data_offset ||
+            (offset & 7) != 0)
+        return NULL;
+
+    while (offset < end) {
+        mdict_record_t *record = (mdict_record_t *)
+            (mdict->records + offset);
+        uint8_t *record_key = (uint8_t *)(record + 1);
+        uint64_t room = end - offset;
+
+        if (room < sizeof(mdict_record_t))
+            return NULL;
+
+        room -= sizeof(mdict_record_t);
+
+        if (record->key_len > room || record->val_len > room -
+                record->key_len)
+            return NULL;
+
+        if (record->hash == hash && record->key_len == key_len &&
+                memcmp(record_key, key, key_len) == 0) {
+            if (val_len_addr != NULL)
+                *val_len_addr = record->val_len;
+            return record_key + key_len;
+        }
+
+        offset += mdict_record_size(record->key_len, record->val_len);
+    }
+    return NULL;
+}
+
+/**
+ * Test if a key is in the mdict.
+ */
+bool
+mdict_has(mdict_t *mdict, uint8_t *key, size_t key_len)
+{
+    return mdict_get(mdict, key, key_len, NULL) != NULL;
+}
+
+/**
+ * Get mdict size.
+ */
+size_t
+mdict_size(mdict_t *mdict)
+{
+    assert(mdict != NULL);
+    return mdict->header->size;
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Memory mapped dict (read only, on disk).
+ *
+ * `mdict_dump` writes a dict into a position independent hash file, and
+ * `mdict_open` maps it read only, lookups work on the mapped pages
+ * directly so opening is O(1) and the pages are shared between processes.
+ *
+ * File layout (native byte order, all sections 8 bytes aligned):
+ *
+ *   header       mdict_header_t
+ *   index        (buckets + 1) uint64 record offsets, bucket i owns the
+ *                records in [index[i], index[i+1])
+ *   records      hash, key_len, val_len (uint64 each), key, val, padding
+ */
+
+#ifndef __MDICT_H
+#define __MDICT_H
+
+#include "dict.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MDICT_MAGIC 0x3130544349444d00ULL  // "\0MDICT01"
+
+typedef enum {
+    MDICT_OK = 0,
+    MDICT_ENOMEM = -1,      /* No memory error */
+    MDICT_EFILE = -2,       /* File error, see errno */
+} mdict_error_t;
+
+/* Get the bytes of a dict val, returns the length */
+typedef size_t (*mdict_val_func_t)(void *, uint8_t **);
+
+typedef struct mdict_header_st {
+    uint64_t magic;
+    uint64_t seed;                   /* hash_bytes seed */
+    uint64_t size;                   /* records number */
+    uint64_t buckets;                /* buckets number (power of 2) */
+    uint64_t index_offset;           /* offset of index */
+    uint64_t data_offset;            /* offset of records */
+    uint64_t file_size;
+    uint64_t reserved;
+} mdict_header_t;
+
+typedef struct mdict_record_st {
+    uint64_t hash;
+    uint64_t key_len;
+    uint64_t val_len;
+} mdict_record_t;
+
+typedef struct mdict_st {
+    uint8_t *data;                   /* mapped file */
+    size_t data_size;
+    mdict_header_t *header;
+    uint64_t *index;
+    uint8_t *records;
+} mdict_t;
+
+int mdict_dump(dict_t *, const char *, mdict_val_func_t);
+mdict_t *mdict_open(const char *);
+void mdict_close(mdict_t *);
+uint8_t *mdict_get(mdict_t *, uint8_t *, size_t, size_t *);
+bool mdict_has(mdict_t *, uint8_t *, size_t);
+size_t mdict_size(mdict_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,394 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <unistd.h>
+
+#include "pdict.h"
+
+typedef struct pdict_job_st {
+    dict_t *dict;
+    uint8_t **keys;
+    size_t *key_lens;
+    void **vals;
+    uint64_t *hashes;                /* keys hashes */
+    bool hashed;                     /* hashes are given */
+    size_t n;                        /* keys number */
+    size_t threads;                  /* workers number */
+    size_t parts;                    /* bucket ranges number (power of 2) */
+    size_t part_shift;               /* bucket index >> part_shift = part */
+    size_t mask;                     /* table size - 1 */
+    size_t *offsets;                 /* threads * parts, scatter offsets */
+    size_t *part_starts;             /* parts + 1, ranges in order */
+    size_t *order;                   /* keys indexes grouped by part */
+    dict_node_t **nodes;             /* preallocated nodes, NULL if used */
+} pdict_job_t;
+
+typedef struct pdict_worker_st {
+    pdict_job_t *job;
+    size_t id;
+    size_t added;                    /* new keys linked */
+} pdict_worker_t;
+
+typedef void *(*pdict_phase_t)(void *);
+
+/**
+ * Get the part (bucket range) of a hash.
+ */
+static size_t
+pdict_part(pdict_job_t *job, uint64_t hash)
+{
+    return ((size_t)hash & job->mask) >> job->part_shift;
+}
+
+/**
+ * Get the keys range [*lo, *hi) of a worker.
+ */
+static void
+pdict_range(pdict_job_t *job, size_t id, size_t *lo, size_t *hi)
+{
+    *lo = job->n * id / job->threads;
+    *hi = job->n * (id + 1) / job->threads;
+}
+
+/**
+ * Phase 1: hash the worker's keys and count them by part.
+ */
+static void *
+pdict_hash_phase(void *arg)
+{
+    pdict_worker_t *worker = arg;
+    pdict_job_t *job = worker->job;
+    size_t *counts = job->offsets + worker->id * job->parts;
+    size_t lo, hi, i;
+
+    pdict_range(job, worker->id, &lo, &hi);
+
+    for (i = lo; i < hi; i++) {
+        if (!job->hashed)
+            (job->hashes)[i] = dict_hash(job->dict, (job->keys)[i],
+                    (job->key_lens)[i]);
+        counts[pdict_part(job, (job->hashes)[i])] += 1;
+    }
+    return NULL;
+}
+
+/**
+ * Phase 2: scatter the worker's keys to their parts, keys keep their
+ * order in a part.
+ */
+static void *
+pdict_scatter_phase(void *arg)
+{
+    pdict_worker_t *worker = arg;
+    pdict_job_t *job = worker->job;
+    size_t *offsets = job->offsets + worker->id * job->parts;
+    size_t lo, hi, i;
+
+    pdict_range(job, worker->id, &lo, &hi);
+
+    for (i = lo; i < hi; i++)
+        (job->order)[offsets[pdict_part(job, (job->hashes)[i])]++] = i;
+    return NULL;
+}
+
+/**
+ * Phase 3: link the keys of the worker's parts into the table, the
+ * buckets of a part are only touched by its worker.
+ */
+static void *
+pdict_link_phase(void *arg)
+{
+    pdict_worker_t *worker = arg;
+    pdict_job_t *job = worker->job;
+    dict_node_t **table = job->dict->table;
+    size_t lo = job->part_starts[job->parts * worker->id / job->threads];
+    size_t hi = job->part_starts[job->parts * (worker->id + 1) /
+        job->threads];
+    size_t j;
+
+    for (j = lo; j < hi; j++) {
+        size_t i = (job->order)[j];
+        uint8_t *key = (job->keys)[i];
+        size_t key_len = (job->key_lens)[i];
+        uint64_t hash = (job->hashes)[i];
+        size_t index = (size_t)hash & job->mask;
+        dict_node_t *node = table[index];
+
+        for (; node != NULL; node = node->next)
+            if (node->hash == hash && node->key_len == key_len &&
+                    memcmp(node->key, key, key_len) == 0)
+                break;
+
+        if (node == NULL) {
+            node = (job->nodes)[j];
+            (job->nodes)[j] = NULL;
+            node->key = key;
+            node->key_len = key_len;
+            node->hash = hash;
+            node->next = table[index];
+            table[index] = node;
+            worker->added += 1;
+        }
+        node->val = (job->vals)[i];
+    }
+    return NULL;
+}
+
+/**
+ * Run a phase on all workers, a worker failed to start runs on the
+ * calling thread.
+ */
+static void
+pdict_run(pdict_worker_t *workers, size_t threads, pdict_phase_t phase)
+{
+    pthread_t tids[PDICT_THREADS_MAX];
+    bool started[PDICT_THREADS_MAX];
+    size_t t;
+
+    for (t = 0; t < threads; t++)
+        started[t] = pthread_create(&tids[t], NULL, phase,
+                &workers[t]) == 0;
+
+    for (t = 0; t < threads; t++) {
+        if (started[t])
+            pthread_join(tids[t], NULL);
+        else
+            phase(&workers[t]);
+    }
+}
+
+/**
+ * Get workers number, 0 for the number of online cpus.
+ */
+static size_t
+pdict_threads(size_t threads)
+{
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    return threads < PDICT_THREADS_MAX ? threads : PDICT_THREADS_MAX;
+}
+
+/**
+ * Load keys on the calling thread.
+ */
+static int
+pdict_load_serial(dict_t *dict, uint8_t **keys, size_t *key_lens,
+        void **vals, uint64_t *hashes, size_t n)
+{
+    size_t i;
+
+    if (hashes == NULL)
+        return dict_set_many(dict, keys, key_lens, vals, n);
+
+    for (i = 0; i < n; i++) {
+        int result = dict_set_hashed(dict, keys[i], key_lens[i], hashes[i],
+                vals[i]);
+
+        if (result != DICT_OK)
+            return result;
+    }
+    return DICT_OK;
+}
+
+/**
+ * Load keys with workers, `hashes` are the keys hashes by the dict's hash
+ * function and seed, or NULL to compute them.
+ */
+static int
+pdict_load(dict_t *dict, uint8_t **keys, size_t *key_lens, void **vals,
+        uint64_t *hashes, size_t n, size_t threads)
+{
+    threads = pdict_threads(threads);
+
+    if (n < PDICT_PARALLEL_MIN || threads == 1 || dict->arena != NULL ||
+            dict->rehash_paused > 0)
+        return pdict_load_serial(dict, keys, key_lens, vals, hashes, n);
+
+    if (dict_reserve(dict, dict->size + n) != DICT_OK)
+        return DICT_ENOMEM;
+    while (dict_rehash(dict, 1024));
+
+    pdict_job_t job;
+    pdict_worker_t workers[PDICT_THREADS_MAX];
+    size_t table_size = dict_table_size(dict);
+    size_t parts = 1, part_bits = 0, added = 0, t, p, j, sum;
+    int result = DICT_OK;
+
+    while (parts < threads * PDICT_PARTS_PER_THREAD && parts < table_size) {
+        parts <<= 1;
+        part_bits++;
+    }
+
+    job.dict = dict;
+    job.keys = keys;
+    job.key_lens = key_lens;
+    job.vals = vals;
+    job.hashes = hashes != NULL ? hashes : malloc(n * sizeof(uint64_t));
+    job.hashed = hashes != NULL;
+    job.n = n;
+    job.threads = threads;
+    job.parts = parts;
+    job.part_shift = 0;
+    job.mask = table_size - 1;
+    job.offsets = calloc(threads * parts, sizeof(size_t));
+    job.part_starts = malloc((parts + 1) * sizeof(size_t));
+    job.order = malloc(n * sizeof(size_t));
+    job.nodes = malloc(n * sizeof(dict_node_t *));
+
+    while (((size_t)1 << (job.part_shift + part_bits)) < table_size)
+        job.part_shift++;
+
+    if (job.hashes == NULL || job.offsets == NULL ||
+            job.part_starts == NULL || job.order == NULL ||
+            job.nodes == NULL) {
+        result = DICT_ENOMEM;
+        goto out;
+    }
+
+    // pools are not thread safe, take all the nodes up front
+    for (j = 0; j < n; j++) {
+        if (((job.nodes)[j] = pool_alloc(dict->pool)) == NULL) {
+            for (; j > 0; j--)
+                pool_dealloc(dict->pool, (job.nodes)[j - 1]);
+            result = DICT_ENOMEM;
+            goto out;
+        }
+    }
+
+    for (t = 0; t < threads; t++) {
+        workers[t].job = &job;
+        workers[t].id = t;
+        workers[t].added = 0;
+    }
+
+    pdict_run(workers, threads, &pdict_hash_phase);
+
+    // counts to offsets, parts first then workers, so that each part
+    // keeps the keys order
+    for (p = 0, sum = 0; p < parts; p++) {
+        (job.part_starts)[p] = sum;
+        for (t = 0; t < threads; t++) {
+            size_t count = (job.offsets)[t * parts + p];
+            (job.offsets)[t * parts + p] = sum;
+            sum += count;
+        }
+    }
+    (job.part_starts)[parts] = sum;
+
+    pdict_run(workers, threads, &pdict_scatter_phase);
+    pdict_run(workers, threads, &pdict_link_phase);
+
+    for (t = 0; t < threads; t++)
+        added += workers[t].added;
+    dict->size += added;
+
+    // nodes left are of keys already in the dict
+    for (j = 0; j < n; j++)
+        if ((job.nodes)[j] != NULL)
+            pool_dealloc(dict->pool, (job.nodes)[j]);
+out:
+    if (!job.hashed)
+        free(job.hashes);
+    free(job.offsets);
+    free(job.part_starts);
+    free(job.order);
+    free(job.nodes);
+    return result;
+}
+
+/**
+ * Set keys to dict with `threads` workers (0 for the number of online
+ * cpus), keys are not copied unless the dict owns its keys.
+ */
+int
+dict_build_parallel(dict_t *dict, uint8_t **keys, size_t *key_lens,
+        void **vals, size_t n, size_t threads)
+{
+    assert(dict != NULL);
+    return pdict_load(dict, keys, key_lens, vals, NULL, n, threads);
+}
+
+/**
+ * Set all keys of `src` to `dst` with `threads` workers (0 for the number
+ * of online cpus), keys in both dicts take the val of `src`. The cached
+ * hashes of `src` are reused if both dicts hash the same way, a pending
+ * rehash of `src` is finished first unless paused. Keys are copied if
+ * `dst` owns its keys, else `dst` points to the keys of `src`, which live
+ * in `src` itself if it owns them: `src` must then outlive `dst`'s use of
+ * them.
+ */
+int
+dict_merge(dict_t *dst, dict_t *src, size_t threads)
+{
+    assert(dst != NULL && src != NULL && dst != src);
+
+    size_t n = dict_size(src), i = 0;
+
+    if (n == 0)
+        return DICT_OK;
+
+    if (src->rehash_paused == 0)
+        while (dict_rehash(src, 1024));
+
+    // small dicts cache no hashes
+    bool hashed = dst->hash == src->hash && dst->seed == src->seed &&
+        src->table != NULL && src->rehash_table == NULL;
+    uint8_t **keys = malloc(n * sizeof(uint8_t *));
+    size_t *key_lens = malloc(n * sizeof(size_t));
+    void **vals = malloc(n * sizeof(void *));
+    uint64_t *hashes = hashed ? malloc(n * sizeof(uint64_t)) : NULL;
+    int result = DICT_ENOMEM;
+
+    if (keys == NULL || key_lens == NULL || vals == NULL ||
+            (hashed && hashes == NULL))
+        goto out;
+
+    if (hashed) {
+        size_t table_size = dict_table_size(src), index;
+
+        for (index = 0; index < table_size; index++) {
+            dict_node_t *node = (src->table)[index];
+
+            for (; node != NULL; node = node->next, i++) {
+                keys[i] = node->key;
+                key_lens[i] = node->key_len;
+                vals[i] = node->val;
+                hashes[i] = node->hash;
+            }
+        }
+    } else {
+        dict_iterator_t *iterator = dict_iterator_new(src);
+
+        if (iterator == NULL)
+            goto out;
+
+        while (dict_iterator_next(iterator, &keys[i], &key_lens[i],
+                    &vals[i]) == DICT_OK)
+            i++;
+        dict_iterator_free(iterator);
+    }
+
+    assert(i == n);
+    result = pdict_load(dst, keys, key_lens, vals, hashes, n, threads);
+out:
+    free(keys);
+    free(key_lens);
+    free(vals);
+    free(hashes);
+    return result;
+}
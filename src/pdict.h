@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Parallel bulk build and merge of dicts (pthread based).
+ *
+ * Keys are hashed by all workers, partitioned by bucket range, then each
+ * worker links the keys of its own bucket ranges into the dict's table,
+ * so no locks are taken. The table is sized for all the keys up front and
+ * nodes are taken from the dict's pool before the workers start.
+ *
+ * Small batches, dicts owning their keys and dicts paused by iterators are
+ * loaded on the calling thread with `dict_set`. Later keys win, as with
+ * `dict_set`. The dict must not be used by other threads meanwhile.
+ */
+
+#ifndef __PDICT_H
+#define __PDICT_H
+
+#include <pthread.h>
+
+#include "dict.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PDICT_PARALLEL_MIN 4096  // min keys number to load in parallel
+#define PDICT_THREADS_MAX 64     // max workers number
+#define PDICT_PARTS_PER_THREAD 8 // bucket ranges per worker
+
+int dict_build_parallel(dict_t *, uint8_t **, size_t *, void **, size_t,
+        size_t);
+int dict_merge(dict_t *, dict_t *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
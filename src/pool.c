@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "pool.h"
+
+/**
+ * New pool for items of `item_size` bytes.
+ */
+pool_t *
+pool_new(size_t item_size)
+{
+    assert(item_size > 0);
+
+    pool_t *pool = malloc(sizeof(pool_t));
+
+    if (pool != NULL) {
+        if (item_size < sizeof(pool_item_t))
+            item_size = sizeof(pool_item_t);
+        pool->item_size = (item_size + 7) & ~(size_t)7;
+        pool->slab_items = POOL_SLAB_MIN;
+        pool->slabs = NULL;
+        pool->free_items = NULL;
+        pool->cursor = NULL;
+        pool->end = NULL;
+        pool->size = 0;
+        pool->cap = 0;
+    }
+    return pool;
+}
+
+/**
+ * Free pool and all its items.
+ */
+void
+pool_free(pool_t *pool)
+{
+    if (pool != NULL) {
+        pool_clear(pool);
+        free(pool);
+    }
+}
+
+/**
+ * Release all items at once, O(slabs).
+ */
+void
+pool_clear(pool_t *pool)
+{
+    assert(pool != NULL);
+
+    pool_slab_t *slab = pool->slabs;
+
+    while (slab != NULL) {
+        pool_slab_t *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    pool->slab_items = POOL_SLAB_MIN;
+    pool->slabs = NULL;
+    pool->free_items = NULL;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    pool->size = 0;
+    pool->cap = 0;
+}
+
+/**
+ * Alloc an item, O(1). Returns NULL on no memory.
+ */
+void *
+pool_alloc(pool_t *pool)
+{
+    assert(pool != NULL);
+
+    pool_item_t *item = pool->free_items;
+
+    if (item != NULL) {
+        pool->free_items = item->next;
+        pool->size += 1;
+        return item;
+    }
+
+    if (pool->cursor == pool->end) {
+        size_t bytes = sizeof(pool_slab_t) +
+            pool->slab_items * pool->item_size;
+        pool_slab_t *slab = malloc(bytes);
+
+        if (slab == NULL)
+            return NULL;
+
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->cursor = (uint8_t *)(slab + 1);
+        pool->end = pool->cursor + pool->slab_items * pool->item_size;
+        pool->cap += bytes;
+
+        if (pool->slab_items < POOL_SLAB_MAX)
+            pool->slab_items *= 2;
+    }
+
+    item = (pool_item_t *)pool->cursor;
+    pool->cursor += pool->item_size;
+    pool->size += 1;
+    return item;
+}
+
+/**
+ * Release an item back to the pool, O(1).
+ */
+void
+pool_dealloc(pool_t *pool, void *data)
+{
+    assert(pool != NULL);
+
+    if (data != NULL) {
+        assert(pool->size > 0);
+        pool_item_t *item = data;
+        item->next = pool->free_items;
+        pool->free_items = item;
+        pool->size -= 1;
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Fixed size items pool (slab based), not thread safe.
+ *
+ * Items are carved from slabs, each slab doubles the previous one's items
+ * number (up to POOL_SLAB_MAX). Released items go to a free list and are
+ * reused first, slabs are only given back on `pool_clear`/`pool_free`.
+ */
+
+#ifndef __POOL_H
+#define __POOL_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POOL_SLAB_MIN 8       // items number of the first slab
+#define POOL_SLAB_MAX 1024    // max items number of a slab
+
+typedef struct pool_slab_st {
+    struct pool_slab_st *next;
+    uint64_t align;                  /* keeps items 8 bytes aligned */
+} pool_slab_t;
+
+typedef struct pool_item_st {
+    struct pool_item_st *next;
+} pool_item_t;
+
+typedef struct pool_st {
+    size_t item_size;                /* item size (8 bytes aligned) */
+    size_t slab_items;               /* items number of the next slab */
+    pool_slab_t *slabs;              /* allocated slabs */
+    pool_item_t *free_items;         /* released items */
+    uint8_t *cursor;                 /* next unused item in current slab */
+    uint8_t *end;                    /* end of current slab */
+    size_t size;                     /* items in use */
+    size_t cap;                      /* bytes allocated by slabs */
+} pool_t;
+
+pool_t *pool_new(size_t);
+void pool_free(pool_t *);
+void pool_clear(pool_t *);
+void *pool_alloc(pool_t *);
+void pool_dealloc(pool_t *, void *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
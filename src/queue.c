@@ -28,6 +28,12 @@ queue_new(void)
         queue->head = NULL;
         queue->tail = NULL;
         queue->size = 0;
+        queue->pool = pool_new(sizeof(queue_node_t));
+
+        if (queue->pool == NULL) {
+            free(queue);
+            return NULL;
+        }
     }
     return queue;
 }
@@ -39,27 +45,30 @@ void
 queue_free(queue_t *queue)
 {
     if (queue != NULL) {
-        queue_clear(queue);
+        pool_free(queue->pool);
         free(queue);
     }
 }
 
 /**
- * Clear queue, O(n)
+ * Clear queue, nodes are released all at once, O(slabs)
  */
 void
 queue_clear(queue_t *queue)
 {
     assert(queue != NULL);
-    while (queue_pop(queue) != NULL);
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->size = 0;
+    pool_clear(queue->pool);
 }
 
 /**
- * New queue node.
+ * New queue node (from the queue's pool).
  */
 queue_node_t *
-queue_node_new(void *data) {
-    queue_node_t *node = malloc(sizeof(queue_node_t));
+queue_node_new(queue_t *queue, void *data) {
+    queue_node_t *node = pool_alloc(queue->pool);
 
     if (node != NULL) {
         node->next = NULL;
@@ -72,10 +81,10 @@ queue_node_new(void *data) {
  * Free queue node.
  */
 void
-queue_node_free(queue_node_t *node)
+queue_node_free(queue_t *queue, queue_node_t *node)
 {
     if (node != NULL)
-        free(node);
+        pool_dealloc(queue->pool, node);
 }
 
 /**
@@ -86,7 +95,7 @@ queue_push(queue_t *queue, void *item)
 {
     assert(queue != NULL);
 
-    queue_node_t *node = queue_node_new(item);
+    queue_node_t *node = queue_node_new(queue, item);
 
     if (node == NULL)
         return QUEUE_ENOMEM;
@@ -124,7 +133,7 @@ queue_pop(queue_t *queue)
     queue->size -= 1;
     if (queue->head == NULL)
         queue->tail = NULL;
-    queue_node_free(head);
+    queue_node_free(queue, head);
     return data;
 }
 
@@ -24,6 +24,8 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include "pool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,13 +44,14 @@ typedef struct queue_st {
     struct queue_node_st *head;
     struct queue_node_st *tail;
     size_t size;
+    pool_t *pool;                    /* nodes pool */
 } queue_t;
 
 queue_t *queue_new(void);
 void queue_free(queue_t *);
 void queue_clear(queue_t *);
-queue_node_t *queue_node_new(void *);
-void queue_node_free(queue_node_t *);
+queue_node_t *queue_node_new(queue_t *, void *);
+void queue_node_free(queue_t *, queue_node_t *);
 int queue_push(queue_t *, void *);
 void *queue_pop(queue_t *);
 void *queue_top(queue_t *);
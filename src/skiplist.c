@@ -0,0 +1,427 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "skiplist.h"
+
+/**
+ * Compare keys by memcmp, a key is less than the longer keys it prefixes.
+ */
+int
+skiplist_cmp_bytes(uint8_t *a, size_t a_len, uint8_t *b, size_t b_len)
+{
+    int result = memcmp(a, b, a_len < b_len ? a_len : b_len);
+
+    if (result != 0)
+        return result;
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+/**
+ * New node with `level` links.
+ */
+static skiplist_node_t *
+skiplist_node_new(size_t level)
+{
+    skiplist_node_t *node = malloc(sizeof(skiplist_node_t) +
+            level * sizeof(skiplist_link_t));
+
+    if (node != NULL) {
+        node->key = NULL;
+        node->key_len = 0;
+        node->val = NULL;
+        node->prev = NULL;
+        node->level = level;
+    }
+    return node;
+}
+
+/**
+ * Random level for a new node, level n has 1 / SKIPLIST_BRANCH^(n-1)
+ * chance.
+ */
+static size_t
+skiplist_random_level(skiplist_t *skiplist)
+{
+    size_t level = 1;
+    uint64_t x = skiplist->rand;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    skiplist->rand = x;
+
+    while (level < SKIPLIST_LEVEL_MAX && (x & 0x3) == 0) {
+        level++;
+        x >>= 2;
+    }
+    return level;
+}
+
+/**
+ * Find the last node before `key` on each level (into `update`) and its
+ * rank (into `ranks`, 0 for head). Returns the first node not less than
+ * `key`, or NULL.
+ */
+static skiplist_node_t *
+skiplist_find(skiplist_t *skiplist, uint8_t *key, size_t key_len,
+        skiplist_node_t **update, size_t *ranks)
+{
+    skiplist_node_t *node = skiplist->head;
+    size_t rank = 0, i = skiplist->level;
+
+    while (i-- > 0) {
+        skiplist_node_t *next;
+
+        while ((next = (node->links)[i].next) != NULL &&
+                (skiplist->cmp)(next->key, next->key_len, key, key_len) < 0) {
+            rank += (node->links)[i].span;
+            node = next;
+        }
+
+        if (update != NULL)
+            update[i] = node;
+        if (ranks != NULL)
+            ranks[i] = rank;
+    }
+    return (node->links)[0].next;
+}
+
+/**
+ * New skiplist.
+ */
+skiplist_t *
+skiplist_new(void)
+{
+    skiplist_t *skiplist = malloc(sizeof(skiplist_t));
+
+    if (skiplist != NULL) {
+        skiplist->head = skiplist_node_new(SKIPLIST_LEVEL_MAX);
+
+        if (skiplist->head == NULL) {
+            free(skiplist);
+            return NULL;
+        }
+
+        memset(skiplist->head->links, 0,
+                SKIPLIST_LEVEL_MAX * sizeof(skiplist_link_t));
+        skiplist->cmp = &skiplist_cmp_bytes;
+        skiplist->rand = 0x9e3779b97f4a7c15ULL;
+        skiplist->tail = NULL;
+        skiplist->level = 1;
+        skiplist->size = 0;
+    }
+    return skiplist;
+}
+
+/**
+ * Free skiplist.
+ */
+void
+skiplist_free(skiplist_t *skiplist)
+{
+    if (skiplist != NULL) {
+        skiplist_clear(skiplist);
+        free(skiplist->head);
+        free(skiplist);
+    }
+}
+
+/**
+ * Clear skiplist.
+ */
+void
+skiplist_clear(skiplist_t *skiplist)
+{
+    assert(skiplist != NULL);
+
+    skiplist_node_t *node = (skiplist->head->links)[0].next;
+    size_t i;
+
+    while (node != NULL) {
+        skiplist_node_t *next = (node->links)[0].next;
+        free(node);
+        node = next;
+    }
+
+    for (i = 0; i < SKIPLIST_LEVEL_MAX; i++) {
+        (skiplist->head->links)[i].next = NULL;
+        (skiplist->head->links)[i].span = 0;
+    }
+
+    skiplist->tail = NULL;
+    skiplist->level = 1;
+    skiplist->size = 0;
+}
+
+/**
+ * Use a keys compare function, the skiplist must be empty.
+ */
+void
+skiplist_use_cmp(skiplist_t *skiplist, skiplist_cmp_func_t cmp)
+{
+    assert(skiplist != NULL && cmp != NULL && skiplist->size == 0);
+    skiplist->cmp = cmp;
+}
+
+/**
+ * Set a key to skiplist, O(log n).
+ */
+int
+skiplist_set(skiplist_t *skiplist, uint8_t *key, size_t key_len, void *val)
+{
+    assert(skiplist != NULL);
+
+    skiplist_node_t *update[SKIPLIST_LEVEL_MAX];
+    size_t ranks[SKIPLIST_LEVEL_MAX];
+    skiplist_node_t *node = skiplist_find(skiplist, key, key_len, update,
+            ranks);
+    size_t level, i;
+
+    if (node != NULL &&
+            (skiplist->cmp)(node->key, node->key_len, key, key_len) == 0) {
+        node->key = key;
+        node->val = val;
+        return SKIPLIST_OK;
+    }
+
+    level = skiplist_random_level(skiplist);
+    node = skiplist_node_new(level);
+
+    if (node == NULL)
+        return SKIPLIST_ENOMEM;
+
+    node->key = key;
+    node->key_len = key_len;
+    node->val = val;
+
+    // new levels start at head, spanning the whole list
+    for (i = skiplist->level; i < level; i++) {
+        update[i] = skiplist->head;
+        ranks[i] = 0;
+        (skiplist->head->links)[i].span = skiplist->size;
+    }
+    if (level > skiplist->level)
+        skiplist->level = level;
+
+    for (i = 0; i < level; i++) {
+        skiplist_link_t *link = &(update[i]->links)[i];
+        size_t before = ranks[0] - ranks[i];  // nodes between update & new
+
+        (node->links)[i].next = link->next;
+        (node->links)[i].span = link->span - before;
+        link->next = node;
+        link->span = before + 1;
+    }
+
+    for (; i < skiplist->level; i++)
+        (update[i]->links)[i].span += 1;
+
+    node->prev = update[0] == skiplist->head ? NULL : update[0];
+    if ((node->links)[0].next != NULL)
+        (node->links)[0].next->prev = node;
+    else
+        skiplist->tail = node;
+
+    skiplist->size += 1;
+    return SKIPLIST_OK;
+}
+
+/**
+ * Get the node of a key, NULL if not found, O(log n).
+ */
+skiplist_node_t *
+skiplist_lookup(skiplist_t *skiplist, uint8_t *key, size_t key_len)
+{
+    assert(skiplist != NULL);
+
+    skiplist_node_t *node = skiplist_find(skiplist, key, key_len, NULL,
+            NULL);
+
+    if (node != NULL &&
+            (skiplist->cmp)(node->key, node->key_len, key, key_len) == 0)
+        return node;
+    return NULL;
+}
+
+/**
+ * Get val by key, NULL if not found.
+ */
+void *
+skiplist_get(skiplist_t *skiplist, uint8_t *key, size_t key_len)
+{
+    skiplist_node_t *node = skiplist_lookup(skiplist, key, key_len);
+
+    if (node != NULL)
+        return node->val;
+    return NULL;
+}
+
+/**
+ * Test if a key is in skiplist.
+ */
+bool
+skiplist_has(skiplist_t *skiplist, uint8_t *key, size_t key_len)
+{
+    return skiplist_lookup(skiplist, key, key_len) != NULL;
+}
+
+/**
+ * Del a key from skiplist, O(log n).
+ */
+int
+skiplist_del(skiplist_t *skiplist, uint8_t *key, size_t key_len)
+{
+    assert(skiplist != NULL);
+
+    skiplist_node_t *update[SKIPLIST_LEVEL_MAX];
+    skiplist_node_t *node = skiplist_find(skiplist, key, key_len, update,
+            NULL);
+    size_t i;
+
+    if (node == NULL ||
+            (skiplist->cmp)(node->key, node->key_len, key, key_len) != 0)
+        return SKIPLIST_ENOTFOUND;
+
+    for (i = 0; i < skiplist->level; i++) {
+        skiplist_link_t *link = &(update[i]->links)[i];
+
+        if (link->next == node) {
+            link->span += (node->links)[i].span - 1;
+            link->next = (node->links)[i].next;
+        } else {
+            link->span -= 1;
+        }
+    }
+
+    if ((node->links)[0].next != NULL)
+        (node->links)[0].next->prev = node->prev;
+    else
+        skiplist->tail = node->prev;
+
+    while (skiplist->level > 1 &&
+            (skiplist->head->links)[skiplist->level - 1].next == NULL) {
+        (skiplist->head->links)[skiplist->level - 1].span = 0;
+        skiplist->level--;
+    }
+
+    free(node);
+    skiplist->size -= 1;
+    return SKIPLIST_OK;
+}
+
+/**
+ * Get skiplist size (nodes number).
+ */
+size_t
+skiplist_size(skiplist_t *skiplist)
+{
+    assert(skiplist != NULL);
+    return skiplist->size;
+}
+
+/**
+ * Get the first node with key not less than `key`, NULL if none, O(log n).
+ */
+skiplist_node_t *
+skiplist_seek(skiplist_t *skiplist, uint8_t *key, size_t key_len)
+{
+    assert(skiplist != NULL);
+    return skiplist_find(skiplist, key, key_len, NULL, NULL);
+}
+
+/**
+ * Get the number of keys less than `key`, that is the rank (from 0) of
+ * `key` if in skiplist, O(log n).
+ */
+size_t
+skiplist_rank(skiplist_t *skiplist, uint8_t *key, size_t key_len)
+{
+    assert(skiplist != NULL);
+
+    size_t ranks[SKIPLIST_LEVEL_MAX];
+
+    skiplist_find(skiplist, key, key_len, NULL, ranks);
+    return ranks[0];
+}
+
+/**
+ * Get the node of rank `rank` (from 0), NULL if out of range, O(log n).
+ */
+skiplist_node_t *
+skiplist_at(skiplist_t *skiplist, size_t rank)
+{
+    assert(skiplist != NULL);
+
+    if (rank >= skiplist->size)
+        return NULL;
+
+    skiplist_node_t *node = skiplist->head;
+    size_t traversed = 0, i = skiplist->level;
+
+    rank += 1;  // head is at 0
+
+    while (i-- > 0) {
+        while ((node->links)[i].next != NULL &&
+                traversed + (node->links)[i].span <= rank) {
+            traversed += (node->links)[i].span;
+            node = (node->links)[i].next;
+        }
+
+        if (traversed == rank)
+            return node;
+    }
+    return NULL;
+}
+
+/**
+ * Get the first node, NULL if empty.
+ */
+skiplist_node_t *
+skiplist_first(skiplist_t *skiplist)
+{
+    assert(skiplist != NULL);
+    return (skiplist->head->links)[0].next;
+}
+
+/**
+ * Get the last node, NULL if empty.
+ */
+skiplist_node_t *
+skiplist_last(skiplist_t *skiplist)
+{
+    assert(skiplist != NULL);
+    return skiplist->tail;
+}
+
+/**
+ * Get the next node, NULL at the end.
+ */
+skiplist_node_t *
+skiplist_next(skiplist_node_t *node)
+{
+    assert(node != NULL);
+    return (node->links)[0].next;
+}
+
+/**
+ * Get the previous node, NULL at the start.
+ */
+skiplist_node_t *
+skiplist_prev(skiplist_node_t *node)
+{
+    assert(node != NULL);
+    return node->prev;
+}
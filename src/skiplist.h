@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Ordered map on a skip list (byte string keys).
+ *
+ * Nodes are linked on up to `SKIPLIST_LEVEL_MAX` levels, each link knows
+ * how many nodes it skips (its span), so seeks, ranks and lookups by rank
+ * are O(log n). Level 0 is a double linked list for range iteration in
+ * both directions:
+ *
+ *   skiplist_node_t *node = skiplist_seek(skiplist, start, start_len);
+ *
+ *   for (; node != NULL; node = skiplist_next(node)) {
+ *     ...
+ *   }
+ *
+ * Keys are not copied, and ordered by memcmp then length by default (see
+ * `skiplist_use_cmp`).
+ */
+
+#ifndef __SKIPLIST_H
+#define __SKIPLIST_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SKIPLIST_LEVEL_MAX 32    // max levels number
+#define SKIPLIST_BRANCH 4        // 1/4 of a level's nodes go up a level
+
+typedef enum {
+    SKIPLIST_OK = 0,
+    SKIPLIST_ENOMEM = -1,       /* No memory error */
+    SKIPLIST_ENOTFOUND = -2,    /* Key was not found */
+} skiplist_error_t;
+
+typedef int (*skiplist_cmp_func_t)(uint8_t *, size_t, uint8_t *, size_t);
+
+typedef struct skiplist_node_st skiplist_node_t;
+
+typedef struct skiplist_link_st {
+    skiplist_node_t *next;
+    size_t span;                     /* rank distance to next */
+} skiplist_link_t;
+
+struct skiplist_node_st {
+    uint8_t *key;
+    size_t key_len;
+    void *val;
+    skiplist_node_t *prev;           /* previous node on level 0 */
+    size_t level;                    /* links number */
+    skiplist_link_t links[];
+};
+
+typedef struct skiplist_st {
+    skiplist_node_t *head;           /* sentinel with all levels */
+    skiplist_node_t *tail;           /* last node, or NULL */
+    size_t level;                    /* levels in use */
+    size_t size;                     /* nodes number */
+    skiplist_cmp_func_t cmp;         /* keys compare function */
+    uint64_t rand;                   /* levels random state */
+} skiplist_t;
+
+int skiplist_cmp_bytes(uint8_t *, size_t, uint8_t *, size_t);
+skiplist_t *skiplist_new(void);
+void skiplist_free(skiplist_t *);
+void skiplist_clear(skiplist_t *);
+void skiplist_use_cmp(skiplist_t *, skiplist_cmp_func_t);
+int skiplist_set(skiplist_t *, uint8_t *, size_t, void *);
+void *skiplist_get(skiplist_t *, uint8_t *, size_t);
+bool skiplist_has(skiplist_t *, uint8_t *, size_t);
+int skiplist_del(skiplist_t *, uint8_t *, size_t);
+size_t skiplist_size(skiplist_t *);
+skiplist_node_t *skiplist_lookup(skiplist_t *, uint8_t *, size_t);
+skiplist_node_t *skiplist_seek(skiplist_t *, uint8_t *, size_t);
+skiplist_node_t *skiplist_at(skiplist_t *, size_t);
+size_t skiplist_rank(skiplist_t *, uint8_t *, size_t);
+skiplist_node_t *skiplist_first(skiplist_t *);
+skiplist_node_t *skiplist_last(skiplist_t *);
+skiplist_node_t *skiplist_next(skiplist_node_t *);
+skiplist_node_t *skiplist_prev(skiplist_node_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
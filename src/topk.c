@@ -0,0 +1,360 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "topk.h"
+
+/**
+ * Swap two heap items.
+ */
+static void
+topk_heap_swap(topk_t *topk, size_t i, size_t j)
+{
+    topk_entry_t *entry = (topk->heap)[i];
+    (topk->heap)[i] = (topk->heap)[j];
+    (topk->heap)[j] = entry;
+    (topk->heap)[i]->heap_index = i;
+    (topk->heap)[j]->heap_index = j;
+}
+
+/**
+ * Move a heap item up until its parent is not larger.
+ */
+static void
+topk_heap_up(topk_t *topk, size_t index)
+{
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+
+        if ((topk->heap)[parent]->count <= (topk->heap)[index]->count)
+            break;
+        topk_heap_swap(topk, parent, index);
+        index = parent;
+    }
+}
+
+/**
+ * Move a heap item down until its children are not smaller.
+ */
+static void
+topk_heap_down(topk_t *topk, size_t index)
+{
+    while (1) {
+        size_t left = 2 * index + 1, right = left + 1, min = index;
+
+        if (left < topk->size && (topk->heap)[left]->count <
+                (topk->heap)[min]->count)
+            min = left;
+        if (right < topk->size && (topk->heap)[right]->count <
+                (topk->heap)[min]->count)
+            min = right;
+        if (min == index)
+            break;
+        topk_heap_swap(topk, index, min);
+        index = min;
+    }
+}
+
+/**
+ * New entry with a copy of key.
+ */
+static topk_entry_t *
+topk_entry_new(uint8_t *key, size_t key_len, uint64_t count)
+{
+    topk_entry_t *entry = malloc(sizeof(topk_entry_t) + key_len);
+
+    if (entry != NULL) {
+        entry->key = (uint8_t *)(entry + 1);
+        entry->key_len = key_len;
+        entry->count = count;
+        memcpy(entry->key, key, key_len);
+    }
+    return entry;
+}
+
+/**
+ * Put an entry to the top list, replacing the smallest one if full.
+ */
+static int
+topk_put(topk_t *topk, uint8_t *key, size_t key_len, uint64_t count)
+{
+    topk_entry_t *entry = topk_entry_new(key, key_len, count);
+
+    if (entry == NULL)
+        return TOPK_ENOMEM;
+
+    if (dict_set(topk->dict, entry->key, key_len, entry) != DICT_OK) {
+        free(entry);
+        return TOPK_ENOMEM;
+    }
+
+    if (topk->size == topk->k) {
+        topk_entry_t *min = (topk->heap)[0];
+
+        dict_del(topk->dict, min->key, min->key_len);
+        free(min);
+        entry->heap_index = 0;
+        (topk->heap)[0] = entry;
+        topk_heap_down(topk, 0);
+    } else {
+        entry->heap_index = topk->size;
+        (topk->heap)[topk->size++] = entry;
+        topk_heap_up(topk, entry->heap_index);
+    }
+    return TOPK_OK;
+}
+
+/**
+ * New top-k list of `k` keys over a sketch of `depth` rows of `width`
+ * counters (0 for the sketch defaults).
+ */
+topk_t *
+topk_new(size_t k, size_t width, size_t depth)
+{
+    assert(k > 0);
+
+    if (k > SIZE_MAX / sizeof(topk_entry_t *))
+        return NULL;
+
+    topk_t *topk = malloc(sizeof(topk_t));
+
+    if (topk != NULL) {
+        topk->cms = cms_new(width, depth);
+        topk->dict = dict_new();
+        topk->heap = malloc(k * sizeof(topk_entry_t *));
+
+        if (topk->cms == NULL || topk->dict == NULL || topk->heap == NULL) {
+            cms_free(topk->cms);
+            dict_free(topk->dict);
+            free(topk->heap);
+            free(topk);
+            return NULL;
+        }
+
+        topk->k = k;
+        topk->size = 0;
+    }
+    return topk;
+}
+
+/**
+ * Free top-k list.
+ */
+void
+topk_free(topk_t *topk)
+{
+    if (topk != NULL) {
+        topk_clear(topk);
+        cms_free(topk->cms);
+        dict_free(topk->dict);
+        free(topk->heap);
+        free(topk);
+    }
+}
+
+/**
+ * Clear top-k list and its sketch.
+ */
+void
+topk_clear(topk_t *topk)
+{
+    assert(topk != NULL);
+
+    size_t i;
+
+    for (i = 0; i < topk->size; i++)
+        free((topk->heap)[i]);
+
+    cms_clear(topk->cms);
+    dict_clear(topk->dict);
+    topk->size = 0;
+}
+
+/**
+ * Add `count` to a key, the key enters the top list if its estimated
+ * count is over the smallest one in.
+ */
+int
+topk_add(topk_t *topk, uint8_t *key, size_t key_len, uint32_t count)
+{
+    assert(topk != NULL);
+
+    uint64_t estimate = cms_add(topk->cms, key, key_len, count);
+    topk_entry_t *entry = dict_get(topk->dict, key, key_len);
+
+    if (entry != NULL) {
+        entry->count = estimate;
+        topk_heap_down(topk, entry->heap_index);
+        return TOPK_OK;
+    }
+
+    if (topk->size == topk->k && estimate <= (topk->heap)[0]->count)
+        return TOPK_OK;
+    return topk_put(topk, key, key_len, estimate);
+}
+
+/**
+ * Get the estimated count of a key.
+ */
+uint64_t
+topk_count(topk_t *topk, uint8_t *key, size_t key_len)
+{
+    assert(topk != NULL);
+    return cms_count(topk->cms, key, key_len);
+}
+
+/**
+ * Test if a key is in the top list.
+ */
+bool
+topk_has(topk_t *topk, uint8_t *key, size_t key_len)
+{
+    assert(topk != NULL);
+    return dict_has(topk->dict, key, key_len);
+}
+
+/**
+ * Get the number of keys in the top list.
+ */
+size_t
+topk_size(topk_t *topk)
+{
+    assert(topk != NULL);
+    return topk->size;
+}
+
+static int
+topk_entry_cmp(const void *a, const void *b)
+{
+    uint64_t x = (*(topk_entry_t **)a)->count;
+    uint64_t y = (*(topk_entry_t **)b)->count;
+    return (x < y) - (x > y);
+}
+
+/**
+ * Call `func` on the top keys from the largest count, returns the number
+ * of keys visited, O(k log k).
+ */
+size_t
+topk_list(topk_t *topk, topk_func_t func, void *data)
+{
+    assert(topk != NULL && func != NULL);
+
+    if (topk->size == 0)
+        return 0;
+
+    topk_entry_t **entries = malloc(topk->size * sizeof(topk_entry_t *));
+    size_t i;
+
+    if (entries == NULL)
+        return 0;
+
+    memcpy(entries, topk->heap, topk->size * sizeof(topk_entry_t *));
+    qsort(entries, topk->size, sizeof(topk_entry_t *), &topk_entry_cmp);
+
+    for (i = 0; i < topk->size; i++)
+        (func)(entries[i]->key, entries[i]->key_len, entries[i]->count,
+                data);
+
+    free(entries);
+    return topk->size;
+}
+
+/**
+ * Append top-k list to buf: a header, the entries (count, key length,
+ * key), then the sketch.
+ */
+int
+topk_dump(topk_t *topk, buf_t *buf)
+{
+    assert(topk != NULL && buf != NULL);
+
+    topk_header_t header = {TOPK_MAGIC, topk->k, topk->size};
+    size_t i;
+
+    if (buf_put(buf, (uint8_t *)&header, sizeof(header)) != BUF_OK)
+        return TOPK_ENOMEM;
+
+    for (i = 0; i < topk->size; i++) {
+        topk_entry_t *entry = (topk->heap)[i];
+        uint64_t fields[2] = {entry->count, entry->key_len};
+
+        if (buf_put(buf, (uint8_t *)fields, sizeof(fields)) != BUF_OK ||
+                buf_put(buf, entry->key, entry->key_len) != BUF_OK)
+            return TOPK_ENOMEM;
+    }
+
+    if (cms_dump(topk->cms, buf) != CMS_OK)
+        return TOPK_ENOMEM;
+    return TOPK_OK;
+}
+
+/**
+ * Load a top-k list from a dump, NULL if no memory or the dump is
+ * invalid.
+ */
+topk_t *
+topk_load(uint8_t *data, size_t len)
+{
+    assert(data != NULL);
+
+    topk_header_t header;
+    uint64_t fields[2];
+    size_t offset = sizeof(header), i;
+
+    if (len < sizeof(header))
+        return NULL;
+
+    memcpy(&header, data, sizeof(header));
+
+    // each entry takes at least its fields, and the heap must be
+    // allocatable
+    if (header.magic != TOPK_MAGIC || header.k == 0 ||
+            header.size > header.k ||
+            header.size > (len - sizeof(header)) / sizeof(fields) ||
+            header.k > SIZE_MAX / sizeof(topk_entry_t *))
+        return NULL;
+
+    topk_t *topk = topk_new(header.k, 1, 1);
+
+    if (topk == NULL)
+        return NULL;
+
+    for (i = 0; i < header.size; i++) {
+        if (len - offset < sizeof(fields))
+            goto err;
+        memcpy(fields, data + offset, sizeof(fields));
+        offset += sizeof(fields);
+
+        if (len - offset < fields[1] ||
+                dict_has(topk->dict, data + offset, fields[1]) ||
+                topk_put(topk, data + offset, fields[1], fields[0]) !=
+                TOPK_OK)
+            goto err;
+        offset += fields[1];
+    }
+
+    cms_t *cms = cms_load(data + offset, len - offset);
+
+    if (cms == NULL)
+        goto err;
+
+    cms_free(topk->cms);
+    topk->cms = cms;
+    return topk;
+err:
+    topk_free(topk);
+    return NULL;
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Top-K heavy hitters (Count-Min sketch based).
+ *
+ * Every key is counted by a Count-Min sketch, the `k` keys with the
+ * largest estimated counts are kept in a min-heap (with copies of their
+ * keys) and indexed by a dict, so an add is one sketch update plus
+ * O(log k) heap work when the key is in or enters the top list.
+ */
+
+#ifndef __TOPK_H
+#define __TOPK_H
+
+#include "buf.h"
+#include "cms.h"
+#include "dict.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOPK_MAGIC 0x31304b504f540000ULL  // "\0\0TOPK01"
+
+typedef enum {
+    TOPK_OK = 0,
+    TOPK_ENOMEM = -1,       /* No memory error */
+} topk_error_t;
+
+typedef struct topk_header_st {
+    uint64_t magic;
+    uint64_t k;
+    uint64_t size;                   /* entries number */
+} topk_header_t;
+
+typedef struct topk_entry_st {
+    uint8_t *key;                    /* copy, after the entry */
+    size_t key_len;
+    uint64_t count;                  /* estimated count */
+    size_t heap_index;
+} topk_entry_t;
+
+typedef struct topk_st {
+    cms_t *cms;                      /* counts of all keys */
+    dict_t *dict;                    /* key => entry */
+    topk_entry_t **heap;             /* min-heap by count, k slots */
+    size_t k;
+    size_t size;                     /* entries number */
+} topk_t;
+
+typedef void (*topk_func_t)(uint8_t *, size_t, uint64_t, void *);
+
+topk_t *topk_new(size_t, size_t, size_t);
+void topk_free(topk_t *);
+void topk_clear(topk_t *);
+int topk_add(topk_t *, uint8_t *, size_t, uint32_t);
+uint64_t topk_count(topk_t *, uint8_t *, size_t);
+bool topk_has(topk_t *, uint8_t *, size_t);
+size_t topk_size(topk_t *);
+size_t topk_list(topk_t *, topk_func_t, void *);
+int topk_dump(topk_t *, buf_t *);
+topk_t *topk_load(uint8_t *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <math.h>
+
+#include "zset.h"
+
+/**
+ * Compare entries by score, then by member. The skiplist keys are entry
+ * pointers, their lengths are not used.
+ */
+static int
+zset_cmp(uint8_t *a, size_t a_len, uint8_t *b, size_t b_len)
+{
+    (void)a_len;
+    (void)b_len;
+
+    zset_entry_t *x = (zset_entry_t *)a;
+    zset_entry_t *y = (zset_entry_t *)b;
+
+    if (x->score != y->score)
+        return x->score < y->score ? -1 : 1;
+    return skiplist_cmp_bytes(x->member, x->member_len, y->member,
+            y->member_len);
+}
+
+/**
+ * Get the first skiplist node with score not less than `score`.
+ */
+static skiplist_node_t *
+zset_seek(zset_t *zset, double score)
+{
+    // the empty member is the smallest one of a score
+    zset_entry_t probe = {(uint8_t *)"", 0, score};
+    return skiplist_seek(zset->skiplist, (uint8_t *)&probe, 0);
+}
+
+/**
+ * Get the number of entries with score less than `score`.
+ */
+static size_t
+zset_rank_of_score(zset_t *zset, double score)
+{
+    zset_entry_t probe = {(uint8_t *)"", 0, score};
+    return skiplist_rank(zset->skiplist, (uint8_t *)&probe, 0);
+}
+
+/**
+ * New zset.
+ */
+zset_t *
+zset_new(void)
+{
+    zset_t *zset = malloc(sizeof(zset_t));
+
+    if (zset != NULL) {
+        zset->dict = dict_new();
+        zset->skiplist = skiplist_new();
+        zset->pool = pool_new(sizeof(zset_entry_t));
+
+        if (zset->dict == NULL || zset->skiplist == NULL ||
+                zset->pool == NULL) {
+            dict_free(zset->dict);
+            skiplist_free(zset->skiplist);
+            pool_free(zset->pool);
+            free(zset);
+            return NULL;
+        }
+
+        skiplist_use_cmp(zset->skiplist, &zset_cmp);
+    }
+    return zset;
+}
+
+/**
+ * Free zset.
+ */
+void
+zset_free(zset_t *zset)
+{
+    if (zset != NULL) {
+        dict_free(zset->dict);
+        skiplist_free(zset->skiplist);
+        pool_free(zset->pool);
+        free(zset);
+    }
+}
+
+/**
+ * Clear zset.
+ */
+void
+zset_clear(zset_t *zset)
+{
+    assert(zset != NULL);
+    dict_clear(zset->dict);
+    skiplist_clear(zset->skiplist);
+    pool_clear(zset->pool);
+}
+
+/**
+ * Move an entry to a new score. The entry stays in its skiplist node if
+ * the order holds, else it's reinserted: the new node is linked before
+ * the old one is unlinked, so if no memory the entry keeps its old score.
+ */
+static int
+zset_update(zset_t *zset, zset_entry_t *entry, double score)
+{
+    skiplist_node_t *node = skiplist_lookup(zset->skiplist,
+            (uint8_t *)entry, 0);
+
+    assert(node != NULL);
+
+    skiplist_node_t *prev = skiplist_prev(node);
+    skiplist_node_t *next = skiplist_next(node);
+    zset_entry_t moved = *entry;  // stands in for entry at the new score
+    uint8_t *key = (uint8_t *)&moved;
+
+    moved.score = score;
+
+    if ((prev == NULL || zset_cmp(prev->key, 0, key, 0) < 0) &&
+            (next == NULL || zset_cmp(key, 0, next->key, 0) < 0)) {
+        entry->score = score;
+        return ZSET_OK;
+    }
+
+    if (skiplist_set(zset->skiplist, key, 0, NULL) != SKIPLIST_OK)
+        return ZSET_ENOMEM;
+
+    skiplist_del(zset->skiplist, (uint8_t *)entry, 0);
+    node = skiplist_lookup(zset->skiplist, key, 0);
+    assert(node != NULL);
+    node->key = (uint8_t *)entry;
+    entry->score = score;
+    return ZSET_OK;
+}
+
+/**
+ * Add a member to zset, or update its score, O(log n).
+ */
+int
+zset_add(zset_t *zset, uint8_t *member, size_t member_len, double score)
+{
+    assert(zset != NULL && !isnan(score));
+
+    zset_entry_t *entry = dict_get(zset->dict, member, member_len);
+
+    if (entry != NULL) {
+        if (entry->score == score)
+            return ZSET_OK;
+        return zset_update(zset, entry, score);
+    }
+
+    if ((entry = pool_alloc(zset->pool)) == NULL)
+        return ZSET_ENOMEM;
+
+    entry->member = member;
+    entry->member_len = member_len;
+    entry->score = score;
+
+    if (dict_set(zset->dict, member, member_len, entry) != DICT_OK) {
+        pool_dealloc(zset->pool, entry);
+        return ZSET_ENOMEM;
+    }
+
+    if (skiplist_set(zset->skiplist, (uint8_t *)entry, 0, NULL) !=
+            SKIPLIST_OK) {
+        dict_del(zset->dict, member, member_len);
+        pool_dealloc(zset->pool, entry);
+        return ZSET_ENOMEM;
+    }
+    return ZSET_OK;
+}
+
+/**
+ * Add `delta` to the score of a member (added with score `delta` if not
+ * in zset), the new score is stored to `score_addr` if not NULL. Returns
+ * ZSET_ENAN, leaving the zset unchanged, if the new score is NaN (like
+ * +inf plus -inf).
+ */
+int
+zset_incr(zset_t *zset, uint8_t *member, size_t member_len, double delta,
+        double *score_addr)
+{
+    assert(zset != NULL);
+
+    zset_entry_t *entry = dict_get(zset->dict, member, member_len);
+    double score = entry != NULL ? entry->score + delta : delta;
+
+    if (isnan(score))
+        return ZSET_ENAN;
+
+    int result = zset_add(zset, member, member_len, score);
+
+    if (result == ZSET_OK && score_addr != NULL)
+        *score_addr = score;
+    return result;
+}
+
+/**
+ * Get the score of a member to `score_addr`, O(1).
+ */
+int
+zset_score(zset_t *zset, uint8_t *member, size_t member_len,
+        double *score_addr)
+{
+    assert(zset != NULL && score_addr != NULL);
+
+    zset_entry_t *entry = dict_get(zset->dict, member, member_len);
+
+    if (entry == NULL)
+        return ZSET_ENOTFOUND;
+
+    *score_addr = entry->score;
+    return ZSET_OK;
+}
+
+/**
+ * Test if a member is in zset.
+ */
+bool
+zset_has(zset_t *zset, uint8_t *member, size_t member_len)
+{
+    assert(zset != NULL);
+    return dict_has(zset->dict, member, member_len);
+}
+
+/**
+ * Del a member from zset, O(log n).
+ */
+int
+zset_del(zset_t *zset, uint8_t *member, size_t member_len)
+{
+    assert(zset != NULL);
+
+    zset_entry_t *entry = dict_get(zset->dict, member, member_len);
+
+    if (entry == NULL)
+        return ZSET_ENOTFOUND;
+
+    skiplist_del(zset->skiplist, (uint8_t *)entry, 0);
+    dict_del(zset->dict, member, member_len);
+    pool_dealloc(zset->pool, entry);
+    return ZSET_OK;
+}
+
+/**
+ * Get zset size (members number).
+ */
+size_t
+zset_size(zset_t *zset)
+{
+    assert(zset != NULL);
+    return dict_size(zset->dict);
+}
+
+/**
+ * Get the rank of a member (0 for the lowest score) to `rank_addr`,
+ * O(log n).
+ */
+int
+zset_rank(zset_t *zset, uint8_t *member, size_t member_len,
+        size_t *rank_addr)
+{
+    assert(zset != NULL && rank_addr != NULL);
+
+    zset_entry_t *entry = dict_get(zset->dict, member, member_len);
+
+    if (entry == NULL)
+        return ZSET_ENOTFOUND;
+
+    *rank_addr = skiplist_rank(zset->skiplist, (uint8_t *)entry, 0);
+    return ZSET_OK;
+}
+
+/**
+ * Get the number of members with score in [min, max], O(log n).
+ */
+size_t
+zset_count(zset_t *zset, double min, double max)
+{
+    assert(zset != NULL);
+
+    if (min > max)
+        return 0;
+
+    // no score is above +inf to rank the members at +inf below
+    size_t upper = max == INFINITY ? zset_size(zset) :
+        zset_rank_of_score(zset, nextafter(max, INFINITY));
+    return upper - zset_rank_of_score(zset, min);
+}
+
+/**
+ * Call `func` on members with score in [min, max] from the lowest score,
+ * returns the number of members visited, O(log n + k).
+ */
+size_t
+zset_range_by_score(zset_t *zset, double min, double max,
+        zset_range_func_t func, void *data)
+{
+    assert(zset != NULL && func != NULL);
+
+    skiplist_node_t *node = zset_seek(zset, min);
+    size_t count = 0;
+
+    for (; node != NULL; node = skiplist_next(node), count++) {
+        zset_entry_t *entry = (zset_entry_t *)node->key;
+
+        if (entry->score > max)
+            break;
+        (func)(entry->member, entry->member_len, entry->score, data);
+    }
+    return count;
+}
+
+/**
+ * Call `func` on at most `n` members from rank `rank` on, from the lowest
+ * score, returns the number of members visited, O(log n + k).
+ */
+size_t
+zset_range_by_rank(zset_t *zset, size_t rank, size_t n,
+        zset_range_func_t func, void *data)
+{
+    assert(zset != NULL && func != NULL);
+
+    skiplist_node_t *node = skiplist_at(zset->skiplist, rank);
+    size_t count = 0;
+
+    for (; node != NULL && count < n; node = skiplist_next(node), count++) {
+        zset_entry_t *entry = (zset_entry_t *)node->key;
+        (func)(entry->member, entry->member_len, entry->score, data);
+    }
+    return count;
+}
+
+/**
+ * Call `func` on at most `n` members from reversed rank `rank` on (0 for
+ * the highest score), from the highest score, returns the number of
+ * members visited, O(log n + k).
+ */
+size_t
+zset_rev_range_by_rank(zset_t *zset, size_t rank, size_t n,
+        zset_range_func_t func, void *data)
+{
+    assert(zset != NULL && func != NULL);
+
+    size_t size = zset_size(zset);
+
+    if (rank >= size)
+        return 0;
+
+    skiplist_node_t *node = skiplist_at(zset->skiplist, size - 1 - rank);
+    size_t count = 0;
+
+    for (; node != NULL && count < n; node = skiplist_prev(node), count++) {
+        zset_entry_t *entry = (zset_entry_t *)node->key;
+        (func)(entry->member, entry->member_len, entry->score, data);
+    }
+    return count;
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2015, Chao Wang (hit9 <hit9@icloud.com>)
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Sorted set (dict and skiplist based).
+ *
+ * Members are indexed by a dict (member => entry) and ordered by a
+ * skiplist on (score, member), so adds, deletes, score updates and ranks
+ * are O(log n), score lookups are O(1) and ranges cost O(log n + k).
+ * Ranks start at 0 for the lowest score. Members are not copied.
+ */
+
+#ifndef __ZSET_H
+#define __ZSET_H
+
+#include "dict.h"
+#include "pool.h"
+#include "skiplist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ZSET_OK = 0,
+    ZSET_ENOMEM = -1,       /* No memory error */
+    ZSET_ENOTFOUND = -2,    /* Member was not found */
+    ZSET_ENAN = -3,         /* Score would be NaN */
+} zset_error_t;
+
+typedef struct zset_entry_st {
+    uint8_t *member;
+    size_t member_len;
+    double score;
+} zset_entry_t;
+
+typedef struct zset_st {
+    dict_t *dict;                    /* member => entry */
+    skiplist_t *skiplist;            /* entries by (score, member) */
+    pool_t *pool;                    /* entries pool */
+} zset_t;
+
+typedef void (*zset_range_func_t)(uint8_t *, size_t, double, void *);
+
+zset_t *zset_new(void);
+void zset_free(zset_t *);
+void zset_clear(zset_t *);
+int zset_add(zset_t *, uint8_t *, size_t, double);
+int zset_incr(zset_t *, uint8_t *, size_t, double, double *);
+int zset_score(zset_t *, uint8_t *, size_t, double *);
+bool zset_has(zset_t *, uint8_t *, size_t);
+int zset_del(zset_t *, uint8_t *, size_t);
+size_t zset_size(zset_t *);
+int zset_rank(zset_t *, uint8_t *, size_t, size_t *);
+size_t zset_count(zset_t *, double, double);
+size_t zset_range_by_score(zset_t *, double, double, zset_range_func_t,
+        void *);
+size_t zset_range_by_rank(zset_t *, size_t, size_t, zset_range_func_t,
+        void *);
+size_t zset_rev_range_by_rank(zset_t *, size_t, size_t, zset_range_func_t,
+        void *);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
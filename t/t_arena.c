@@ -0,0 +1,108 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include <string.h>
+#include "arena.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_arena_new();
+void case_arena_free();
+void case_arena_clear();
+void case_arena_alloc();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("arena_new", &case_arena_new);
+    test_case("arena_free", &case_arena_free);
+    test_case("arena_clear", &case_arena_clear);
+    test_case("arena_alloc", &case_arena_alloc);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_arena_new()
+{
+    arena_t *arena = arena_new();
+    assert(arena != NULL && arena->chunks == NULL && arena->size == 0 &&
+            arena->cap == 0 && arena->chunk_size == ARENA_CHUNK_MIN);
+    arena_free(arena);
+}
+
+void
+case_arena_free()
+{
+    arena_t *arena = arena_new();
+    assert(arena_alloc(arena, 10) != NULL);
+    assert(arena_alloc(arena, ARENA_CHUNK_MAX * 2) != NULL);
+    arena_free(arena);
+}
+
+void
+case_arena_clear()
+{
+    arena_t *arena = arena_new();
+    int i;
+
+    for (i = 0; i < 1000; i++)
+        assert(arena_alloc(arena, 24) != NULL);
+    assert(arena->size == 24000 && arena->cap > 24000);
+    arena_clear(arena);
+    assert(arena->size == 0 && arena->cap == 0 && arena->chunks == NULL);
+    assert(arena->chunk_size == ARENA_CHUNK_MIN);
+    assert(arena_alloc(arena, 1) != NULL);
+    arena_free(arena);
+}
+
+void
+case_arena_alloc()
+{
+    arena_t *arena = arena_new();
+    uint8_t *items[1000];
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        items[i] = arena_alloc(arena, i % 37 + 1);
+        assert(items[i] != NULL && ((uintptr_t)items[i] & 7) == 0);
+        memset(items[i], i % 256, i % 37 + 1);
+    }
+
+    // allocations never overlap
+    for (i = 0; i < 1000; i++) {
+        int j;
+        for (j = 0; j < i % 37 + 1; j++)
+            assert(items[i][j] == i % 256);
+    }
+
+    // empty allocations are distinct, even on a fresh arena
+    arena_t *empty = arena_new();
+    uint8_t *first = arena_alloc(empty, 0);
+    assert(first != NULL && arena_alloc(empty, 0) != first);
+    arena_free(empty);
+
+    // chunks grow, up to ARENA_CHUNK_MAX
+    assert(arena->chunk_size > ARENA_CHUNK_MIN);
+    while (arena->chunk_size < ARENA_CHUNK_MAX)
+        assert(arena_alloc(arena, ARENA_CHUNK_MIN) != NULL);
+    assert(arena_alloc(arena, ARENA_CHUNK_MAX) != NULL);
+    assert(arena->chunk_size == ARENA_CHUNK_MAX);
+
+    // large allocation gets its own chunk
+    uint8_t *large = arena_alloc(arena, ARENA_CHUNK_MAX * 3);
+    assert(large != NULL);
+    memset(large, 1, ARENA_CHUNK_MAX * 3);
+    arena_free(arena);
+}
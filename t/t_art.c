@@ -0,0 +1,327 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "art.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_art_new();
+void case_art_clear();
+void case_art_set_get_del_has_size();
+void case_art_prefix_keys();
+void case_art_node_layouts();
+void case_art_long_prefix();
+void case_art_scan_prefix();
+void case_art_longest_prefix();
+void case_art_random();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("art_new", &case_art_new);
+    test_case("art_clear", &case_art_clear);
+    test_case("art_set_get_del_has_size", &case_art_set_get_del_has_size);
+    test_case("art_prefix_keys", &case_art_prefix_keys);
+    test_case("art_node_layouts", &case_art_node_layouts);
+    test_case("art_long_prefix", &case_art_long_prefix);
+    test_case("art_scan_prefix", &case_art_scan_prefix);
+    test_case("art_longest_prefix", &case_art_longest_prefix);
+    test_case("art_random", &case_art_random);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_art_new()
+{
+    art_t *art = art_new();
+    assert(art != NULL && art->root == NULL && art_size(art) == 0);
+    art_free(art);
+}
+
+void
+case_art_clear()
+{
+    art_t *art = art_new();
+    art_set(art, (uint8_t *)"key1", 4, NULL);
+    art_set(art, (uint8_t *)"key2", 4, NULL);
+    assert(art_size(art) == 2);
+    art_clear(art);
+    assert(art_size(art) == 0 && art->root == NULL);
+    assert(!art_has(art, (uint8_t *)"key1", 4));
+    art_free(art);
+}
+
+void
+case_art_set_get_del_has_size()
+{
+    int val1 = 1, val2 = 2;
+    art_t *art = art_new();
+
+    assert(art_set(art, (uint8_t *)"key1", 4, &val1) == ART_OK);
+    assert(art_set(art, (uint8_t *)"key2", 4, &val1) == ART_OK);
+    assert(art_set(art, (uint8_t *)"key2", 4, &val2) == ART_OK);
+    assert(art_size(art) == 2);
+    assert(art_get(art, (uint8_t *)"key1", 4) == &val1);
+    assert(art_get(art, (uint8_t *)"key2", 4) == &val2);
+    assert(art_get(art, (uint8_t *)"key3", 4) == NULL);
+    assert(art_get(art, (uint8_t *)"key", 3) == NULL);
+    assert(art_has(art, (uint8_t *)"key1", 4));
+    assert(art_del(art, (uint8_t *)"key1", 4) == ART_OK);
+    assert(art_del(art, (uint8_t *)"key1", 4) == ART_ENOTFOUND);
+    assert(art_del(art, (uint8_t *)"key", 3) == ART_ENOTFOUND);
+    assert(!art_has(art, (uint8_t *)"key1", 4));
+    assert(art_size(art) == 1);
+    assert(art_del(art, (uint8_t *)"key2", 4) == ART_OK);
+    assert(art_size(art) == 0 && art->root == NULL);
+    art_free(art);
+}
+
+void
+case_art_prefix_keys()
+{
+    char *keys[] = {"abc", "", "a", "abcdef", "ab"};
+    size_t n = sizeof(keys) / sizeof(keys[0]), i, j;
+    art_t *art = art_new();
+
+    // keys prefixing other keys, the empty key included
+    for (i = 0; i < n; i++)
+        assert(art_set(art, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == ART_OK);
+    assert(art_size(art) == n);
+
+    for (i = 0; i < n; i++)
+        assert(art_get(art, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+    assert(!art_has(art, (uint8_t *)"abcd", 4));
+
+    for (i = 0; i < n; i++) {
+        assert(art_del(art, (uint8_t *)keys[i], strlen(keys[i])) ==
+                ART_OK);
+        for (j = i + 1; j < n; j++)
+            assert(art_get(art, (uint8_t *)keys[j], strlen(keys[j])) ==
+                    keys[j]);
+    }
+    assert(art_size(art) == 0 && art->root == NULL);
+    art_free(art);
+}
+
+void
+case_art_node_layouts()
+{
+    uint8_t keys[256][2];
+    size_t i, counts[] = {4, 16, 48, 256};
+    art_node_type_t types[] = {ART_NODE4, ART_NODE16, ART_NODE48,
+        ART_NODE256};
+    art_t *art = art_new();
+
+    for (i = 0; i < 256; i++) {
+        keys[i][0] = 'k';
+        keys[i][1] = 255 - i;
+    }
+
+    // grows as children come
+    size_t t = 0;
+    for (i = 0; i < 256; i++) {
+        assert(art_set(art, keys[i], 2, keys[i]) == ART_OK);
+        if (i == 0)
+            continue;  // a single key is a leaf
+        if (i + 1 > counts[t])
+            t++;
+        assert(((art_node_t *)art->root)->type == types[t]);
+        assert(((art_node_t *)art->root)->prefix_len == 1);
+    }
+
+    for (i = 0; i < 256; i++)
+        assert(art_get(art, keys[i], 2) == keys[i]);
+
+    // shrinks as children go, down to a leaf
+    for (i = 0; i < 255; i++) {
+        assert(art_del(art, keys[i], 2) == ART_OK);
+        assert(art_get(art, keys[i + 1], 2) == keys[i + 1]);
+    }
+    assert((uintptr_t)art->root & 1);
+    assert(art_size(art) == 1);
+    art_free(art);
+}
+
+void
+case_art_long_prefix()
+{
+    char *keys[] = {
+        "/api/v1/users/profiles/settings/a",
+        "/api/v1/users/profiles/settings/b",
+        "/api/v1/users/profiles/avatar",
+        "/api/v1/users/profiles",
+        "/api/v1/users/prefs",
+        "/api/v2",
+    };
+    size_t n = sizeof(keys) / sizeof(keys[0]), i, j;
+    art_t *art = art_new();
+
+    // prefixes longer than ART_PREFIX_MAX split and merge
+    for (i = 0; i < n; i++) {
+        assert(art_set(art, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == ART_OK);
+        for (j = 0; j <= i; j++)
+            assert(art_get(art, (uint8_t *)keys[j], strlen(keys[j])) ==
+                    keys[j]);
+    }
+
+    assert(!art_has(art, (uint8_t *)"/api/v1/users/profiles/settings", 31));
+    assert(!art_has(art, (uint8_t *)"/api/v1/users/profileX/settings/a",
+                33));
+
+    for (i = 0; i < n; i++) {
+        assert(art_del(art, (uint8_t *)keys[i], strlen(keys[i])) ==
+                ART_OK);
+        for (j = i + 1; j < n; j++)
+            assert(art_get(art, (uint8_t *)keys[j], strlen(keys[j])) ==
+                    keys[j]);
+    }
+    art_free(art);
+}
+
+static void
+collect(uint8_t *key, size_t key_len, void *val, void *data)
+{
+    char *out = data;
+    strncat(out, (char *)key, key_len);
+    strcat(out, ",");
+}
+
+void
+case_art_scan_prefix()
+{
+    char *keys[] = {"metrics.cpu.user", "metrics.cpu", "metrics.mem.free",
+        "metrics.cpu.sys", "metric", "other"};
+    size_t n = sizeof(keys) / sizeof(keys[0]), i;
+    char out[256];
+    art_t *art = art_new();
+
+    for (i = 0; i < n; i++)
+        art_set(art, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+
+    out[0] = 0;
+    assert(art_scan_prefix(art, (uint8_t *)"metrics.cpu", 11, &collect,
+                out) == 3);
+    assert(strcmp(out, "metrics.cpu,metrics.cpu.sys,metrics.cpu.user,")
+            == 0);
+
+    out[0] = 0;
+    assert(art_scan_prefix(art, (uint8_t *)"", 0, &collect, out) == n);
+    assert(strcmp(out, "metric,metrics.cpu,metrics.cpu.sys,"
+                "metrics.cpu.user,metrics.mem.free,other,") == 0);
+
+    out[0] = 0;
+    assert(art_scan_prefix(art, (uint8_t *)"metrics.m", 9, &collect,
+                out) == 1);
+    assert(strcmp(out, "metrics.mem.free,") == 0);
+
+    assert(art_scan_prefix(art, (uint8_t *)"metrics.x", 9, &collect,
+                out) == 0);
+    assert(art_scan_prefix(art, (uint8_t *)"metrics.cpu.user.x", 18,
+                &collect, out) == 0);
+    art_free(art);
+}
+
+void
+case_art_longest_prefix()
+{
+    char *keys[] = {"10.", "10.1.", "10.1.2.", "192.168."};
+    size_t n = sizeof(keys) / sizeof(keys[0]), i;
+    art_t *art = art_new();
+
+    for (i = 0; i < n; i++)
+        art_set(art, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+
+    assert(art_longest_prefix(art, (uint8_t *)"10.1.2.3", 8)->val ==
+            keys[2]);
+    assert(art_longest_prefix(art, (uint8_t *)"10.1.3.4", 8)->val ==
+            keys[1]);
+    assert(art_longest_prefix(art, (uint8_t *)"10.2.3.4", 8)->val ==
+            keys[0]);
+    assert(art_longest_prefix(art, (uint8_t *)"10.1.", 5)->val == keys[1]);
+    assert(art_longest_prefix(art, (uint8_t *)"192.168.0.1", 11)->val ==
+            keys[3]);
+    assert(art_longest_prefix(art, (uint8_t *)"192.16", 6) == NULL);
+    assert(art_longest_prefix(art, (uint8_t *)"1", 1) == NULL);
+    art_free(art);
+}
+
+static void
+check_order(uint8_t *key, size_t key_len, void *val, void *data)
+{
+    char **last = data;
+
+    // keys come in memcmp order, shorter first
+    if (*last != NULL) {
+        size_t last_len = strlen(*last);
+        int cmp = memcmp(*last, key, last_len < key_len ? last_len :
+                key_len);
+        assert(cmp < 0 || (cmp == 0 && last_len < key_len));
+    }
+    *last = val;
+}
+
+void
+case_art_random()
+{
+    size_t n = 5000, round, i, size = 0;
+    char (*keys)[32] = malloc(n * 32);
+    assert(keys != NULL);
+    art_t *art = art_new();
+
+    // hierarchical keys sharing prefixes of all lengths
+    srand(1);
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "%s/%zu/%s/%zu", i % 3 ? "host" : "h",
+                i % 7, i % 2 ? "disk.io" : "d", i);
+        if (i % 5 == 0)
+            keys[i][rand() % strlen(keys[i])] = '\0';
+    }
+
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < n; i++) {
+            size_t k = (size_t)rand() % n;
+            size_t len = strlen(keys[k]);
+            bool had = art_has(art, (uint8_t *)keys[k], len);
+
+            if (had) {
+                assert(art_del(art, (uint8_t *)keys[k], len) == ART_OK);
+                size--;
+            } else {
+                assert(art_set(art, (uint8_t *)keys[k], len, keys[k]) ==
+                        ART_OK);
+                size++;
+            }
+        }
+        assert(art_size(art) == size);
+
+        char *last = NULL;
+        assert(art_scan_prefix(art, (uint8_t *)"", 0, &check_order,
+                    &last) == size);
+
+        for (i = 0; i < n; i++) {
+            size_t len = strlen(keys[i]);
+            void *val = art_get(art, (uint8_t *)keys[i], len);
+
+            // duplicated keys may point to another copy
+            assert(val == NULL || strcmp(val, keys[i]) == 0);
+        }
+    }
+
+    art_free(art);
+    free(keys);
+}
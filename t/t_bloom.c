@@ -0,0 +1,142 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "bloom.h"
+#include "dict.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_bloom_new();
+void case_bloom_clear();
+void case_bloom_add_has();
+void case_bloom_fpp();
+void case_bloom_dict();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("bloom_new", &case_bloom_new);
+    test_case("bloom_clear", &case_bloom_clear);
+    test_case("bloom_add_has", &case_bloom_add_has);
+    test_case("bloom_fpp", &case_bloom_fpp);
+    test_case("bloom_dict", &case_bloom_dict);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_bloom_new()
+{
+    bloom_t *bloom = bloom_new(1000, 0);
+    assert(bloom != NULL && bloom_size(bloom) == 0);
+    assert(((uintptr_t)bloom->blocks & 63) == 0);
+    // ~10.5 bits per key for 1%
+    assert(bloom->blocks_num * 256 >= 10000 &&
+            bloom->blocks_num * 256 <= 12000);
+    bloom_free(bloom);
+    bloom = bloom_new(0, 0.001);
+    assert(bloom != NULL && bloom->blocks_num == 1);
+    bloom_free(bloom);
+}
+
+void
+case_bloom_clear()
+{
+    bloom_t *bloom = bloom_new(100, 0);
+    bloom_add(bloom, (uint8_t *)"key1", 4);
+    assert(bloom_has(bloom, (uint8_t *)"key1", 4));
+    assert(bloom_size(bloom) == 1);
+    bloom_clear(bloom);
+    assert(!bloom_has(bloom, (uint8_t *)"key1", 4));
+    assert(bloom_size(bloom) == 0);
+    bloom_free(bloom);
+}
+
+void
+case_bloom_add_has()
+{
+    size_t n = 10000, i;
+    char key[16];
+    bloom_t *bloom = bloom_new(n, 0);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        bloom_add(bloom, (uint8_t *)key, strlen(key));
+    }
+
+    // no false negatives
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        assert(bloom_has(bloom, (uint8_t *)key, strlen(key)));
+    }
+    assert(bloom_size(bloom) == n);
+    bloom_free(bloom);
+}
+
+void
+case_bloom_fpp()
+{
+    double fpps[] = {0.1, 0.01, 0.001};
+    size_t n = 100000, f, i, hits;
+    char key[16];
+
+    for (f = 0; f < sizeof(fpps) / sizeof(fpps[0]); f++) {
+        bloom_t *bloom = bloom_new(n, fpps[f]);
+
+        for (i = 0; i < n; i++) {
+            sprintf(key, "key%zu", i);
+            bloom_add(bloom, (uint8_t *)key, strlen(key));
+        }
+
+        for (i = 0, hits = 0; i < n; i++) {
+            sprintf(key, "miss%zu", i);
+            if (bloom_has(bloom, (uint8_t *)key, strlen(key)))
+                hits++;
+        }
+
+        assert((double)hits / n < fpps[f] * 1.5);
+        bloom_free(bloom);
+    }
+}
+
+void
+case_bloom_dict()
+{
+    size_t n = 1000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+    bloom_t *bloom = bloom_new(n, 0);
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+        bloom_add_hash(bloom, dict_hash(dict, (uint8_t *)keys[i],
+                    strlen(keys[i])));
+    }
+
+    // the filter's hash is reused for the dict lookup
+    for (i = 0; i < n; i++) {
+        uint64_t hash = dict_hash(dict, (uint8_t *)keys[i],
+                strlen(keys[i]));
+        assert(bloom_has_hash(bloom, hash));
+        dict_node_t *node = dict_lookup(dict, (uint8_t *)keys[i],
+                strlen(keys[i]), hash);
+        assert(node != NULL && node->val == keys[i]);
+    }
+
+    bloom_free(bloom);
+    dict_free(dict);
+    free(keys);
+}
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "cache.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_cache_new();
+void case_cache_free();
+void case_cache_clear();
+void case_cache_set_get_del_has_size();
+void case_cache_lru();
+void case_cache_bytes();
+void case_cache_evict();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("cache_new", &case_cache_new);
+    test_case("cache_free", &case_cache_free);
+    test_case("cache_clear", &case_cache_clear);
+    test_case("cache_set_get_del_has_size",
+            &case_cache_set_get_del_has_size);
+    test_case("cache_lru", &case_cache_lru);
+    test_case("cache_bytes", &case_cache_bytes);
+    test_case("cache_evict", &case_cache_evict);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+static void
+count_evict(uint8_t *key, size_t key_len, void *val, void *data)
+{
+    *(size_t *)data += 1;
+}
+
+void
+case_cache_new()
+{
+    cache_t *cache = cache_new(10, 0);
+    assert(cache != NULL && cache->dict != NULL && cache->pool != NULL);
+    assert(cache->head == NULL && cache->tail == NULL);
+    assert(cache->cap == 10 && cache->cap_bytes == 0 && cache->bytes == 0);
+    cache_free(cache);
+}
+
+void
+case_cache_free()
+{
+    cache_t *cache = cache_new(0, 0);
+    char *key1 = "key1", *key2 = "key2";
+    cache_set(cache, (uint8_t *)key1, 4, "val1", 1);
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 1);
+    cache_free(cache);
+}
+
+void
+case_cache_clear()
+{
+    cache_t *cache = cache_new(0, 0);
+    size_t evicted = 0;
+    cache_on_evict(cache, &count_evict, &evicted);
+    char *key1 = "key1", *key2 = "key2";
+    cache_set(cache, (uint8_t *)key1, 4, "val1", 1);
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 1);
+    cache_clear(cache);
+    assert(evicted == 2);
+    assert(cache_size(cache) == 0 && cache->bytes == 0);
+    assert(cache->head == NULL && cache->tail == NULL);
+    assert(cache_get(cache, (uint8_t *)key1, 4) == NULL);
+    assert(cache_set(cache, (uint8_t *)key1, 4, "val1", 1) == CACHE_OK);
+    assert(cache_size(cache) == 1);
+    cache_free(cache);
+    assert(evicted == 3);
+}
+
+void
+case_cache_set_get_del_has_size()
+{
+    cache_t *cache = cache_new(0, 0);
+    char *key1 = "key1", *key2 = "key2", *key3 = "key3";
+    assert(cache_set(cache, (uint8_t *)key1, 4, "val1", 1) == CACHE_OK);
+    assert(cache_set(cache, (uint8_t *)key2, 4, "val2", 1) == CACHE_OK);
+    assert(cache_size(cache) == 2);
+    assert(strcmp(cache_get(cache, (uint8_t *)key1, 4), "val1") == 0);
+    assert(cache_has(cache, (uint8_t *)key2, 4));
+    assert(!cache_has(cache, (uint8_t *)key3, 4));
+    assert(cache_get(cache, (uint8_t *)key3, 4) == NULL);
+    assert(cache_set(cache, (uint8_t *)key1, 4, "new1", 1) == CACHE_OK);
+    assert(strcmp(cache_get(cache, (uint8_t *)key1, 4), "new1") == 0);
+    assert(cache_size(cache) == 2);
+    assert(cache_del(cache, (uint8_t *)key1, 4) == CACHE_OK);
+    assert(cache_del(cache, (uint8_t *)key1, 4) == CACHE_ENOTFOUND);
+    assert(!cache_has(cache, (uint8_t *)key1, 4));
+    assert(cache_size(cache) == 1 && cache->bytes == 1);
+    assert(cache->head == cache->tail);
+    cache_free(cache);
+}
+
+void
+case_cache_lru()
+{
+    cache_t *cache = cache_new(3, 0);
+    char *key1 = "key1", *key2 = "key2", *key3 = "key3", *key4 = "key4";
+    cache_set(cache, (uint8_t *)key1, 4, "val1", 0);
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 0);
+    cache_set(cache, (uint8_t *)key3, 4, "val3", 0);
+    /* key1 becomes most recently used, key2 is the victim */
+    assert(cache_get(cache, (uint8_t *)key1, 4) != NULL);
+    cache_set(cache, (uint8_t *)key4, 4, "val4", 0);
+    assert(cache_size(cache) == 3);
+    assert(!cache_has(cache, (uint8_t *)key2, 4));
+    assert(cache_has(cache, (uint8_t *)key1, 4));
+    assert(cache_has(cache, (uint8_t *)key3, 4));
+    assert(cache_has(cache, (uint8_t *)key4, 4));
+    assert(cache->head->key == (uint8_t *)key4);
+    assert(cache->tail->key == (uint8_t *)key3);
+    /* cache_has doesn't change recency */
+    assert(cache_has(cache, (uint8_t *)key3, 4));
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 0);
+    assert(!cache_has(cache, (uint8_t *)key3, 4));
+    cache_free(cache);
+
+    /* many keys, entries number stays at the cap */
+    cache = cache_new(100, 0);
+    size_t i, n = 10000;
+    char keys[n][8];
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "%zu", i);
+        assert(cache_set(cache, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i], 0) == CACHE_OK);
+        assert(cache_size(cache) <= 100);
+    }
+    for (i = 0; i < n; i++)
+        assert(cache_has(cache, (uint8_t *)keys[i], strlen(keys[i])) ==
+                (i >= n - 100));
+    cache_free(cache);
+}
+
+void
+case_cache_bytes()
+{
+    cache_t *cache = cache_new(0, 10);
+    char *key1 = "key1", *key2 = "key2", *key3 = "key3";
+    cache_set(cache, (uint8_t *)key1, 4, "val1", 4);
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 4);
+    assert(cache->bytes == 8 && cache_size(cache) == 2);
+    cache_set(cache, (uint8_t *)key3, 4, "val3", 4);
+    assert(cache->bytes == 8 && cache_size(cache) == 2);
+    assert(!cache_has(cache, (uint8_t *)key1, 4));
+    /* growing an entry evicts others */
+    cache_set(cache, (uint8_t *)key3, 4, "val3", 8);
+    assert(cache->bytes == 8 && cache_size(cache) == 1);
+    assert(cache_has(cache, (uint8_t *)key3, 4));
+    /* an entry larger than cap_bytes is kept alone */
+    cache_set(cache, (uint8_t *)key1, 4, "val1", 20);
+    assert(cache->bytes == 20 && cache_size(cache) == 1);
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 1);
+    assert(cache->bytes == 1 && cache_size(cache) == 1);
+    cache_free(cache);
+}
+
+void
+case_cache_evict()
+{
+    cache_t *cache = cache_new(2, 0);
+    size_t evicted = 0;
+    cache_on_evict(cache, &count_evict, &evicted);
+    char *key1 = "key1", *key2 = "key2", *key3 = "key3";
+    cache_set(cache, (uint8_t *)key1, 4, "val1", 0);
+    cache_set(cache, (uint8_t *)key2, 4, "val2", 0);
+    assert(evicted == 0);
+    cache_set(cache, (uint8_t *)key3, 4, "val3", 0);
+    assert(evicted == 1);
+    /* same val: no callback, new val: old val is released */
+    cache_set(cache, (uint8_t *)key3, 4, "val3", 0);
+    assert(evicted == 1);
+    cache_set(cache, (uint8_t *)key3, 4, "new3", 0);
+    assert(evicted == 2);
+    cache_del(cache, (uint8_t *)key2, 4);
+    assert(evicted == 3);
+    cache_free(cache);
+    assert(evicted == 4);
+}
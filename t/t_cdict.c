@@ -0,0 +1,136 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "cdict.h"
+
+#define THREADS 8
+#define KEYS 10000
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_cdict_new();
+void case_cdict_free();
+void case_cdict_clear();
+void case_cdict_set_get_del_has_size();
+void case_cdict_threads();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("cdict_new", &case_cdict_new);
+    test_case("cdict_free", &case_cdict_free);
+    test_case("cdict_clear", &case_cdict_clear);
+    test_case("cdict_set_get_del_has_size",
+            &case_cdict_set_get_del_has_size);
+    test_case("cdict_threads", &case_cdict_threads);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_cdict_new()
+{
+    cdict_t *cdict = cdict_new(10);
+    assert(cdict != NULL && cdict->shards_num == 16 &&
+            cdict->shard_bits == 4);
+    cdict_free(cdict);
+    cdict = cdict_new(0);
+    assert(cdict != NULL && cdict->shards_num == CDICT_SHARDS_DEFAULT);
+    cdict_free(cdict);
+}
+
+void
+case_cdict_free()
+{
+    cdict_t *cdict = cdict_new(4);
+    cdict_set(cdict, (uint8_t *)"key1", 4, NULL);
+    cdict_set(cdict, (uint8_t *)"key2", 4, NULL);
+    cdict_free(cdict);
+}
+
+void
+case_cdict_clear()
+{
+    cdict_t *cdict = cdict_new(4);
+    cdict_set(cdict, (uint8_t *)"key1", 4, NULL);
+    cdict_set(cdict, (uint8_t *)"key2", 4, NULL);
+    assert(cdict_size(cdict) == 2);
+    cdict_clear(cdict);
+    assert(cdict_size(cdict) == 0);
+    cdict_free(cdict);
+}
+
+void
+case_cdict_set_get_del_has_size()
+{
+    int val1 = 1, val2 = 2;
+    cdict_t *cdict = cdict_new(1);
+
+    assert(cdict_set(cdict, (uint8_t *)"key1", 4, &val1) == CDICT_OK);
+    assert(cdict_set(cdict, (uint8_t *)"key2", 4, &val2) == CDICT_OK);
+    assert(cdict_get(cdict, (uint8_t *)"key1", 4) == &val1);
+    assert(cdict_get(cdict, (uint8_t *)"key2", 4) == &val2);
+    assert(cdict_has(cdict, (uint8_t *)"key1", 4));
+    assert(cdict_size(cdict) == 2);
+    assert(cdict_del(cdict, (uint8_t *)"key1", 4) == CDICT_OK);
+    assert(cdict_del(cdict, (uint8_t *)"key1", 4) == CDICT_ENOTFOUND);
+    assert(!cdict_has(cdict, (uint8_t *)"key1", 4));
+    assert(cdict_get(cdict, (uint8_t *)"key1", 4) == NULL);
+    assert(cdict_size(cdict) == 1);
+    cdict_free(cdict);
+}
+
+static cdict_t *shared;
+static char keys[THREADS][KEYS][16];
+
+static void *
+writer(void *arg)
+{
+    size_t t = (size_t)arg, i;
+
+    for (i = 0; i < KEYS; i++) {
+        sprintf(keys[t][i], "%zu-%zu", t, i);
+        assert(cdict_set(shared, (uint8_t *)keys[t][i], strlen(keys[t][i]),
+                    keys[t][i]) == CDICT_OK);
+        assert(cdict_get(shared, (uint8_t *)keys[t][i],
+                    strlen(keys[t][i])) == keys[t][i]);
+    }
+
+    for (i = 0; i < KEYS; i += 2)
+        assert(cdict_del(shared, (uint8_t *)keys[t][i], strlen(keys[t][i]))
+                == CDICT_OK);
+    return NULL;
+}
+
+void
+case_cdict_threads()
+{
+    pthread_t threads[THREADS];
+    size_t t, i;
+
+    shared = cdict_new(0);
+
+    for (t = 0; t < THREADS; t++)
+        pthread_create(&threads[t], NULL, &writer, (void *)t);
+    for (t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+
+    assert(cdict_size(shared) == THREADS * KEYS / 2);
+
+    for (t = 0; t < THREADS; t++)
+        for (i = 0; i < KEYS; i++)
+            assert(cdict_get(shared, (uint8_t *)keys[t][i],
+                        strlen(keys[t][i])) == (i % 2 ? keys[t][i] : NULL));
+    cdict_free(shared);
+}
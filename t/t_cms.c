@@ -0,0 +1,146 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "cms.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_cms_new();
+void case_cms_clear();
+void case_cms_add_count();
+void case_cms_error();
+void case_cms_merge();
+void case_cms_dump_load();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("cms_new", &case_cms_new);
+    test_case("cms_clear", &case_cms_clear);
+    test_case("cms_add_count", &case_cms_add_count);
+    test_case("cms_error", &case_cms_error);
+    test_case("cms_merge", &case_cms_merge);
+    test_case("cms_dump_load", &case_cms_dump_load);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_cms_new()
+{
+    cms_t *cms = cms_new(0, 0);
+    assert(cms != NULL && cms->width == CMS_WIDTH_DEFAULT &&
+            cms->depth == CMS_DEPTH_DEFAULT);
+    cms_free(cms);
+    cms = cms_new(1000, 3);
+    assert(cms != NULL && cms->width == 1024 && cms->depth == 3);
+    cms_free(cms);
+}
+
+void
+case_cms_clear()
+{
+    cms_t *cms = cms_new(0, 0);
+    cms_add(cms, (uint8_t *)"key", 3, 5);
+    assert(cms_count(cms, (uint8_t *)"key", 3) == 5 && cms->total == 5);
+    cms_clear(cms);
+    assert(cms_count(cms, (uint8_t *)"key", 3) == 0 && cms->total == 0);
+    cms_free(cms);
+}
+
+void
+case_cms_add_count()
+{
+    cms_t *cms = cms_new(0, 0);
+    assert(cms_add(cms, (uint8_t *)"a", 1, 1) == 1);
+    assert(cms_add(cms, (uint8_t *)"a", 1, 2) == 3);
+    assert(cms_add(cms, (uint8_t *)"b", 1, 7) == 7);
+    assert(cms_count(cms, (uint8_t *)"a", 1) == 3);
+    assert(cms_count(cms, (uint8_t *)"c", 1) == 0);
+
+    // counters saturate
+    assert(cms_add(cms, (uint8_t *)"b", 1, UINT32_MAX) == UINT32_MAX);
+    assert(cms_count(cms, (uint8_t *)"b", 1) == UINT32_MAX);
+    cms_free(cms);
+}
+
+void
+case_cms_error()
+{
+    size_t n = 10000, i, over = 0;
+    char key[32];
+    cms_t *cms = cms_new(2048, 4);
+
+    // zipf like: key i is added n / (i + 1) times
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        cms_add(cms, (uint8_t *)key, strlen(key), n / (i + 1));
+    }
+
+    double bound = (double)cms->total / cms->width * 2.718281828;
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        uint64_t count = cms_count(cms, (uint8_t *)key, strlen(key));
+        assert(count >= n / (i + 1));
+        if (count - n / (i + 1) > bound)
+            over++;
+    }
+
+    // e^-4 of keys may go over the bound
+    assert(over < n / 50);
+    cms_free(cms);
+}
+
+void
+case_cms_merge()
+{
+    cms_t *a = cms_new(0, 0), *b = cms_new(0, 0), *c = cms_new(64, 2);
+
+    cms_add(a, (uint8_t *)"x", 1, 3);
+    cms_add(b, (uint8_t *)"x", 1, 4);
+    cms_add(b, (uint8_t *)"y", 1, 1);
+    assert(cms_merge(a, b) == CMS_OK);
+    assert(cms_count(a, (uint8_t *)"x", 1) == 7);
+    assert(cms_count(a, (uint8_t *)"y", 1) == 1);
+    assert(a->total == 8);
+    assert(cms_merge(a, c) == CMS_EMISMATCH);
+    cms_free(a);
+    cms_free(b);
+    cms_free(c);
+}
+
+void
+case_cms_dump_load()
+{
+    buf_t *buf = buf_new(1024);
+    cms_t *cms = cms_new(256, 3), *copy;
+
+    cms_add(cms, (uint8_t *)"x", 1, 3);
+    assert(cms_dump(cms, buf) == CMS_OK);
+    assert(buf->size == sizeof(cms_header_t) + 256 * 3 * 4);
+
+    copy = cms_load(buf->data, buf->size);
+    assert(copy != NULL && copy->width == 256 && copy->depth == 3);
+    assert(cms_count(copy, (uint8_t *)"x", 1) == 3 && copy->total == 3);
+    cms_free(copy);
+
+    assert(cms_load(buf->data, buf->size - 1) == NULL);
+    assert(cms_load(buf->data, 8) == NULL);
+    buf->data[0] ^= 1;
+    assert(cms_load(buf->data, buf->size) == NULL);
+
+    cms_free(cms);
+    buf_free(buf);
+}
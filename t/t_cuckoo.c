@@ -0,0 +1,161 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "cuckoo.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_cuckoo_new();
+void case_cuckoo_clear();
+void case_cuckoo_add_has_del();
+void case_cuckoo_fpp();
+void case_cuckoo_full();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("cuckoo_new", &case_cuckoo_new);
+    test_case("cuckoo_clear", &case_cuckoo_clear);
+    test_case("cuckoo_add_has_del", &case_cuckoo_add_has_del);
+    test_case("cuckoo_fpp", &case_cuckoo_fpp);
+    test_case("cuckoo_full", &case_cuckoo_full);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_cuckoo_new()
+{
+    cuckoo_t *cuckoo = cuckoo_new(1000);
+    assert(cuckoo != NULL && cuckoo_size(cuckoo) == 0);
+    assert(cuckoo->buckets_num == 512);
+    cuckoo_free(cuckoo);
+    cuckoo = cuckoo_new(0);
+    assert(cuckoo != NULL && cuckoo->buckets_num == 1);
+    cuckoo_free(cuckoo);
+}
+
+void
+case_cuckoo_clear()
+{
+    cuckoo_t *cuckoo = cuckoo_new(100);
+    assert(cuckoo_add(cuckoo, (uint8_t *)"key1", 4) == CUCKOO_OK);
+    assert(cuckoo_has(cuckoo, (uint8_t *)"key1", 4));
+    cuckoo_clear(cuckoo);
+    assert(!cuckoo_has(cuckoo, (uint8_t *)"key1", 4));
+    assert(cuckoo_size(cuckoo) == 0);
+    cuckoo_free(cuckoo);
+}
+
+void
+case_cuckoo_add_has_del()
+{
+    size_t n = 10000, i;
+    char key[16];
+    cuckoo_t *cuckoo = cuckoo_new(n);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        assert(cuckoo_add(cuckoo, (uint8_t *)key, strlen(key)) ==
+                CUCKOO_OK);
+    }
+    assert(cuckoo_size(cuckoo) == n);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        assert(cuckoo_has(cuckoo, (uint8_t *)key, strlen(key)));
+    }
+
+    for (i = 0; i < n; i += 2) {
+        sprintf(key, "key%zu", i);
+        assert(cuckoo_del(cuckoo, (uint8_t *)key, strlen(key)) ==
+                CUCKOO_OK);
+    }
+    assert(cuckoo_size(cuckoo) == n / 2);
+
+    // no false negatives for keys left, deleted keys are gone (but for
+    // fingerprint collisions)
+    size_t hits = 0;
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        if (i % 2)
+            assert(cuckoo_has(cuckoo, (uint8_t *)key, strlen(key)));
+        else if (cuckoo_has(cuckoo, (uint8_t *)key, strlen(key)))
+            hits++;
+    }
+    assert(hits < n / 100);
+
+    // a key added twice needs two deletes
+    assert(cuckoo_add(cuckoo, (uint8_t *)"dup", 3) == CUCKOO_OK);
+    assert(cuckoo_add(cuckoo, (uint8_t *)"dup", 3) == CUCKOO_OK);
+    assert(cuckoo_del(cuckoo, (uint8_t *)"dup", 3) == CUCKOO_OK);
+    assert(cuckoo_has(cuckoo, (uint8_t *)"dup", 3));
+    assert(cuckoo_del(cuckoo, (uint8_t *)"dup", 3) == CUCKOO_OK);
+    assert(cuckoo_del(cuckoo, (uint8_t *)"dup", 3) == CUCKOO_ENOTFOUND);
+    cuckoo_free(cuckoo);
+}
+
+void
+case_cuckoo_fpp()
+{
+    size_t n = 100000, i, hits = 0;
+    char key[16];
+    cuckoo_t *cuckoo = cuckoo_new(n);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        assert(cuckoo_add(cuckoo, (uint8_t *)key, strlen(key)) ==
+                CUCKOO_OK);
+    }
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "miss%zu", i);
+        if (cuckoo_has(cuckoo, (uint8_t *)key, strlen(key)))
+            hits++;
+    }
+
+    // 8 slots checked, 2^-16 each
+    assert((double)hits / n < 0.0005);
+    cuckoo_free(cuckoo);
+}
+
+void
+case_cuckoo_full()
+{
+    size_t i, added = 0;
+    cuckoo_t *cuckoo = cuckoo_new(100);
+    size_t slots = cuckoo->buckets_num * CUCKOO_BUCKET_SLOTS;
+
+    for (i = 0; i < slots * 2; i++) {
+        if (cuckoo_add_hash(cuckoo, hash_u64(i, 0)) != CUCKOO_OK)
+            break;
+        added++;
+    }
+    assert(added > slots * 9 / 10 && added <= slots + 1);
+    assert(cuckoo_add_hash(cuckoo, hash_u64(i, 0)) == CUCKOO_EFULL);
+
+    // every key added is still in, the victim included
+    for (i = 0; i < added; i++)
+        assert(cuckoo_has_hash(cuckoo, hash_u64(i, 0)));
+
+    // the victim takes the first slot freed in its buckets
+    for (i = 0; cuckoo->victim != 0; i++) {
+        assert(i < added);
+        assert(cuckoo_del_hash(cuckoo, hash_u64(i, 0)) == CUCKOO_OK);
+    }
+    assert(cuckoo_add_hash(cuckoo, hash_u64(0, 0)) == CUCKOO_OK);
+    for (; i < added; i++)
+        assert(cuckoo_has_hash(cuckoo, hash_u64(i, 0)));
+    cuckoo_free(cuckoo);
+}
@@ -12,6 +12,20 @@ void case_dict_new();
 void case_dict_free();
 void case_dict_clear();
 void case_dict_set_get_del_has_size();
+void case_dict_rehash();
+void case_dict_iterator();
+void case_dict_use_hash();
+void case_dict_cached_hash();
+void case_dict_get_set_many();
+void case_dict_scan();
+void case_dict_small();
+void case_dict_own_keys();
+void case_dict_shrink();
+void case_dict_reserve();
+void case_dict_stats();
+void case_dict_snapshot();
+void case_dict_snapshot_owned_keys();
+void case_dict_snapshot_detach();
 
 int main(int argc, const char *argv[])
 {
@@ -23,6 +37,20 @@ int main(int argc, const char *argv[])
     test_case("dict_free", &case_dict_free);
     test_case("dict_clear", &case_dict_clear);
     test_case("dict_set_get_del_has_size", &case_dict_set_get_del_has_size);
+    test_case("dict_rehash", &case_dict_rehash);
+    test_case("dict_iterator", &case_dict_iterator);
+    test_case("dict_use_hash", &case_dict_use_hash);
+    test_case("dict_cached_hash", &case_dict_cached_hash);
+    test_case("dict_get_set_many", &case_dict_get_set_many);
+    test_case("dict_scan", &case_dict_scan);
+    test_case("dict_small", &case_dict_small);
+    test_case("dict_own_keys", &case_dict_own_keys);
+    test_case("dict_shrink", &case_dict_shrink);
+    test_case("dict_reserve", &case_dict_reserve);
+    test_case("dict_stats", &case_dict_stats);
+    test_case("dict_snapshot", &case_dict_snapshot);
+    test_case("dict_snapshot_owned_keys", &case_dict_snapshot_owned_keys);
+    test_case("dict_snapshot_detach", &case_dict_snapshot_detach);
     return 0;
 }
 
@@ -38,7 +66,7 @@ case_dict_new()
 {
     dict_t *dict = dict_new();
     assert(dict->size == 0 && dict->table_size_index == 0 &&
-            dict->table != NULL);
+            dict->table == NULL && dict->pool == NULL);
     dict_free(dict);
 }
 
@@ -144,3 +172,746 @@ case_dict_set_get_del_has_size()
 
     dict_free(dict);
 }
+
+void
+case_dict_rehash()
+{
+    size_t n = 10000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        assert(dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == DICT_OK);
+        // every key is reachable while rehashing
+        assert(dict_get(dict, (uint8_t *)keys[0], strlen(keys[0])) ==
+                keys[0]);
+        assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+    }
+
+    assert(dict_size(dict) == n && dict->table_size_index > 0);
+
+    while (dict_rehash(dict, 100));
+    assert(dict->rehash_table == NULL);
+
+    for (i = 0; i < n; i++)
+        assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+    for (i = 0; i < n; i++)
+        assert(dict_del(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                DICT_OK);
+
+    assert(dict_size(dict) == 0);
+    dict_free(dict);
+    free(keys);
+}
+
+void
+case_dict_iterator()
+{
+    size_t n = 1000, i, count = 0;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+
+    // stop right after a resize so both tables hold nodes
+    for (i = 0; i < n && (dict->rehash_table == NULL ||
+                dict->rehash_index == 0 || i < 100); i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+    }
+
+    assert(dict->rehash_table != NULL);
+
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+
+    uint8_t *key;
+    size_t key_len;
+    void *val;
+
+    // explicit rehashing is paused too, the old table stays
+    assert(dict_iterator_next(iterator, &key, &key_len, &val) == DICT_OK);
+    count++;
+    assert(!dict_rehash(dict, n) && dict->rehash_table != NULL);
+
+    while (dict_iterator_next(iterator, &key, &key_len, &val) == DICT_OK) {
+        assert((uint8_t *)val == key);
+        // lookups don't move nodes under an iterator
+        assert(dict_get(dict, key, key_len) == val);
+        count++;
+    }
+
+    assert(count == dict_size(dict));
+    dict_iterator_free(iterator);
+    dict_free(dict);
+    free(keys);
+}
+
+void
+case_dict_use_hash()
+{
+    uint64_t ids[100], i;
+    dict_t *dict = dict_new();
+
+    dict_use_hash(dict, &hash_int);
+
+    for (i = 0; i < 100; i++) {
+        ids[i] = i * 1000;
+        assert(dict_set(dict, (uint8_t *)&ids[i], 8, &ids[i]) == DICT_OK);
+    }
+
+    for (i = 0; i < 100; i++)
+        assert(dict_get(dict, (uint8_t *)&ids[i], 8) == &ids[i]);
+
+    dict_free(dict);
+
+    dict = dict_new();
+    dict_use_hash(dict, &hash_bkdr);
+    assert(dict_set(dict, (uint8_t *)"key", 3, ids) == DICT_OK);
+    assert(dict_get(dict, (uint8_t *)"key", 3) == ids);
+    dict_free(dict);
+}
+
+static size_t hash_calls = 0;
+
+static uint64_t
+counting_hash(uint8_t *key, size_t key_len, uint64_t seed)
+{
+    hash_calls++;
+    return hash_bytes(key, key_len, seed);
+}
+
+void
+case_dict_cached_hash()
+{
+    size_t n = 1000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+
+    dict_use_hash(dict, &counting_hash);
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+    }
+
+    // rehashing reuses the cached hashes
+    while (dict_rehash(dict, 100));
+    assert(hash_calls == n);
+
+    // prefix keys don't match each other
+    assert(dict_get(dict, (uint8_t *)"key1", 4) == keys[1]);
+    assert(dict_get(dict, (uint8_t *)"key10", 5) == keys[10]);
+    assert(dict_get(dict, (uint8_t *)"key", 3) == NULL);
+
+    dict_free(dict);
+    free(keys);
+}
+
+void
+case_dict_get_set_many()
+{
+    size_t n = 1000, i;
+    char (*keys)[16] = malloc(n * 16);
+    uint8_t **key_ptrs = malloc(n * sizeof(uint8_t *));
+    size_t *key_lens = malloc(n * sizeof(size_t));
+    void **vals = malloc(n * sizeof(void *));
+    assert(keys != NULL && key_ptrs != NULL && key_lens != NULL &&
+            vals != NULL);
+    dict_t *dict = dict_new();
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        key_ptrs[i] = (uint8_t *)keys[i];
+        key_lens[i] = strlen(keys[i]);
+        vals[i] = keys[i];
+    }
+
+    // only the first half
+    assert(dict_set_many(dict, key_ptrs, key_lens, vals, n / 2) == DICT_OK);
+    assert(dict_size(dict) == n / 2);
+
+    for (i = 0; i < n; i++)
+        vals[i] = keys;
+
+    dict_get_many(dict, key_ptrs, key_lens, vals, n);
+
+    for (i = 0; i < n; i++)
+        assert(vals[i] == (i < n / 2 ? keys[i] : NULL));
+
+    dict_free(dict);
+    free(vals);
+    free(key_lens);
+    free(key_ptrs);
+    free(keys);
+}
+
+static void
+scan_mark(uint8_t *key, size_t key_len, void *val, void *data)
+{
+    ((uint8_t *)data)[atoi((char *)key + 3)] = 1;
+}
+
+static void
+scan_del_odd(uint8_t *key, size_t key_len, void *val, void *data)
+{
+    if (atoi((char *)key + 3) % 2 == 1)
+        assert(dict_del((dict_t *)data, key, key_len) == DICT_OK);
+}
+
+void
+case_dict_scan()
+{
+    size_t n = 2000, i, cursor = 0;
+    char (*keys)[16] = malloc(n * 16);
+    uint8_t *seen = calloc(n, 1);
+    assert(keys != NULL && seen != NULL);
+    dict_t *dict = dict_new();
+
+    for (i = 0; i < n; i++)
+        sprintf(keys[i], "key%zu", i);
+    for (i = 0; i < n / 2; i++)
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+
+    // the table keeps growing while scanning
+    do {
+        cursor = dict_scan(dict, cursor, &scan_mark, seen);
+        if (i < n) {
+            dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+            i++;
+        }
+    } while (cursor != 0);
+
+    // keys present during the whole scan were all returned
+    for (i = 0; i < n / 2; i++)
+        assert(seen[i] == 1);
+
+    // delete the visited key in callback
+    while (dict_size(dict) < n) {
+        dict_set(dict, (uint8_t *)keys[i % n], strlen(keys[i % n]),
+                keys[i % n]);
+        i++;
+    }
+
+    do {
+        cursor = dict_scan(dict, cursor, &scan_del_odd, dict);
+    } while (cursor != 0);
+
+    assert(dict_size(dict) == n / 2);
+    assert(dict_has(dict, (uint8_t *)"key0", 4));
+    assert(!dict_has(dict, (uint8_t *)"key1", 4));
+
+    dict_free(dict);
+    free(seen);
+    free(keys);
+}
+
+void
+case_dict_small()
+{
+    size_t n = DICT_SMALL_MAX + 1, i, cursor;
+    char (*keys)[16] = malloc(n * 16);
+    uint8_t *seen = calloc(n, 1);
+    assert(keys != NULL && seen != NULL);
+    dict_t *dict = dict_new();
+
+    hash_calls = 0;
+    dict_use_hash(dict, &counting_hash);
+
+    for (i = 0; i < n; i++)
+        sprintf(keys[i], "key%zu", i);
+
+    // small dicts are never hashed
+    for (i = 0; i < n - 1; i++)
+        assert(dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == DICT_OK);
+    assert(dict_set(dict, (uint8_t *)keys[0], strlen(keys[0]),
+                keys[1]) == DICT_OK);
+    assert(dict_get(dict, (uint8_t *)keys[0], strlen(keys[0])) == keys[1]);
+    assert(dict_has(dict, (uint8_t *)keys[1], strlen(keys[1])));
+    assert(!dict_has(dict, (uint8_t *)"key", 3));
+    assert(dict_del(dict, (uint8_t *)keys[2], strlen(keys[2])) == DICT_OK);
+    assert(dict_del(dict, (uint8_t *)keys[2], strlen(keys[2])) ==
+            DICT_ENOTFOUND);
+    assert(dict_set(dict, (uint8_t *)keys[2], strlen(keys[2]),
+                keys[2]) == DICT_OK);
+    assert(dict->table == NULL && dict->pool == NULL && hash_calls == 0);
+    assert(dict_size(dict) == n - 1);
+
+    // scan and iterate all in one pass, deleting the visited key
+    cursor = dict_scan(dict, 0, &scan_mark, seen);
+    assert(cursor == 0);
+    for (i = 0; i < n - 1; i++)
+        assert(seen[i] == 1);
+
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+    uint8_t *key;
+    size_t key_len;
+    void *val;
+    i = 0;
+    while (dict_iterator_next(iterator, &key, &key_len, &val) == DICT_OK) {
+        assert(dict_del(dict, key, key_len) == DICT_OK);
+        i++;
+    }
+    dict_iterator_free(iterator);
+    assert(i == n - 1 && dict_size(dict) == 0);
+
+    // promoted past DICT_SMALL_MAX keys
+    for (i = 0; i < n; i++)
+        assert(dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == DICT_OK);
+    assert(dict->table != NULL && hash_calls == n);
+    for (i = 0; i < n; i++)
+        assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+
+    // small again after clear
+    dict_clear(dict);
+    assert(dict->table == NULL && dict_size(dict) == 0);
+    assert(dict_set(dict, (uint8_t *)keys[0], strlen(keys[0]),
+                keys[0]) == DICT_OK);
+    assert(dict_get(dict, (uint8_t *)keys[0], strlen(keys[0])) == keys[0]);
+
+    dict_free(dict);
+    free(seen);
+    free(keys);
+}
+
+void
+case_dict_own_keys()
+{
+    size_t n = 1000, i;
+    char key[64];
+    dict_t *dict = dict_new();
+
+    assert(dict_own_keys(dict) == DICT_OK && dict->arena != NULL);
+
+    // keys are copied, the caller's buffer is reused
+    for (i = 0; i < n; i++) {
+        sprintf(key, i % 2 ? "key%zu" : "a long key, not stored inline %zu",
+                i);
+        assert(dict_set(dict, (uint8_t *)key, strlen(key),
+                    (void *)(uintptr_t)i) == DICT_OK);
+    }
+    memset(key, 0, sizeof(key));
+
+    assert(dict_size(dict) == n && dict->table != NULL);
+    assert(dict->pool->item_size == sizeof(dict_node_t) + DICT_KEY_INLINE);
+    assert(dict->arena->size > 0);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, i % 2 ? "key%zu" : "a long key, not stored inline %zu",
+                i);
+        assert(dict_get(dict, (uint8_t *)key, strlen(key)) ==
+                (void *)(uintptr_t)i);
+    }
+
+    // short keys live inline in their nodes
+    dict_node_t *node = dict_lookup(dict, (uint8_t *)"key1", 4,
+            dict_hash(dict, (uint8_t *)"key1", 4));
+    assert(node != NULL && node->key == (uint8_t *)(node + 1));
+
+    // replacing keeps the owned key
+    char replace[] = "key1";
+    assert(dict_set(dict, (uint8_t *)replace, 4, NULL) == DICT_OK);
+    assert(node->key != (uint8_t *)replace && node->val == NULL);
+
+    // iterating returns the owned keys
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+    uint8_t *iter_key;
+    size_t key_len;
+    void *val;
+    i = 0;
+    while (dict_iterator_next(iterator, &iter_key, &key_len, &val) ==
+            DICT_OK)
+        i++;
+    assert(i == n);
+    dict_iterator_free(iterator);
+
+    // cleared all at once, owned keys survive promotion
+    dict_clear(dict);
+    assert(dict_size(dict) == 0 && dict->arena->size == 0);
+
+    // the empty key is a key too, small or not
+    assert(dict_set(dict, (uint8_t *)"", 0, key) == DICT_OK);
+    assert(dict_has(dict, (uint8_t *)"", 0) && dict_get(dict,
+                (uint8_t *)"", 0) == key);
+    assert(dict_del(dict, (uint8_t *)"", 0) == DICT_OK);
+    for (i = 0; i < DICT_SMALL_MAX + 1; i++) {
+        sprintf(key, i % 2 ? "key%zu" : "a long key, not stored inline %zu",
+                i);
+        assert(dict_set(dict, (uint8_t *)key, strlen(key),
+                    (void *)(uintptr_t)i) == DICT_OK);
+        if (i == DICT_SMALL_MAX - 1)
+            assert(dict->table == NULL);
+    }
+    assert(dict->table != NULL);
+    memset(key, 0, sizeof(key));
+    for (i = 0; i < DICT_SMALL_MAX + 1; i++) {
+        sprintf(key, i % 2 ? "key%zu" : "a long key, not stored inline %zu",
+                i);
+        assert(dict_get(dict, (uint8_t *)key, strlen(key)) ==
+                (void *)(uintptr_t)i);
+    }
+
+    dict_free(dict);
+}
+
+void
+case_dict_shrink()
+{
+    size_t n = 10000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+    }
+    while (dict_rehash(dict, 100));
+
+    size_t table_size_index = dict->table_size_index;
+
+    // the table shrinks incrementally, keys stay reachable
+    for (i = 0; i < n - 10; i++) {
+        assert(dict_del(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                DICT_OK);
+        assert(dict_get(dict, (uint8_t *)keys[n - 1 - i % 10],
+                    strlen(keys[n - 1 - i % 10])) == keys[n - 1 - i % 10]);
+    }
+    while (dict_rehash(dict, 100));
+
+    assert(dict->table_size_index < table_size_index);
+
+    // the next delete after a shrink finished shrinks again: 9 keys fit
+    // 32 buckets (load below half the limit)
+    assert(dict_del(dict, (uint8_t *)keys[n - 10], strlen(keys[n - 10])) ==
+            DICT_OK);
+    while (dict_rehash(dict, 100));
+    assert(dict->table_size_index == 2 && dict_size(dict) == 9);
+    for (i = n - 9; i < n; i++)
+        assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+
+    // no shrinking while iterating
+    dict_iterator_t *iterator = dict_iterator_new(dict);
+    table_size_index = dict->table_size_index;
+    for (i = n - 9; i < n; i++)
+        dict_del(dict, (uint8_t *)keys[i], strlen(keys[i]));
+    assert(dict->table_size_index == table_size_index &&
+            dict->rehash_table == NULL);
+    dict_iterator_free(iterator);
+
+    dict_free(dict);
+    free(keys);
+}
+
+/**
+ * Test if the table holds `n` keys under the load limit.
+ */
+static bool
+table_sizes_at_least(dict_t *dict, size_t n)
+{
+    return ((size_t)8 << dict->table_size_index) * DICT_LOAD_LIMIT >= n;
+}
+
+void
+case_dict_reserve()
+{
+    size_t n = 10000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+
+    // small dicts stay small
+    assert(dict_reserve(dict, DICT_SMALL_MAX) == DICT_OK);
+    assert(dict->table == NULL);
+
+    assert(dict_reserve(dict, n) == DICT_OK);
+    while (dict_rehash(dict, 100));
+    size_t table_size_index = dict->table_size_index;
+    assert(table_sizes_at_least(dict, n));
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+    }
+
+    // no resize while loading
+    assert(dict->table_size_index == table_size_index &&
+            dict->rehash_table == NULL);
+
+    // reserving less is a no-op, more resizes keeping the keys
+    assert(dict_reserve(dict, n / 2) == DICT_OK);
+    assert(dict->table_size_index == table_size_index);
+    assert(dict_reserve(dict, n * 4) == DICT_OK);
+    assert(dict->table_size_index == table_size_index + 2);
+    for (i = 0; i < n; i++)
+        assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+
+    dict_free(dict);
+    free(keys);
+}
+
+void
+case_dict_stats()
+{
+    size_t n = 1000, i, buckets = 0, chains = 0;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+    dict_stats_t stats;
+
+    // small dicts have no table
+    dict_set(dict, (uint8_t *)"key", 3, NULL);
+    dict_stats(dict, &stats);
+    assert(stats.size == 1 && stats.table_size == 0 &&
+            stats.table_bytes == 0 && stats.node_bytes == 0 &&
+            stats.chain_max == 0 && stats.resizes == 0);
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+    }
+
+    // rehashes finished by the incremental steps are timed
+    dict_stats(dict, &stats);
+    assert(stats.resizes > 1 && stats.rehash_ns > 0);
+    while (dict_rehash(dict, 100));
+
+    dict_stats(dict, &stats);
+    assert(stats.size == n + 1 && stats.rehash_table_size == 0);
+    assert(stats.table_size == (size_t)8 << dict->table_size_index);
+    assert(stats.load > 0 && stats.load <= DICT_LOAD_LIMIT);
+    assert(stats.resizes > 0 && stats.rehash_ns > 0);
+    assert(stats.table_bytes == stats.table_size * sizeof(dict_node_t *));
+    assert(stats.node_bytes >= (n + 1) * sizeof(dict_node_t));
+    assert(stats.key_bytes == 0);
+    assert(stats.chain_max >= 1 && stats.chain_avg >= 1 &&
+            stats.chain_avg <= stats.chain_max);
+
+    // the histogram covers every bucket and every key
+    for (i = 0; i < DICT_STATS_CHAINS; i++) {
+        buckets += stats.chains[i];
+        chains += i * stats.chains[i];
+    }
+    assert(buckets == stats.table_size);
+    if (stats.chain_max < DICT_STATS_CHAINS)
+        assert(chains == n + 1);
+
+    // both tables are walked while rehashing
+    assert(dict_reserve(dict, n * 4) == DICT_OK);
+    dict_rehash(dict, 1);
+    dict_stats(dict, &stats);
+    assert(stats.rehash_table_size > 0 && stats.size == n + 1);
+    assert(stats.table_bytes == (stats.table_size +
+                stats.rehash_table_size) * sizeof(dict_node_t *));
+
+    dict_free(dict);
+    free(keys);
+}
+
+/**
+ * Test if a snapshot holds exactly keys "key0" .. "key<n - 1>", each with
+ * val i + 1.
+ */
+static bool
+snapshot_is(dict_snapshot_t *snapshot, size_t n)
+{
+    uint8_t *key;
+    size_t key_len, count = 0, sum = 0;
+    void *val;
+    char buf[32];
+
+    dict_snapshot_reset(snapshot);
+
+    while (dict_snapshot_next(snapshot, &key, &key_len, &val) == DICT_OK) {
+        size_t i = (uintptr_t)val - 1;
+
+        sprintf(buf, "key%zu", i);
+        if (i >= n || key_len != strlen(buf) ||
+                memcmp(key, buf, key_len) != 0)
+            return false;
+        count++;
+        sum += i;
+    }
+    return count == n && dict_snapshot_size(snapshot) == n &&
+        sum == n * (n - 1) / 2;
+}
+
+void
+case_dict_snapshot()
+{
+    size_t n = 10000, i;
+    char (*keys)[16] = malloc(n * 2 * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+    dict_snapshot_t *snapshot;
+
+    for (i = 0; i < n * 2; i++)
+        sprintf(keys[i], "key%zu", i);
+
+    // small dicts copy their entries
+    for (i = 0; i < 3; i++)
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                (void *)(uintptr_t)(i + 1));
+    snapshot = dict_snapshot_new(dict);
+    assert(snapshot != NULL && dict->snapshot == snapshot);
+    dict_del(dict, (uint8_t *)keys[0], strlen(keys[0]));
+    dict_set(dict, (uint8_t *)keys[1], strlen(keys[1]), NULL);
+    for (i = 3; i < 100; i++)
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), NULL);
+    assert(dict->table != NULL && snapshot_is(snapshot, 3));
+    dict_snapshot_free(snapshot);
+    assert(dict->snapshot == NULL && dict->rehash_paused == 0);
+    dict_clear(dict);
+
+    // taken while rehashing, both tables are copied
+    for (i = 0; i < n; i++)
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                (void *)(uintptr_t)(i + 1));
+    assert(dict->rehash_table != NULL);
+    size_t table_size_index = dict->table_size_index;
+    snapshot = dict_snapshot_new(dict);
+    assert(snapshot != NULL && snapshot_is(snapshot, n));
+
+    // writes don't show in the snapshot, and don't resize the table
+    for (i = 0; i < n; i++) {
+        if (i % 3 == 0)
+            assert(dict_del(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                    DICT_OK);
+        else
+            assert(dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                        NULL) == DICT_OK);
+        assert(dict_set(dict, (uint8_t *)keys[n + i], strlen(keys[n + i]),
+                    keys[n + i]) == DICT_OK);
+    }
+    assert(!dict_rehash(dict, 100));
+    assert(dict->table_size_index == table_size_index &&
+            dict->rehash_table != NULL);
+    assert(snapshot_is(snapshot, n));
+
+    for (i = 0; i < n * 2; i++) {
+        if (i < n && i % 3 == 0)
+            assert(!dict_has(dict, (uint8_t *)keys[i], strlen(keys[i])));
+        else
+            assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                    (i < n ? NULL : keys[i]));
+    }
+
+    // rehashing goes on once freed
+    dict_snapshot_free(snapshot);
+    while (dict_rehash(dict, 100));
+    assert(dict->rehash_table == NULL);
+    assert(dict_size(dict) == n * 2 - (n + 2) / 3);
+    for (i = n; i < n * 2; i++)
+        assert(dict_get(dict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+
+    dict_free(dict);
+    free(keys);
+}
+
+void
+case_dict_snapshot_owned_keys()
+{
+    size_t n = 1000, i;
+    char key[64];
+    dict_t *dict = dict_new();
+    dict_snapshot_t *snapshot;
+
+    assert(dict_own_keys(dict) == DICT_OK);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        dict_set(dict, (uint8_t *)key, strlen(key),
+                (void *)(uintptr_t)(i + 1));
+    }
+    while (dict_rehash(dict, 100));
+
+    // long keys are in the arena, short ones inline in nodes
+    sprintf(key, "a-key-longer-than-%d-bytes", DICT_KEY_INLINE);
+    dict_set(dict, (uint8_t *)key, strlen(key), NULL);
+    snapshot = dict_snapshot_new(dict);
+    assert(snapshot != NULL);
+    assert(dict_del(dict, (uint8_t *)key, strlen(key)) == DICT_OK);
+
+    for (i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        dict_set(dict, (uint8_t *)key, strlen(key), NULL);
+        if (i % 2 == 0)
+            dict_del(dict, (uint8_t *)key, strlen(key));
+    }
+    assert(dict_size(dict) == n / 2);
+
+    uint8_t *snapshot_key;
+    size_t key_len, count = 0;
+    void *val;
+
+    while (dict_snapshot_next(snapshot, &snapshot_key, &key_len, &val) ==
+            DICT_OK) {
+        if (val == NULL) {
+            assert(key_len > DICT_KEY_INLINE);
+            continue;
+        }
+        sprintf(key, "key%zu", (size_t)(uintptr_t)val - 1);
+        assert(key_len == strlen(key) &&
+                memcmp(snapshot_key, key, key_len) == 0);
+        count++;
+    }
+    assert(count == n);
+
+    dict_snapshot_free(snapshot);
+    dict_free(dict);
+}
+
+void
+case_dict_snapshot_detach()
+{
+    size_t n = 1000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    dict_t *dict = dict_new();
+    dict_snapshot_t *snapshot;
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                (void *)(uintptr_t)(i + 1));
+    }
+
+    // the snapshot takes the nodes over on clear, the dict goes on
+    snapshot = dict_snapshot_new(dict);
+    assert(snapshot != NULL);
+    dict_set(dict, (uint8_t *)keys[0], strlen(keys[0]), NULL);
+    dict_clear(dict);
+    assert(snapshot->dict == NULL && dict->snapshot == NULL &&
+            dict->rehash_paused == 0);
+    for (i = 0; i < n / 2; i++)
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), NULL);
+    assert(snapshot_is(snapshot, n));
+    dict_snapshot_free(snapshot);
+    assert(dict_size(dict) == n / 2);
+
+    // and on free, keys owned by the dict too
+    dict_free(dict);
+    dict = dict_new();
+    assert(dict_own_keys(dict) == DICT_OK);
+    for (i = 0; i < n; i++)
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]),
+                (void *)(uintptr_t)(i + 1));
+    snapshot = dict_snapshot_new(dict);
+    assert(snapshot != NULL);
+    dict_free(dict);
+    memset(keys, 0, n * 16);
+    assert(snapshot_is(snapshot, n));
+    dict_snapshot_free(snapshot);
+
+    free(keys);
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "edict.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_edict_new();
+void case_edict_free();
+void case_edict_clear();
+void case_edict_set_get_del_has_size();
+void case_edict_lazy_expire();
+void case_edict_expire();
+void case_edict_deadline();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("edict_new", &case_edict_new);
+    test_case("edict_free", &case_edict_free);
+    test_case("edict_clear", &case_edict_clear);
+    test_case("edict_set_get_del_has_size",
+            &case_edict_set_get_del_has_size);
+    test_case("edict_lazy_expire", &case_edict_lazy_expire);
+    test_case("edict_expire", &case_edict_expire);
+    test_case("edict_deadline", &case_edict_deadline);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+static uint64_t now = 1000;
+
+static uint64_t
+test_clock(void)
+{
+    return now;
+}
+
+/**
+ * Test that the heap is ordered and entries know their positions.
+ */
+static void
+check_heap(edict_t *edict)
+{
+    size_t i;
+    for (i = 0; i < edict->heap_size; i++) {
+        assert((edict->heap)[i]->heap_index == i);
+        if (i > 0)
+            assert((edict->heap)[(i - 1) / 2]->deadline <=
+                    (edict->heap)[i]->deadline);
+    }
+}
+
+void
+case_edict_new()
+{
+    edict_t *edict = edict_new();
+    assert(edict != NULL && edict->dict != NULL && edict->pool != NULL);
+    assert(edict->heap_size == 0 && edict->clock == &edict_time);
+    edict_free(edict);
+}
+
+void
+case_edict_free()
+{
+    edict_t *edict = edict_new();
+    char *key1 = "key1", *key2 = "key2";
+    edict_set(edict, (uint8_t *)key1, 4, "val1", 0);
+    edict_set(edict, (uint8_t *)key2, 4, "val2", edict_time() + 10000);
+    edict_free(edict);
+}
+
+void
+case_edict_clear()
+{
+    edict_t *edict = edict_new();
+    char *key1 = "key1", *key2 = "key2";
+    edict_set(edict, (uint8_t *)key1, 4, "val1", 0);
+    edict_set(edict, (uint8_t *)key2, 4, "val2", edict_time() + 10000);
+    edict_clear(edict);
+    assert(edict_size(edict) == 0 && edict->heap_size == 0);
+    assert(!edict_has(edict, (uint8_t *)key2, 4));
+    assert(edict_set(edict, (uint8_t *)key2, 4, "val2", 1) == EDICT_OK);
+    assert(edict->heap_size == 1);
+    edict_free(edict);
+}
+
+void
+case_edict_set_get_del_has_size()
+{
+    edict_t *edict = edict_new();
+    edict_use_clock(edict, &test_clock);
+    char *key1 = "key1", *key2 = "key2", *key3 = "key3";
+    assert(edict_set(edict, (uint8_t *)key1, 4, "val1", 0) == EDICT_OK);
+    assert(edict_set(edict, (uint8_t *)key2, 4, "val2", now + 10) ==
+            EDICT_OK);
+    assert(edict_size(edict) == 2 && edict->heap_size == 1);
+    assert(strcmp(edict_get(edict, (uint8_t *)key1, 4), "val1") == 0);
+    assert(strcmp(edict_get(edict, (uint8_t *)key2, 4), "val2") == 0);
+    assert(edict_has(edict, (uint8_t *)key1, 4));
+    assert(!edict_has(edict, (uint8_t *)key3, 4));
+    assert(edict_get(edict, (uint8_t *)key3, 4) == NULL);
+    assert(edict_del(edict, (uint8_t *)key2, 4) == EDICT_OK);
+    assert(edict_del(edict, (uint8_t *)key2, 4) == EDICT_ENOTFOUND);
+    assert(edict_size(edict) == 1 && edict->heap_size == 0);
+    edict_free(edict);
+}
+
+void
+case_edict_lazy_expire()
+{
+    edict_t *edict = edict_new();
+    edict_use_clock(edict, &test_clock);
+    char *key1 = "key1", *key2 = "key2";
+    edict_set(edict, (uint8_t *)key1, 4, "val1", now + 10);
+    edict_set(edict, (uint8_t *)key2, 4, "val2", now + 20);
+    now += 10;
+    assert(edict_size(edict) == 2);
+    assert(edict_get(edict, (uint8_t *)key1, 4) == NULL);
+    assert(edict_size(edict) == 1 && edict->heap_size == 1);
+    assert(edict_has(edict, (uint8_t *)key2, 4));
+    now += 10;
+    assert(!edict_has(edict, (uint8_t *)key2, 4));
+    assert(edict_del(edict, (uint8_t *)key2, 4) == EDICT_ENOTFOUND);
+    assert(edict_size(edict) == 0 && edict->heap_size == 0);
+    edict_free(edict);
+}
+
+void
+case_edict_expire()
+{
+    edict_t *edict = edict_new();
+    edict_use_clock(edict, &test_clock);
+    size_t i, n = 10000;
+    char keys[n][8];
+    /* deadlines shuffled: i * 7919 % n */
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "%zu", i);
+        assert(edict_set(edict, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i], now + 1 + (i * 7919) % n) == EDICT_OK);
+    }
+    check_heap(edict);
+    assert(edict_expire(edict, 0) == 0);
+    now += 100;
+    assert(edict_expire(edict, 30) == 30);
+    assert(edict_expire(edict, 0) == 70);
+    assert(edict_size(edict) == n - 100);
+    check_heap(edict);
+    for (i = 0; i < n; i++)
+        assert(edict_has(edict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                ((i * 7919) % n >= 100));
+    now += n;
+    assert(edict_expire(edict, 0) == n - 100);
+    assert(edict_size(edict) == 0 && edict->heap_size == 0);
+    edict_free(edict);
+}
+
+void
+case_edict_deadline()
+{
+    edict_t *edict = edict_new();
+    edict_use_clock(edict, &test_clock);
+    char *key1 = "key1", *key2 = "key2", *key3 = "key3";
+    edict_set(edict, (uint8_t *)key1, 4, "val1", now + 10);
+    edict_set(edict, (uint8_t *)key2, 4, "val2", now + 20);
+    edict_set(edict, (uint8_t *)key3, 4, "val3", now + 30);
+    assert(edict_deadline(edict, (uint8_t *)key2, 4) == now + 20);
+    /* move key3 earliest, key1 latest */
+    edict_set(edict, (uint8_t *)key3, 4, "val3", now + 5);
+    edict_set(edict, (uint8_t *)key1, 4, "val1", now + 40);
+    check_heap(edict);
+    assert((edict->heap)[0]->key == (uint8_t *)key3);
+    /* persist key2, expire key3 */
+    edict_set(edict, (uint8_t *)key2, 4, "val2", 0);
+    assert(edict_deadline(edict, (uint8_t *)key2, 4) == 0);
+    assert(edict->heap_size == 2);
+    now += 5;
+    assert(edict_expire(edict, 0) == 1);
+    assert(edict_has(edict, (uint8_t *)key1, 4));
+    assert(edict_has(edict, (uint8_t *)key2, 4));
+    /* set a deadline on a persistent key */
+    edict_set(edict, (uint8_t *)key2, 4, "val2", now + 1);
+    assert(edict->heap_size == 2);
+    check_heap(edict);
+    now += 100;
+    assert(edict_expire(edict, 0) == 2);
+    assert(edict_size(edict) == 0);
+    edict_free(edict);
+}
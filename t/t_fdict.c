@@ -0,0 +1,107 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "fdict.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_fdict_freeze();
+void case_fdict_get_has_size();
+void case_fdict_empty();
+void case_fdict_keys_copied();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("fdict_freeze", &case_fdict_freeze);
+    test_case("fdict_get_has_size", &case_fdict_get_has_size);
+    test_case("fdict_empty", &case_fdict_empty);
+    test_case("fdict_keys_copied", &case_fdict_keys_copied);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_fdict_freeze()
+{
+    dict_t *dict = dict_new();
+    char *key1 = "key1", *key2 = "key22", *key3 = "key333";
+    dict_set(dict, (uint8_t *)key1, 4, "val1");
+    dict_set(dict, (uint8_t *)key2, 5, "val2");
+    dict_set(dict, (uint8_t *)key3, 6, "val3");
+    fdict_t *fdict = dict_freeze(dict);
+    dict_free(dict);
+    assert(fdict != NULL && fdict->size == 3 && fdict->slots == 4 &&
+            fdict->buckets == 2);
+    /* slots are minimal: keys are packed without gaps */
+    assert((fdict->offsets32)[0] == 0 && (fdict->offsets32)[3] == 15);
+    /* small keys use 32 bits offsets */
+    assert(fdict->offsets64 == NULL);
+    fdict_free(fdict);
+}
+
+void
+case_fdict_get_has_size()
+{
+    dict_t *dict = dict_new();
+    size_t i, n = 100000;
+    char (*keys)[8] = malloc(n * 8);
+    assert(keys != NULL);
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "%zu", i);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), keys[i]);
+    }
+    fdict_t *fdict = dict_freeze(dict);
+    dict_free(dict);
+    assert(fdict != NULL && fdict_size(fdict) == n);
+    for (i = 0; i < n; i++) {
+        assert(fdict_get(fdict, (uint8_t *)keys[i], strlen(keys[i])) ==
+                keys[i]);
+        assert(fdict_has(fdict, (uint8_t *)keys[i], strlen(keys[i])));
+    }
+    char *missing1 = "100000", *missing2 = "key";
+    assert(fdict_get(fdict, (uint8_t *)missing1, 6) == NULL);
+    assert(!fdict_has(fdict, (uint8_t *)missing2, 3));
+    assert(!fdict_has(fdict, (uint8_t *)missing2, 0));
+    fdict_free(fdict);
+    free(keys);
+}
+
+void
+case_fdict_empty()
+{
+    dict_t *dict = dict_new();
+    fdict_t *fdict = dict_freeze(dict);
+    dict_free(dict);
+    assert(fdict != NULL && fdict_size(fdict) == 0);
+    char *key = "key";
+    assert(fdict_get(fdict, (uint8_t *)key, 3) == NULL);
+    assert(!fdict_has(fdict, (uint8_t *)key, 0));
+    fdict_free(fdict);
+}
+
+void
+case_fdict_keys_copied()
+{
+    dict_t *dict = dict_new();
+    char key[] = "key1";
+    dict_set(dict, (uint8_t *)key, 4, "val1");
+    fdict_t *fdict = dict_freeze(dict);
+    dict_free(dict);
+    key[3] = '2';
+    char *key1 = "key1";
+    assert(strcmp(fdict_get(fdict, (uint8_t *)key1, 4), "val1") == 0);
+    assert(!fdict_has(fdict, (uint8_t *)key, 4));
+    fdict_free(fdict);
+}
@@ -0,0 +1,108 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "hash.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_hash_seed();
+void case_hash_bytes();
+void case_hash_int();
+void case_hash_bkdr();
+void case_hash_distribution();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("hash_seed", &case_hash_seed);
+    test_case("hash_bytes", &case_hash_bytes);
+    test_case("hash_int", &case_hash_int);
+    test_case("hash_bkdr", &case_hash_bkdr);
+    test_case("hash_distribution", &case_hash_distribution);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_hash_seed()
+{
+    assert(hash_seed() == hash_seed());
+
+    // new seeds are fresh each call
+    uint64_t seed = hash_seed_new();
+    assert(seed != 0 && seed != hash_seed_new() && seed != hash_seed());
+}
+
+void
+case_hash_bytes()
+{
+    uint8_t data[128];
+    size_t len, i;
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)i;
+
+    // all lengths, both the short and the 48 bytes block paths
+    for (len = 0; len < sizeof(data); len++) {
+        uint64_t hash = hash_bytes(data, len, 0);
+        assert(hash == hash_bytes(data, len, 0));
+        assert(hash != hash_bytes(data, len, 1));
+        if (len > 0)
+            assert(hash != hash_bytes(data, len - 1, 0));
+    }
+
+    // flipping any bit changes the hash
+    for (i = 0; i < 100; i++) {
+        uint64_t hash = hash_bytes(data, 100, 7);
+        data[i] ^= 1;
+        assert(hash != hash_bytes(data, 100, 7));
+        data[i] ^= 1;
+    }
+}
+
+void
+case_hash_int()
+{
+    uint64_t u64 = 12345;
+    uint32_t u32 = 12345;
+
+    assert(hash_int((uint8_t *)&u64, 8, 1) == hash_int((uint8_t *)&u64, 8, 1));
+    assert(hash_int((uint8_t *)&u64, 8, 1) != hash_int((uint8_t *)&u32, 4, 1));
+    assert(hash_int((uint8_t *)"abc", 3, 1) == hash_bytes((uint8_t *)"abc",
+                3, 1));
+}
+
+void
+case_hash_bkdr()
+{
+    assert(hash_bkdr((uint8_t *)"a", 1, 0) == 'a');
+    assert(hash_bkdr((uint8_t *)"ab", 2, 0) == 'a' * 13131 + 'b');
+}
+
+void
+case_hash_distribution()
+{
+    // sequential keys spread evenly over the low bits (power of 2 tables)
+    size_t buckets[64] = {0};
+    uint64_t key;
+    size_t i;
+
+    for (key = 0; key < 64 * 1000; key++)
+        buckets[hash_int((uint8_t *)&key, 8, hash_seed()) & 63]++;
+
+    for (i = 0; i < 64; i++)
+        assert(buckets[i] > 800 && buckets[i] < 1200);
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "hll.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_hll_new();
+void case_hll_clear();
+void case_hll_sparse();
+void case_hll_count();
+void case_hll_merge();
+void case_hll_dump_load();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("hll_new", &case_hll_new);
+    test_case("hll_clear", &case_hll_clear);
+    test_case("hll_sparse", &case_hll_sparse);
+    test_case("hll_count", &case_hll_count);
+    test_case("hll_merge", &case_hll_merge);
+    test_case("hll_dump_load", &case_hll_dump_load);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+/**
+ * Add keys "user<from>" .. "user<to - 1>".
+ */
+static void
+add_users(hll_t *hll, size_t from, size_t to)
+{
+    char key[32];
+    size_t i;
+
+    for (i = from; i < to; i++) {
+        sprintf(key, "user%zu", i);
+        assert(hll_add(hll, (uint8_t *)key, strlen(key)) == HLL_OK);
+    }
+}
+
+static bool
+near(uint64_t estimate, size_t n, double error)
+{
+    return estimate >= n * (1 - error) && estimate <= n * (1 + error);
+}
+
+void
+case_hll_new()
+{
+    hll_t *hll = hll_new(0);
+    assert(hll != NULL && hll->precision == HLL_PRECISION_DEFAULT);
+    assert(hll->registers == NULL && hll_count(hll) == 0);
+    hll_free(hll);
+}
+
+void
+case_hll_clear()
+{
+    hll_t *hll = hll_new(10);
+    add_users(hll, 0, 1000);
+    assert(hll->registers != NULL);
+    hll_clear(hll);
+    assert(hll->registers == NULL && hll_count(hll) == 0);
+    add_users(hll, 0, 10);
+    assert(hll_count(hll) == 10);
+    hll_free(hll);
+}
+
+void
+case_hll_sparse()
+{
+    hll_t *hll = hll_new(14);
+
+    // duplicates don't count
+    add_users(hll, 0, 100);
+    add_users(hll, 0, 100);
+    assert(hll->registers == NULL && hll->sparse_size <= 100);
+    assert(near(hll_count(hll), 100, 0.02));
+
+    // turns dense at 1/16 of the registers
+    add_users(hll, 100, 2000);
+    assert(hll->registers != NULL && hll->sparse == NULL);
+    assert(near(hll_count(hll), 2000, 0.03));
+    hll_free(hll);
+}
+
+void
+case_hll_count()
+{
+    size_t ns[] = {10000, 100000, 1000000}, i;
+    hll_t *hll = hll_new(14);
+
+    for (i = 0; i < sizeof(ns) / sizeof(ns[0]); i++) {
+        hll_clear(hll);
+        add_users(hll, 0, ns[i]);
+        // 0.81% standard error, allow 3 sigmas
+        assert(near(hll_count(hll), ns[i], 0.025));
+    }
+    hll_free(hll);
+}
+
+void
+case_hll_merge()
+{
+    hll_t *a = hll_new(12), *b = hll_new(12), *c = hll_new(12);
+    hll_t *d = hll_new(13);
+
+    // overlapping sets, dense + sparse
+    add_users(a, 0, 50000);
+    add_users(b, 40000, 40100);
+    add_users(c, 25000, 75000);
+    assert(hll_merge(a, b) == HLL_OK);
+    assert(near(hll_count(a), 50000, 0.05));
+    assert(hll_merge(b, c) == HLL_OK);
+    assert(b->registers != NULL);
+    assert(hll_merge(a, c) == HLL_OK);
+    assert(near(hll_count(a), 75000, 0.05));
+
+    assert(hll_merge(a, d) == HLL_EMISMATCH);
+    hll_free(a);
+    hll_free(b);
+    hll_free(c);
+    hll_free(d);
+}
+
+void
+case_hll_dump_load()
+{
+    buf_t *buf = buf_new(1024);
+    hll_t *hll = hll_new(12), *copy;
+    size_t i;
+
+    // empty, sparse and dense
+    for (i = 0; i < 3; i++) {
+        buf_clear(buf);
+        assert(hll_dump(hll, buf) == HLL_OK);
+        copy = hll_load(buf->data, buf->size);
+        assert(copy != NULL && hll_count(copy) == hll_count(hll));
+        assert((copy->registers == NULL) == (hll->registers == NULL));
+        add_users(copy, 0, 10);
+        hll_free(copy);
+        add_users(hll, i * 100, i * 100 + (i + 1) * 100 * i);
+    }
+
+    buf_clear(buf);
+    hll_dump(hll, buf);
+    assert(hll_load(buf->data, buf->size - 1) == NULL);
+    buf->data[0] ^= 1;
+    assert(hll_load(buf->data, buf->size) == NULL);
+
+    hll_free(hll);
+    buf_free(buf);
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "htable.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_htable_new();
+void case_htable_free();
+void case_htable_clear();
+void case_htable_set_get_del_has_size();
+void case_htable_resize();
+void case_htable_iterator();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+
+    test_case("htable_new", &case_htable_new);
+    test_case("htable_free", &case_htable_free);
+    test_case("htable_clear", &case_htable_clear);
+    test_case("htable_set_get_del_has_size",
+            &case_htable_set_get_del_has_size);
+    test_case("htable_resize", &case_htable_resize);
+    test_case("htable_iterator", &case_htable_iterator);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_htable_new()
+{
+    htable_t *htable = htable_new();
+    assert(htable->size == 0 && htable->cap == HTABLE_CAP_MIN &&
+            htable->ctrl != NULL && htable->slots != NULL);
+    htable_free(htable);
+}
+
+void
+case_htable_free()
+{
+    htable_t *htable = htable_new();
+    htable_set(htable, (uint8_t *)"key1", 4, NULL);
+    htable_set(htable, (uint8_t *)"key2", 4, NULL);
+    htable_free(htable);
+}
+
+void
+case_htable_clear()
+{
+    htable_t *htable = htable_new();
+    htable_set(htable, (uint8_t *)"key1", 4, NULL);
+    htable_set(htable, (uint8_t *)"key2", 4, NULL);
+    htable_set(htable, (uint8_t *)"key3", 4, NULL);
+    assert(htable->size == 3);
+    htable_clear(htable);
+    assert(htable->size == 0);
+    assert(!htable_has(htable, (uint8_t *)"key1", 4));
+    htable_free(htable);
+}
+
+void
+case_htable_set_get_del_has_size()
+{
+    int val1 = 1, val2 = 2, val3 = 3;
+
+    htable_t *htable = htable_new();
+
+    assert(htable_set(htable, (uint8_t *)"key1", 4, &val1) == HTABLE_OK);
+    assert(htable_set(htable, (uint8_t *)"key2", 4, &val2) == HTABLE_OK);
+    assert(htable_set(htable, (uint8_t *)"key", 3, &val3) == HTABLE_OK);
+    assert(htable_size(htable) == 3);
+
+    assert(htable_get(htable, (uint8_t *)"key1", 4) == &val1);
+    assert(htable_get(htable, (uint8_t *)"key2", 4) == &val2);
+    assert(htable_get(htable, (uint8_t *)"key", 3) == &val3);
+    assert(htable_get(htable, (uint8_t *)"key3", 4) == NULL);
+
+    // update
+    assert(htable_set(htable, (uint8_t *)"key1", 4, &val3) == HTABLE_OK);
+    assert(htable_get(htable, (uint8_t *)"key1", 4) == &val3);
+    assert(htable_size(htable) == 3);
+
+    assert(htable_has(htable, (uint8_t *)"key2", 4) == true);
+    assert(htable_del(htable, (uint8_t *)"key2", 4) == HTABLE_OK);
+    assert(htable_has(htable, (uint8_t *)"key2", 4) == false);
+    assert(htable_del(htable, (uint8_t *)"key2", 4) == HTABLE_ENOTFOUND);
+    assert(htable_size(htable) == 2);
+    htable_free(htable);
+}
+
+void
+case_htable_resize()
+{
+    size_t n = 10000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    htable_t *htable = htable_new();
+
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "key%zu", i);
+        assert(htable_set(htable, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == HTABLE_OK);
+    }
+
+    assert(htable_size(htable) == n && htable->cap >= n);
+
+    // delete half, deleted slots are reused or dropped on rehash
+    for (i = 0; i < n; i += 2)
+        assert(htable_del(htable, (uint8_t *)keys[i],
+                    strlen(keys[i])) == HTABLE_OK);
+    for (i = 0; i < n; i += 2)
+        assert(htable_set(htable, (uint8_t *)keys[i], strlen(keys[i]),
+                    keys[i]) == HTABLE_OK);
+
+    assert(htable_size(htable) == n);
+
+    for (i = 0; i < n; i++)
+        assert(htable_get(htable, (uint8_t *)keys[i],
+                    strlen(keys[i])) == keys[i]);
+
+    htable_free(htable);
+    free(keys);
+}
+
+void
+case_htable_iterator()
+{
+    int val1 = 1, val2 = 2, val3 = 3;
+
+    htable_t *htable = htable_new();
+    htable_set(htable, (uint8_t *)"key1", 4, &val1);
+    htable_set(htable, (uint8_t *)"key2", 4, &val2);
+    htable_set(htable, (uint8_t *)"key3", 4, &val3);
+
+    htable_iterator_t *iterator = htable_iterator_new(htable);
+
+    uint8_t *key;
+    size_t key_len;
+    void *val;
+    int sum = 0;
+
+    while (htable_iterator_next(iterator, &key, &key_len, &val) ==
+            HTABLE_OK) {
+        assert(key_len == 4);
+        sum += *(int *)val;
+    }
+
+    assert(sum == 6);
+
+    htable_iterator_reset(iterator);
+    assert(htable_iterator_next(iterator, &key, &key_len, &val) ==
+            HTABLE_OK);
+    htable_iterator_free(iterator);
+    htable_free(htable);
+}
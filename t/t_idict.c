@@ -0,0 +1,155 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "idict.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_idict_new();
+void case_idict_free();
+void case_idict_clear();
+void case_idict_set_get_del_has_size();
+void case_idict_rehash();
+void case_idict_iterator();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("idict_new", &case_idict_new);
+    test_case("idict_free", &case_idict_free);
+    test_case("idict_clear", &case_idict_clear);
+    test_case("idict_set_get_del_has_size",
+            &case_idict_set_get_del_has_size);
+    test_case("idict_rehash", &case_idict_rehash);
+    test_case("idict_iterator", &case_idict_iterator);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_idict_new()
+{
+    idict_t *idict = idict_new();
+    assert(idict != NULL && idict->size == 0 && idict->table != NULL);
+    assert(idict->table_size == IDICT_TABLE_SIZE_MIN);
+    idict_free(idict);
+}
+
+void
+case_idict_free()
+{
+    idict_t *idict = idict_new();
+    idict_set(idict, 1, "val1");
+    idict_set(idict, 2, "val2");
+    idict_free(idict);
+}
+
+void
+case_idict_clear()
+{
+    idict_t *idict = idict_new();
+    idict_set(idict, 1, "val1");
+    idict_set(idict, 2, "val2");
+    idict_clear(idict);
+    assert(idict_size(idict) == 0 && !idict_has(idict, 1));
+    assert(idict_set(idict, 1, "val1") == IDICT_OK);
+    assert(idict_size(idict) == 1);
+    idict_free(idict);
+}
+
+void
+case_idict_set_get_del_has_size()
+{
+    idict_t *idict = idict_new();
+    /* keys are stored inline, no memory has to outlive the entry */
+    uint64_t key;
+    for (key = 0; key < 3; key++)
+        assert(idict_set(idict, key, (void *)(uintptr_t)(key + 1)) ==
+                IDICT_OK);
+    assert(idict_size(idict) == 3);
+    assert(idict_get(idict, 0) == (void *)1);
+    assert(idict_get(idict, 2) == (void *)3);
+    assert(idict_get(idict, 3) == NULL);
+    assert(idict_has(idict, 1) && !idict_has(idict, UINT64_MAX));
+    assert(idict_set(idict, 1, "new") == IDICT_OK);
+    assert(strcmp(idict_get(idict, 1), "new") == 0);
+    assert(idict_size(idict) == 3);
+    assert(idict_del(idict, 1) == IDICT_OK);
+    assert(idict_del(idict, 1) == IDICT_ENOTFOUND);
+    assert(!idict_has(idict, 1) && idict_size(idict) == 2);
+    idict_free(idict);
+}
+
+void
+case_idict_rehash()
+{
+    idict_t *idict = idict_new();
+    uint64_t i, n = 100000;
+
+    for (i = 0; i < n; i++) {
+        assert(idict_set(idict, i * 4096, (void *)(uintptr_t)(i + 1)) ==
+                IDICT_OK);
+        // every key is reachable while rehashing
+        assert(idict_get(idict, (i / 2) * 4096) ==
+                (void *)(uintptr_t)(i / 2 + 1));
+    }
+
+    assert(idict_size(idict) == n && idict->table_size >= n);
+    while (idict_rehash(idict, 100));
+    assert(idict->rehash_table == NULL);
+
+    for (i = 0; i < n; i++)
+        assert(idict_get(idict, i * 4096) == (void *)(uintptr_t)(i + 1));
+    for (i = 0; i < n; i += 2)
+        assert(idict_del(idict, i * 4096) == IDICT_OK);
+    assert(idict_size(idict) == n / 2);
+    assert(!idict_has(idict, 0) && idict_has(idict, 4096));
+    idict_free(idict);
+}
+
+void
+case_idict_iterator()
+{
+    idict_t *idict = idict_new();
+    uint64_t i, n = 1000, key, sum = 0, count = 0;
+    void *val;
+
+    for (i = 0; i < n; i++)
+        idict_set(idict, i, (void *)(uintptr_t)i);
+
+    // stop right after a resize so both tables hold nodes
+    for (; idict->rehash_table == NULL || idict->rehash_index == 0; i++)
+        idict_set(idict, i, (void *)(uintptr_t)i);
+    n = i;
+
+    idict_iterator_t *iterator = idict_iterator_new(idict);
+    assert(iterator != NULL && idict->rehash_paused == 1);
+
+    // explicit rehashing is paused too, the old table stays
+    assert(idict_iterator_next(iterator, &key, &val) == IDICT_OK);
+    sum += key;
+    count++;
+    assert(!idict_rehash(idict, n) && idict->rehash_table != NULL);
+
+    while (idict_iterator_next(iterator, &key, &val) == IDICT_OK) {
+        assert((uint64_t)(uintptr_t)val == key);
+        sum += key;
+        count++;
+    }
+
+    assert(count == n && sum == n * (n - 1) / 2);
+    idict_iterator_free(iterator);
+    assert(idict->rehash_paused == 0);
+    idict_free(idict);
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "intern.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_intern_new();
+void case_intern_free();
+void case_intern_clear();
+void case_intern_put_get();
+void case_intern_id_str_len();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("intern_new", &case_intern_new);
+    test_case("intern_free", &case_intern_free);
+    test_case("intern_clear", &case_intern_clear);
+    test_case("intern_put_get", &case_intern_put_get);
+    test_case("intern_id_str_len", &case_intern_id_str_len);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_intern_new()
+{
+    intern_t *interns = intern_new();
+    assert(interns != NULL && interns->dict != NULL &&
+            interns->arena != NULL && intern_size(interns) == 0);
+    intern_free(interns);
+}
+
+void
+case_intern_free()
+{
+    intern_t *interns = intern_new();
+    assert(intern_put(interns, (uint8_t *)"foo", 3) != NULL);
+    assert(intern_put(interns, (uint8_t *)"bar", 3) != NULL);
+    intern_free(interns);
+}
+
+void
+case_intern_clear()
+{
+    intern_t *interns = intern_new();
+    intern_put(interns, (uint8_t *)"foo", 3);
+    intern_put(interns, (uint8_t *)"bar", 3);
+    intern_clear(interns);
+    assert(intern_size(interns) == 0);
+    assert(intern_get(interns, (uint8_t *)"foo", 3) == NULL);
+    assert(intern_str(interns, 0) == NULL);
+    uint8_t *bar = intern_put(interns, (uint8_t *)"bar", 3);
+    assert(bar != NULL && intern_id(bar) == 0);
+    intern_free(interns);
+}
+
+void
+case_intern_put_get()
+{
+    intern_t *interns = intern_new();
+    char buf[16];
+
+    strcpy(buf, "foo");
+    uint8_t *foo = intern_put(interns, (uint8_t *)buf, 3);
+    assert(foo != NULL && foo != (uint8_t *)buf);
+    assert(strcmp((char *)foo, "foo") == 0);
+
+    // the caller's bytes may change, equal bytes map to the same pointer
+    strcpy(buf, "bar");
+    uint8_t *bar = intern_put(interns, (uint8_t *)buf, 3);
+    assert(bar != foo);
+    assert(intern_put(interns, (uint8_t *)"foo", 3) == foo);
+    assert(intern_put(interns, (uint8_t *)"foobar", 3) == foo);
+    assert(intern_get(interns, (uint8_t *)"bar", 3) == bar);
+    assert(intern_get(interns, (uint8_t *)"baz", 3) == NULL);
+    assert(intern_size(interns) == 2);
+
+    // empty and binary strings
+    uint8_t *empty = intern_put(interns, (uint8_t *)"", 0);
+    assert(empty != NULL && intern_len(empty) == 0 && empty[0] == 0);
+    assert(intern_put(interns, (uint8_t *)"a\0b", 3) !=
+            intern_put(interns, (uint8_t *)"a\0c", 3));
+    assert(intern_size(interns) == 5);
+    intern_free(interns);
+}
+
+void
+case_intern_id_str_len()
+{
+    intern_t *interns = intern_new();
+    size_t i, n = 10000;
+    char buf[32];
+
+    for (i = 0; i < n; i++) {
+        sprintf(buf, "ident_%zu", i % 1000);
+        uint8_t *str = intern_put(interns, (uint8_t *)buf, strlen(buf));
+        assert(str != NULL && intern_id(str) == i % 1000);
+        assert(intern_len(str) == strlen(buf));
+    }
+
+    assert(intern_size(interns) == 1000);
+
+    for (i = 0; i < 1000; i++) {
+        sprintf(buf, "ident_%zu", i);
+        assert(strcmp((char *)intern_str(interns, i), buf) == 0);
+    }
+    assert(intern_str(interns, 1000) == NULL);
+    intern_free(interns);
+}
@@ -0,0 +1,163 @@
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "mdict.h"
+
+#define PATH "mdict.test.db"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_mdict_dump_open();
+void case_mdict_get_has_size();
+void case_mdict_empty();
+void case_mdict_open_invalid();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("mdict_dump_open", &case_mdict_dump_open);
+    test_case("mdict_get_has_size", &case_mdict_get_has_size);
+    test_case("mdict_empty", &case_mdict_empty);
+    test_case("mdict_open_invalid", &case_mdict_open_invalid);
+    unlink(PATH);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+/**
+ * Vals are C strings, dumped without the terminator.
+ */
+static size_t
+str_val(void *val, uint8_t **data)
+{
+    *data = val;
+    return strlen(val);
+}
+
+void
+case_mdict_dump_open()
+{
+    dict_t *dict = dict_new();
+    char *key1 = "key1", *key2 = "key2";
+    dict_set(dict, (uint8_t *)key1, 4, "val1");
+    dict_set(dict, (uint8_t *)key2, 4, "val2");
+    assert(mdict_dump(dict, PATH, &str_val) == MDICT_OK);
+    assert(access(PATH ".tmp", F_OK) != 0);
+    dict_free(dict);
+    mdict_t *mdict = mdict_open(PATH);
+    assert(mdict != NULL && mdict->header->magic == MDICT_MAGIC);
+    assert(mdict->header->buckets == 2);
+    // files get a seed of their own
+    assert(mdict->header->seed != hash_seed());
+    mdict_close(mdict);
+}
+
+void
+case_mdict_get_has_size()
+{
+    dict_t *dict = dict_new();
+    size_t i, n = 10000, val_len;
+    char keys[n][8], vals[n][16];
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "%zu", i);
+        sprintf(vals[i], "val%zu", i * 3);
+        dict_set(dict, (uint8_t *)keys[i], strlen(keys[i]), vals[i]);
+    }
+    assert(mdict_dump(dict, PATH, &str_val) == MDICT_OK);
+    dict_free(dict);
+
+    mdict_t *mdict = mdict_open(PATH);
+    assert(mdict != NULL && mdict_size(mdict) == n);
+    assert(mdict->header->buckets == 16384);
+    for (i = 0; i < n; i++) {
+        uint8_t *val = mdict_get(mdict, (uint8_t *)keys[i],
+                strlen(keys[i]), &val_len);
+        assert(val != NULL && val_len == strlen(vals[i]));
+        assert(memcmp(val, vals[i], val_len) == 0);
+        assert(mdict_has(mdict, (uint8_t *)keys[i], strlen(keys[i])));
+    }
+    char *missing = "10000";
+    assert(mdict_get(mdict, (uint8_t *)missing, 5, &val_len) == NULL);
+    assert(!mdict_has(mdict, (uint8_t *)missing, 5));
+    char *longer = "12345";
+    assert(!mdict_has(mdict, (uint8_t *)longer, 5));
+    mdict_close(mdict);
+}
+
+void
+case_mdict_empty()
+{
+    dict_t *dict = dict_new();
+    assert(mdict_dump(dict, PATH, &str_val) == MDICT_OK);
+    dict_free(dict);
+    mdict_t *mdict = mdict_open(PATH);
+    assert(mdict != NULL && mdict_size(mdict) == 0);
+    char *key = "key";
+    assert(mdict_get(mdict, (uint8_t *)key, 3, NULL) == NULL);
+    mdict_close(mdict);
+}
+
+void
+case_mdict_open_invalid()
+{
+    assert(mdict_open("mdict.test.missing") == NULL && errno == ENOENT);
+
+    FILE *stream = fopen(PATH, "w");
+    fputs("not a mdict file", stream);
+    fclose(stream);
+    errno = 0;
+    assert(mdict_open(PATH) == NULL && errno == EINVAL);
+
+    /* truncated file */
+    dict_t *dict = dict_new();
+    char *key1 = "key1";
+    dict_set(dict, (uint8_t *)key1, 4, "val1");
+    assert(mdict_dump(dict, PATH, &str_val) == MDICT_OK);
+    dict_free(dict);
+    assert(truncate(PATH, 90) == 0);
+    errno = 0;
+    assert(mdict_open(PATH) == NULL && errno == EINVAL);
+
+    /* bucket past the records, found on lookup */
+    dict = dict_new();
+    dict_set(dict, (uint8_t *)key1, 4, "val1");
+    assert(mdict_dump(dict, PATH, &str_val) == MDICT_OK);
+    mdict_header_t header;
+    uint64_t word = 1024;
+    stream = fopen(PATH, "r+b");
+    assert(fread(&header, sizeof(header), 1, stream) == 1);
+    fwrite(&word, sizeof(word), 1, stream);
+    fclose(stream);
+    mdict_t *mdict = mdict_open(PATH);
+    assert(mdict != NULL);
+    assert(mdict_get(mdict, (uint8_t *)key1, 4, NULL) == NULL);
+    mdict_close(mdict);
+
+    /* record lengths past the records */
+    assert(mdict_dump(dict, PATH, &str_val) == MDICT_OK);
+    dict_free(dict);
+    stream = fopen(PATH, "r+b");
+    fseek(stream, header.data_offset + sizeof(uint64_t), SEEK_SET);
+    word = 4;
+    fwrite(&word, sizeof(word), 1, stream);
+    word = (uint64_t)-2;
+    fwrite(&word, sizeof(word), 1, stream);
+    fclose(stream);
+    mdict = mdict_open(PATH);
+    assert(mdict != NULL);
+    assert(mdict_get(mdict, (uint8_t *)key1, 4, NULL) == NULL);
+    mdict_close(mdict);
+}
@@ -0,0 +1,235 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "pdict.h"
+
+#define KEYS 100000
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_dict_build_parallel();
+void case_dict_build_parallel_update();
+void case_dict_build_parallel_serial();
+void case_dict_merge();
+void case_dict_merge_seed();
+void case_dict_merge_small();
+void case_dict_merge_owned();
+
+static char keys[KEYS][16];
+static uint8_t *key_ptrs[KEYS];
+static size_t key_lens[KEYS];
+static void *vals[KEYS];
+
+int main(int argc, const char *argv[])
+{
+    size_t i;
+
+    for (i = 0; i < KEYS; i++) {
+        sprintf(keys[i], "key%zu", i);
+        key_ptrs[i] = (uint8_t *)keys[i];
+        key_lens[i] = strlen(keys[i]);
+        vals[i] = keys[i];
+    }
+
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("dict_build_parallel", &case_dict_build_parallel);
+    test_case("dict_build_parallel_update",
+            &case_dict_build_parallel_update);
+    test_case("dict_build_parallel_serial",
+            &case_dict_build_parallel_serial);
+    test_case("dict_merge", &case_dict_merge);
+    test_case("dict_merge_seed", &case_dict_merge_seed);
+    test_case("dict_merge_small", &case_dict_merge_small);
+    test_case("dict_merge_owned", &case_dict_merge_owned);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+static void
+assert_all_keys(dict_t *dict, size_t n)
+{
+    size_t i;
+
+    assert(dict_size(dict) == n);
+    for (i = 0; i < n; i++)
+        assert(dict_get(dict, key_ptrs[i], key_lens[i]) == vals[i]);
+}
+
+void
+case_dict_build_parallel()
+{
+    size_t threads[] = {0, 2, 3, 8}, t;
+
+    for (t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        dict_t *dict = dict_new();
+        assert(dict_build_parallel(dict, key_ptrs, key_lens, vals, KEYS,
+                    threads[t]) == DICT_OK);
+        assert_all_keys(dict, KEYS);
+        assert(dict_size(dict) <= dict_table_size(dict) * DICT_LOAD_LIMIT);
+
+        // the dict keeps working as usual
+        assert(dict_del(dict, key_ptrs[0], key_lens[0]) == DICT_OK);
+        assert(dict_set(dict, key_ptrs[0], key_lens[0], vals[0]) ==
+                DICT_OK);
+        assert_all_keys(dict, KEYS);
+        dict_free(dict);
+    }
+}
+
+void
+case_dict_build_parallel_update()
+{
+    int val = 1;
+    size_t i;
+    dict_t *dict = dict_new();
+
+    // existing keys are updated
+    for (i = 0; i < KEYS; i += 3)
+        dict_set(dict, key_ptrs[i], key_lens[i], &val);
+    assert(dict_build_parallel(dict, key_ptrs, key_lens, vals, KEYS, 4) ==
+            DICT_OK);
+    assert_all_keys(dict, KEYS);
+
+    // later duplicates win
+    uint8_t *dup_keys[PDICT_PARALLEL_MIN * 2];
+    size_t dup_lens[PDICT_PARALLEL_MIN * 2];
+    void *dup_vals[PDICT_PARALLEL_MIN * 2];
+
+    for (i = 0; i < PDICT_PARALLEL_MIN * 2; i++) {
+        dup_keys[i] = key_ptrs[i % PDICT_PARALLEL_MIN];
+        dup_lens[i] = key_lens[i % PDICT_PARALLEL_MIN];
+        dup_vals[i] = i < PDICT_PARALLEL_MIN ? (void *)&val : vals[i %
+            PDICT_PARALLEL_MIN];
+    }
+
+    dict_clear(dict);
+    assert(dict_build_parallel(dict, dup_keys, dup_lens, dup_vals,
+                PDICT_PARALLEL_MIN * 2, 4) == DICT_OK);
+    assert_all_keys(dict, PDICT_PARALLEL_MIN);
+    dict_free(dict);
+}
+
+void
+case_dict_build_parallel_serial()
+{
+    dict_t *dict = dict_new();
+
+    // small batches
+    assert(dict_build_parallel(dict, key_ptrs, key_lens, vals, 5, 4) ==
+            DICT_OK);
+    assert(dict->table == NULL);
+    assert_all_keys(dict, 5);
+    dict_free(dict);
+
+    // owned keys
+    dict = dict_new();
+    assert(dict_own_keys(dict) == DICT_OK);
+    assert(dict_build_parallel(dict, key_ptrs, key_lens, vals, KEYS, 4) ==
+            DICT_OK);
+    assert_all_keys(dict, KEYS);
+    dict_free(dict);
+}
+
+void
+case_dict_merge()
+{
+    int val = 1;
+    size_t i;
+    dict_t *dst = dict_new();
+    dict_t *src = dict_new();
+
+    for (i = 0; i < KEYS; i++)
+        dict_set(i % 2 ? src : dst, key_ptrs[i], key_lens[i],
+                i % 4 == 0 ? (void *)&val : vals[i]);
+    for (i = 0; i < KEYS; i += 4)
+        dict_set(src, key_ptrs[i], key_lens[i], vals[i]);
+
+    assert(dict_merge(dst, src, 4) == DICT_OK);
+    assert_all_keys(dst, KEYS);
+    assert(dict_size(src) == KEYS / 2 + KEYS / 4);
+
+    // merging again changes nothing
+    assert(dict_merge(dst, src, 0) == DICT_OK);
+    assert_all_keys(dst, KEYS);
+
+    // a rehash paused by an iterator
+    dict_t *empty = dict_new();
+    assert(dict_reserve(src, KEYS * 4) == DICT_OK);
+    dict_iterator_t *iterator = dict_iterator_new(src);
+    assert(src->rehash_table != NULL);
+    assert(dict_merge(empty, src, 4) == DICT_OK);
+    assert(src->rehash_table != NULL);
+    assert(dict_size(empty) == dict_size(src));
+    dict_iterator_free(iterator);
+
+    dict_free(empty);
+    dict_free(dst);
+    dict_free(src);
+}
+
+void
+case_dict_merge_seed()
+{
+    dict_t *dst = dict_new();
+    dict_t *src = dict_new();
+
+    dst->seed = src->seed + 1;
+    assert(dict_build_parallel(src, key_ptrs, key_lens, vals, KEYS, 4) ==
+            DICT_OK);
+    assert(dict_merge(dst, src, 4) == DICT_OK);
+    assert_all_keys(dst, KEYS);
+    dict_free(dst);
+    dict_free(src);
+}
+
+void
+case_dict_merge_small()
+{
+    dict_t *dst = dict_new();
+    dict_t *src = dict_new();
+
+    assert(dict_merge(dst, src, 4) == DICT_OK);
+    assert(dict_size(dst) == 0);
+    assert(dict_build_parallel(src, key_ptrs, key_lens, vals, 3, 4) ==
+            DICT_OK);
+    assert(dict_merge(dst, src, 4) == DICT_OK);
+    assert_all_keys(dst, 3);
+    dict_free(dst);
+    dict_free(src);
+}
+
+void
+case_dict_merge_owned()
+{
+    char key[] = "a key too long to be inlined";
+    size_t key_len = strlen(key), i;
+    dict_t *dst = dict_new();
+    dict_t *src = dict_new();
+
+    assert(dict_own_keys(dst) == DICT_OK && dict_own_keys(src) == DICT_OK);
+    assert(dict_build_parallel(src, key_ptrs, key_lens, vals, KEYS, 4) ==
+            DICT_OK);
+    assert(dict_set(src, (uint8_t *)key, key_len, key) == DICT_OK);
+    assert(dict_merge(dst, src, 4) == DICT_OK);
+
+    // dst copied the keys, neither src nor the caller's keys are needed
+    dict_free(src);
+    memset(key, 'x', key_len);
+    assert(dict_size(dst) == KEYS + 1);
+    assert(dict_get(dst, (uint8_t *)"a key too long to be inlined",
+                key_len) == key);
+    for (i = 0; i < KEYS; i++)
+        assert(dict_get(dst, key_ptrs[i], key_lens[i]) == vals[i]);
+    dict_free(dst);
+}
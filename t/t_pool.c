@@ -0,0 +1,99 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "pool.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_pool_new();
+void case_pool_free();
+void case_pool_clear();
+void case_pool_alloc_dealloc();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("pool_new", &case_pool_new);
+    test_case("pool_free", &case_pool_free);
+    test_case("pool_clear", &case_pool_clear);
+    test_case("pool_alloc_dealloc", &case_pool_alloc_dealloc);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_pool_new()
+{
+    pool_t *pool = pool_new(3);
+    assert(pool != NULL && pool->item_size == 8 && pool->size == 0 &&
+            pool->slabs == NULL);
+    pool_free(pool);
+}
+
+void
+case_pool_free()
+{
+    pool_t *pool = pool_new(24);
+    assert(pool_alloc(pool) != NULL);
+    assert(pool_alloc(pool) != NULL);
+    pool_free(pool);
+}
+
+void
+case_pool_clear()
+{
+    pool_t *pool = pool_new(24);
+    int i;
+
+    for (i = 0; i < 100; i++)
+        assert(pool_alloc(pool) != NULL);
+    assert(pool->size == 100 && pool->cap > 0);
+    pool_clear(pool);
+    assert(pool->size == 0 && pool->cap == 0 && pool->slabs == NULL);
+    assert(pool_alloc(pool) != NULL);
+    pool_free(pool);
+}
+
+void
+case_pool_alloc_dealloc()
+{
+    pool_t *pool = pool_new(sizeof(uint64_t) * 2);
+    uint64_t *items[1000];
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        items[i] = pool_alloc(pool);
+        assert(items[i] != NULL && ((uintptr_t)items[i] & 7) == 0);
+        items[i][0] = i;
+        items[i][1] = i;
+    }
+
+    for (i = 0; i < 1000; i++)
+        assert(items[i][0] == (uint64_t)i && items[i][1] == (uint64_t)i);
+
+    // released items are reused before new slabs are allocated
+    size_t cap = pool->cap;
+    uint64_t *item = items[500];
+    pool_dealloc(pool, item);
+    assert(pool->size == 999);
+    assert(pool_alloc(pool) == item && pool->cap == cap);
+
+    for (i = 0; i < 1000; i++)
+        pool_dealloc(pool, items[i]);
+    assert(pool->size == 0);
+    for (i = 0; i < 1000; i++)
+        assert(pool_alloc(pool) != NULL);
+    assert(pool->cap == cap);
+    pool_free(pool);
+}
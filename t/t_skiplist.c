@@ -0,0 +1,258 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "skiplist.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_skiplist_new();
+void case_skiplist_clear();
+void case_skiplist_set_get_del_has_size();
+void case_skiplist_order();
+void case_skiplist_seek();
+void case_skiplist_rank_at();
+void case_skiplist_random();
+void case_skiplist_use_cmp();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("skiplist_new", &case_skiplist_new);
+    test_case("skiplist_clear", &case_skiplist_clear);
+    test_case("skiplist_set_get_del_has_size",
+            &case_skiplist_set_get_del_has_size);
+    test_case("skiplist_order", &case_skiplist_order);
+    test_case("skiplist_seek", &case_skiplist_seek);
+    test_case("skiplist_rank_at", &case_skiplist_rank_at);
+    test_case("skiplist_random", &case_skiplist_random);
+    test_case("skiplist_use_cmp", &case_skiplist_use_cmp);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+void
+case_skiplist_new()
+{
+    skiplist_t *skiplist = skiplist_new();
+    assert(skiplist != NULL && skiplist_size(skiplist) == 0);
+    assert(skiplist_first(skiplist) == NULL &&
+            skiplist_last(skiplist) == NULL);
+    skiplist_free(skiplist);
+}
+
+void
+case_skiplist_clear()
+{
+    skiplist_t *skiplist = skiplist_new();
+    skiplist_set(skiplist, (uint8_t *)"key1", 4, NULL);
+    skiplist_set(skiplist, (uint8_t *)"key2", 4, NULL);
+    assert(skiplist_size(skiplist) == 2);
+    skiplist_clear(skiplist);
+    assert(skiplist_size(skiplist) == 0);
+    assert(!skiplist_has(skiplist, (uint8_t *)"key1", 4));
+    assert(skiplist_first(skiplist) == NULL);
+    skiplist_free(skiplist);
+}
+
+void
+case_skiplist_set_get_del_has_size()
+{
+    int val1 = 1, val2 = 2;
+    skiplist_t *skiplist = skiplist_new();
+
+    assert(skiplist_set(skiplist, (uint8_t *)"key1", 4, &val1) ==
+            SKIPLIST_OK);
+    assert(skiplist_set(skiplist, (uint8_t *)"key2", 4, &val1) ==
+            SKIPLIST_OK);
+    assert(skiplist_set(skiplist, (uint8_t *)"key2", 4, &val2) ==
+            SKIPLIST_OK);
+    assert(skiplist_size(skiplist) == 2);
+    assert(skiplist_get(skiplist, (uint8_t *)"key1", 4) == &val1);
+    assert(skiplist_get(skiplist, (uint8_t *)"key2", 4) == &val2);
+    assert(skiplist_has(skiplist, (uint8_t *)"key1", 4));
+    assert(!skiplist_has(skiplist, (uint8_t *)"key", 3));
+    assert(skiplist_del(skiplist, (uint8_t *)"key1", 4) == SKIPLIST_OK);
+    assert(skiplist_del(skiplist, (uint8_t *)"key1", 4) ==
+            SKIPLIST_ENOTFOUND);
+    assert(skiplist_get(skiplist, (uint8_t *)"key1", 4) == NULL);
+    assert(skiplist_size(skiplist) == 1);
+    skiplist_free(skiplist);
+}
+
+void
+case_skiplist_order()
+{
+    char *keys[] = {"b", "ab", "a", "", "ba", "aa"};
+    char *sorted[] = {"", "a", "aa", "ab", "b", "ba"};
+    size_t n = sizeof(keys) / sizeof(keys[0]), i;
+    skiplist_t *skiplist = skiplist_new();
+
+    for (i = 0; i < n; i++)
+        skiplist_set(skiplist, (uint8_t *)keys[i], strlen(keys[i]), NULL);
+
+    skiplist_node_t *node = skiplist_first(skiplist);
+    for (i = 0; i < n; i++, node = skiplist_next(node))
+        assert(node->key_len == strlen(sorted[i]) &&
+                memcmp(node->key, sorted[i], node->key_len) == 0);
+    assert(node == NULL);
+
+    node = skiplist_last(skiplist);
+    for (i = n; i > 0; i--, node = skiplist_prev(node))
+        assert(node->key_len == strlen(sorted[i - 1]) &&
+                memcmp(node->key, sorted[i - 1], node->key_len) == 0);
+    assert(node == NULL);
+    skiplist_free(skiplist);
+}
+
+void
+case_skiplist_seek()
+{
+    size_t n = 1000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    skiplist_t *skiplist = skiplist_new();
+
+    // keys 0000, 0002, 0004 ...
+    for (i = 0; i < n; i++) {
+        sprintf(keys[i], "%04zu", i * 2);
+        skiplist_set(skiplist, (uint8_t *)keys[i], 4, keys[i]);
+    }
+
+    // range [0100, 0110)
+    skiplist_node_t *node = skiplist_seek(skiplist, (uint8_t *)"0100", 4);
+    for (i = 50; skiplist_cmp_bytes(node->key, node->key_len,
+                (uint8_t *)"0110", 4) < 0; node = skiplist_next(node))
+        assert(node->val == keys[i++]);
+    assert(i == 55);
+
+    // not in the list, seeks the next one
+    node = skiplist_seek(skiplist, (uint8_t *)"0101", 4);
+    assert(node != NULL && node->val == keys[51]);
+    assert(skiplist_prev(node)->val == keys[50]);
+    assert(skiplist_seek(skiplist, (uint8_t *)"", 0)->val == keys[0]);
+    assert(skiplist_seek(skiplist, (uint8_t *)"9999", 4) == NULL);
+
+    skiplist_free(skiplist);
+    free(keys);
+}
+
+void
+case_skiplist_rank_at()
+{
+    size_t n = 1000, i;
+    char (*keys)[16] = malloc(n * 16);
+    assert(keys != NULL);
+    skiplist_t *skiplist = skiplist_new();
+
+    for (i = n; i > 0; i--) {
+        sprintf(keys[i - 1], "%04zu", i - 1);
+        skiplist_set(skiplist, (uint8_t *)keys[i - 1], 4, keys[i - 1]);
+    }
+
+    for (i = 0; i < n; i++) {
+        assert(skiplist_rank(skiplist, (uint8_t *)keys[i], 4) == i);
+        assert(skiplist_at(skiplist, i)->val == keys[i]);
+    }
+    assert(skiplist_at(skiplist, n) == NULL);
+    assert(skiplist_rank(skiplist, (uint8_t *)"9999", 4) == n);
+
+    // ranks follow deletes
+    for (i = 0; i < n; i += 2)
+        assert(skiplist_del(skiplist, (uint8_t *)keys[i], 4) ==
+                SKIPLIST_OK);
+    for (i = 1; i < n; i += 2) {
+        assert(skiplist_rank(skiplist, (uint8_t *)keys[i], 4) == i / 2);
+        assert(skiplist_at(skiplist, i / 2)->val == keys[i]);
+    }
+
+    skiplist_free(skiplist);
+    free(keys);
+}
+
+/**
+ * Check a skiplist against a bitmap of keys set (key i is "%05zu").
+ */
+static void
+check_skiplist(skiplist_t *skiplist, char (*keys)[16], bool *in, size_t n)
+{
+    skiplist_node_t *node = skiplist_first(skiplist), *prev = NULL;
+    size_t i, rank = 0;
+
+    for (i = 0; i < n; i++) {
+        if (!in[i])
+            continue;
+        assert(node != NULL && node->val == keys[i]);
+        assert(skiplist_prev(node) == prev);
+        assert(skiplist_rank(skiplist, (uint8_t *)keys[i], 5) == rank);
+        assert(skiplist_at(skiplist, rank) == node);
+        prev = node;
+        node = skiplist_next(node);
+        rank++;
+    }
+    assert(node == NULL && skiplist_last(skiplist) == prev);
+    assert(skiplist_size(skiplist) == rank);
+}
+
+void
+case_skiplist_random()
+{
+    size_t n = 2000, round, i;
+    char (*keys)[16] = malloc(n * 16);
+    bool *in = calloc(n, sizeof(bool));
+    assert(keys != NULL && in != NULL);
+    skiplist_t *skiplist = skiplist_new();
+
+    for (i = 0; i < n; i++)
+        sprintf(keys[i], "%05zu", i);
+
+    srand(1);
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < n; i++) {
+            size_t k = (size_t)rand() % n;
+
+            if (in[k])
+                assert(skiplist_del(skiplist, (uint8_t *)keys[k], 5) ==
+                        SKIPLIST_OK);
+            else
+                assert(skiplist_set(skiplist, (uint8_t *)keys[k], 5,
+                            keys[k]) == SKIPLIST_OK);
+            in[k] = !in[k];
+        }
+        check_skiplist(skiplist, keys, in, n);
+    }
+
+    skiplist_free(skiplist);
+    free(keys);
+    free(in);
+}
+
+static int
+cmp_reversed(uint8_t *a, size_t a_len, uint8_t *b, size_t b_len)
+{
+    return skiplist_cmp_bytes(b, b_len, a, a_len);
+}
+
+void
+case_skiplist_use_cmp()
+{
+    skiplist_t *skiplist = skiplist_new();
+    skiplist_use_cmp(skiplist, &cmp_reversed);
+    skiplist_set(skiplist, (uint8_t *)"a", 1, NULL);
+    skiplist_set(skiplist, (uint8_t *)"c", 1, NULL);
+    skiplist_set(skiplist, (uint8_t *)"b", 1, NULL);
+    assert(skiplist_first(skiplist)->key[0] == 'c');
+    assert(skiplist_last(skiplist)->key[0] == 'a');
+    assert(skiplist_seek(skiplist, (uint8_t *)"bb", 2)->key[0] == 'b');
+    skiplist_free(skiplist);
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "topk.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_topk_new();
+void case_topk_clear();
+void case_topk_add();
+void case_topk_heavy_hitters();
+void case_topk_dump_load();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("topk_new", &case_topk_new);
+    test_case("topk_clear", &case_topk_clear);
+    test_case("topk_add", &case_topk_add);
+    test_case("topk_heavy_hitters", &case_topk_heavy_hitters);
+    test_case("topk_dump_load", &case_topk_dump_load);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+static void
+collect(uint8_t *key, size_t key_len, uint64_t count, void *data)
+{
+    char *out = data;
+    sprintf(out + strlen(out), "%.*s=%llu,", (int)key_len, (char *)key,
+            (unsigned long long)count);
+}
+
+void
+case_topk_new()
+{
+    topk_t *topk = topk_new(10, 0, 0);
+    assert(topk != NULL && topk->k == 10 && topk_size(topk) == 0);
+    topk_free(topk);
+}
+
+void
+case_topk_clear()
+{
+    topk_t *topk = topk_new(2, 0, 0);
+    topk_add(topk, (uint8_t *)"a", 1, 1);
+    topk_add(topk, (uint8_t *)"b", 1, 1);
+    topk_add(topk, (uint8_t *)"c", 1, 5);
+    assert(topk_size(topk) == 2);
+    topk_clear(topk);
+    assert(topk_size(topk) == 0 && !topk_has(topk, (uint8_t *)"c", 1));
+    assert(topk_count(topk, (uint8_t *)"c", 1) == 0);
+    topk_free(topk);
+}
+
+void
+case_topk_add()
+{
+    char out[128] = "";
+    topk_t *topk = topk_new(2, 0, 0);
+
+    assert(topk_add(topk, (uint8_t *)"a", 1, 1) == TOPK_OK);
+    assert(topk_add(topk, (uint8_t *)"b", 1, 2) == TOPK_OK);
+    // not over the smallest
+    assert(topk_add(topk, (uint8_t *)"c", 1, 1) == TOPK_OK);
+    assert(!topk_has(topk, (uint8_t *)"c", 1));
+    // over it, replaces a
+    assert(topk_add(topk, (uint8_t *)"c", 1, 1) == TOPK_OK);
+    assert(topk_has(topk, (uint8_t *)"c", 1));
+    assert(!topk_has(topk, (uint8_t *)"a", 1));
+    assert(topk_count(topk, (uint8_t *)"a", 1) == 1);
+
+    assert(topk_add(topk, (uint8_t *)"b", 1, 5) == TOPK_OK);
+    assert(topk_list(topk, &collect, out) == 2);
+    assert(strcmp(out, "b=7,c=2,") == 0);
+    topk_free(topk);
+}
+
+void
+case_topk_heavy_hitters()
+{
+    size_t n = 20000, round, i;
+    char key[32], out[1024] = "";
+    topk_t *topk = topk_new(5, 0, 0);
+
+    // key i of the first 5 is added 1000 - i times, noise keys once
+    for (round = 0; round < 1000; round++) {
+        for (i = 0; i < 5; i++) {
+            if (round < 1000 - i * 100) {
+                sprintf(key, "hot%zu", i);
+                topk_add(topk, (uint8_t *)key, strlen(key), 1);
+            }
+        }
+        for (i = 0; i < n / 1000; i++) {
+            sprintf(key, "noise%zu", round * (n / 1000) + i);
+            topk_add(topk, (uint8_t *)key, strlen(key), 1);
+        }
+    }
+
+    assert(topk_list(topk, &collect, out) == 5);
+    assert(strncmp(out, "hot0=", 5) == 0);
+    for (i = 0; i < 5; i++) {
+        sprintf(key, "hot%zu", i);
+        assert(topk_has(topk, (uint8_t *)key, strlen(key)));
+        assert(topk_count(topk, (uint8_t *)key, strlen(key)) >=
+                1000 - i * 100);
+    }
+    topk_free(topk);
+}
+
+void
+case_topk_dump_load()
+{
+    char out[128] = "", copy_out[128] = "";
+    buf_t *buf = buf_new(1024);
+    topk_t *topk = topk_new(3, 256, 2), *copy;
+
+    topk_add(topk, (uint8_t *)"a", 1, 3);
+    topk_add(topk, (uint8_t *)"bb", 2, 2);
+    topk_add(topk, (uint8_t *)"ccc", 3, 1);
+    topk_add(topk, (uint8_t *)"dddd", 4, 4);
+    assert(topk_dump(topk, buf) == TOPK_OK);
+
+    copy = topk_load(buf->data, buf->size);
+    assert(copy != NULL && topk_size(copy) == 3);
+    topk_list(topk, &collect, out);
+    topk_list(copy, &collect, copy_out);
+    assert(strcmp(out, "dddd=4,a=3,bb=2,") == 0);
+    assert(strcmp(out, copy_out) == 0);
+
+    // keeps counting
+    topk_add(copy, (uint8_t *)"ccc", 3, 5);
+    assert(topk_has(copy, (uint8_t *)"ccc", 3));
+    assert(topk_count(copy, (uint8_t *)"ccc", 3) == 6);
+    topk_free(copy);
+
+    assert(topk_load(buf->data, buf->size - 1) == NULL);
+    assert(topk_load(buf->data, 20) == NULL);
+
+    // a heap size that overflows, or more entries than the dump holds
+    topk_header_t header;
+    memcpy(&header, buf->data, sizeof(header));
+    header.k = ((uint64_t)1 << 61) + 1;
+    header.size = header.k;
+    memcpy(buf->data, &header, sizeof(header));
+    assert(topk_load(buf->data, buf->size) == NULL);
+    header.size = 3;
+    memcpy(buf->data, &header, sizeof(header));
+    assert(topk_load(buf->data, buf->size) == NULL);
+    header.k = 3;
+    header.size = buf->size;
+    memcpy(buf->data, &header, sizeof(header));
+    assert(topk_load(buf->data, buf->size) == NULL);
+
+    topk_free(topk);
+    buf_free(buf);
+}
@@ -0,0 +1,332 @@
+#include <math.h>
+#include <stdio.h>
+#ifdef __linux
+#include <mcheck.h>
+#endif
+#include "zset.h"
+
+typedef void (*case_t)();
+
+static void test_case(const char *, case_t);
+
+void case_zset_new();
+void case_zset_clear();
+void case_zset_add_score_del_has_size();
+void case_zset_update();
+void case_zset_update_enomem();
+void case_zset_incr();
+void case_zset_rank();
+void case_zset_count();
+void case_zset_range_by_score();
+void case_zset_range_by_rank();
+void case_zset_random();
+
+int main(int argc, const char *argv[])
+{
+#ifdef __linux
+    mtrace();
+#endif
+    test_case("zset_new", &case_zset_new);
+    test_case("zset_clear", &case_zset_clear);
+    test_case("zset_add_score_del_has_size",
+            &case_zset_add_score_del_has_size);
+    test_case("zset_update", &case_zset_update);
+#ifdef __linux
+    test_case("zset_update_enomem", &case_zset_update_enomem);
+#endif
+    test_case("zset_incr", &case_zset_incr);
+    test_case("zset_rank", &case_zset_rank);
+    test_case("zset_count", &case_zset_count);
+    test_case("zset_range_by_score", &case_zset_range_by_score);
+    test_case("zset_range_by_rank", &case_zset_range_by_rank);
+    test_case("zset_random", &case_zset_random);
+    return 0;
+}
+
+static void
+test_case(const char *name, case_t case_func)
+{
+    case_func();
+    printf("OK CASE(%s)\n", name);
+}
+
+#ifdef __linux
+// built with -Wl,--wrap=malloc, see Makefile
+void *__real_malloc(size_t);
+static bool malloc_fails = false;
+
+void *
+__wrap_malloc(size_t size)
+{
+    return malloc_fails ? NULL : __real_malloc(size);
+}
+#endif
+
+static void
+collect(uint8_t *member, size_t member_len, double score, void *data)
+{
+    char *out = data;
+    strncat(out, (char *)member, member_len);
+    strcat(out, ",");
+}
+
+/**
+ * Leaderboard: a=10, b=20, c=20, d=30, e=40.
+ */
+static zset_t *
+leaderboard()
+{
+    zset_t *zset = zset_new();
+    assert(zset_add(zset, (uint8_t *)"d", 1, 30) == ZSET_OK);
+    assert(zset_add(zset, (uint8_t *)"c", 1, 20) == ZSET_OK);
+    assert(zset_add(zset, (uint8_t *)"a", 1, 10) == ZSET_OK);
+    assert(zset_add(zset, (uint8_t *)"e", 1, 40) == ZSET_OK);
+    assert(zset_add(zset, (uint8_t *)"b", 1, 20) == ZSET_OK);
+    return zset;
+}
+
+void
+case_zset_new()
+{
+    zset_t *zset = zset_new();
+    assert(zset != NULL && zset_size(zset) == 0);
+    zset_free(zset);
+}
+
+void
+case_zset_clear()
+{
+    zset_t *zset = leaderboard();
+    assert(zset_size(zset) == 5);
+    zset_clear(zset);
+    assert(zset_size(zset) == 0);
+    assert(!zset_has(zset, (uint8_t *)"a", 1));
+    assert(zset_count(zset, -INFINITY, INFINITY) == 0);
+    zset_free(zset);
+}
+
+void
+case_zset_add_score_del_has_size()
+{
+    double score;
+    zset_t *zset = leaderboard();
+
+    assert(zset_score(zset, (uint8_t *)"a", 1, &score) == ZSET_OK &&
+            score == 10);
+    assert(zset_score(zset, (uint8_t *)"x", 1, &score) == ZSET_ENOTFOUND);
+    assert(zset_has(zset, (uint8_t *)"b", 1));
+    assert(zset_del(zset, (uint8_t *)"b", 1) == ZSET_OK);
+    assert(zset_del(zset, (uint8_t *)"b", 1) == ZSET_ENOTFOUND);
+    assert(!zset_has(zset, (uint8_t *)"b", 1));
+    assert(zset_size(zset) == 4);
+    zset_free(zset);
+}
+
+void
+case_zset_update()
+{
+    char out[64] = "";
+    double score;
+    zset_t *zset = leaderboard();
+
+    // in place, the order holds
+    assert(zset_add(zset, (uint8_t *)"d", 1, 35) == ZSET_OK);
+    // moved
+    assert(zset_add(zset, (uint8_t *)"a", 1, 50) == ZSET_OK);
+    assert(zset_add(zset, (uint8_t *)"e", 1, 0) == ZSET_OK);
+    assert(zset_size(zset) == 5);
+    assert(zset_score(zset, (uint8_t *)"d", 1, &score) == ZSET_OK &&
+            score == 35);
+
+    zset_range_by_rank(zset, 0, 10, &collect, out);
+    assert(strcmp(out, "e,b,c,d,a,") == 0);
+    zset_free(zset);
+}
+
+#ifdef __linux
+void
+case_zset_update_enomem()
+{
+    char out[64] = "";
+    double score;
+    zset_t *zset = leaderboard();
+
+    malloc_fails = true;
+    assert(zset_add(zset, (uint8_t *)"a", 1, 50) == ZSET_ENOMEM);
+    assert(zset_incr(zset, (uint8_t *)"e", 1, -40, &score) == ZSET_ENOMEM);
+    // in place needs no memory
+    assert(zset_add(zset, (uint8_t *)"d", 1, 35) == ZSET_OK);
+    malloc_fails = false;
+
+    assert(zset_size(zset) == 5);
+    assert(zset_score(zset, (uint8_t *)"a", 1, &score) == ZSET_OK &&
+            score == 10);
+    assert(zset_score(zset, (uint8_t *)"e", 1, &score) == ZSET_OK &&
+            score == 40);
+    zset_range_by_rank(zset, 0, 10, &collect, out);
+    assert(strcmp(out, "a,b,c,d,e,") == 0);
+
+    assert(zset_add(zset, (uint8_t *)"a", 1, 50) == ZSET_OK);
+    out[0] = 0;
+    zset_range_by_rank(zset, 0, 10, &collect, out);
+    assert(strcmp(out, "b,c,d,e,a,") == 0);
+    zset_free(zset);
+}
+#endif
+
+void
+case_zset_incr()
+{
+    double score;
+    zset_t *zset = leaderboard();
+
+    assert(zset_incr(zset, (uint8_t *)"a", 1, 25, &score) == ZSET_OK &&
+            score == 35);
+    assert(zset_incr(zset, (uint8_t *)"x", 1, 5, &score) == ZSET_OK &&
+            score == 5);
+    assert(zset_incr(zset, (uint8_t *)"x", 1, -1, NULL) == ZSET_OK);
+    assert(zset_score(zset, (uint8_t *)"x", 1, &score) == ZSET_OK &&
+            score == 4);
+
+    size_t rank;
+    assert(zset_rank(zset, (uint8_t *)"a", 1, &rank) == ZSET_OK &&
+            rank == 4);
+
+    // NaN scores are refused, the member keeps its score
+    assert(zset_incr(zset, (uint8_t *)"x", 1, INFINITY, NULL) == ZSET_OK);
+    assert(zset_incr(zset, (uint8_t *)"x", 1, -INFINITY, &score) ==
+            ZSET_ENAN);
+    assert(zset_score(zset, (uint8_t *)"x", 1, &score) == ZSET_OK &&
+            score == INFINITY);
+    assert(zset_incr(zset, (uint8_t *)"y", 1, NAN, NULL) == ZSET_ENAN);
+    assert(!zset_has(zset, (uint8_t *)"y", 1) && zset_size(zset) == 6);
+    zset_free(zset);
+}
+
+void
+case_zset_rank()
+{
+    char *members[] = {"a", "b", "c", "d", "e"};
+    size_t i, rank;
+    zset_t *zset = leaderboard();
+
+    // ties are ordered by member
+    for (i = 0; i < 5; i++)
+        assert(zset_rank(zset, (uint8_t *)members[i], 1, &rank) ==
+                ZSET_OK && rank == i);
+    assert(zset_rank(zset, (uint8_t *)"x", 1, &rank) == ZSET_ENOTFOUND);
+    zset_free(zset);
+}
+
+void
+case_zset_count()
+{
+    zset_t *zset = leaderboard();
+    assert(zset_count(zset, 20, 20) == 2);
+    assert(zset_count(zset, 15, 30) == 3);
+    assert(zset_count(zset, 10, 40) == 5);
+    assert(zset_count(zset, -INFINITY, INFINITY) == 5);
+    assert(zset_count(zset, 41, 50) == 0);
+    assert(zset_count(zset, 30, 20) == 0);
+
+    // infinite scores are counted
+    zset_add(zset, (uint8_t *)"x", 1, INFINITY);
+    zset_add(zset, (uint8_t *)"y", 1, -INFINITY);
+    assert(zset_count(zset, -INFINITY, INFINITY) == 7);
+    assert(zset_count(zset, INFINITY, INFINITY) == 1);
+    assert(zset_count(zset, -INFINITY, -INFINITY) == 1);
+    assert(zset_count(zset, 40, INFINITY) == 2);
+    zset_free(zset);
+}
+
+void
+case_zset_range_by_score()
+{
+    char out[64] = "";
+    zset_t *zset = leaderboard();
+
+    assert(zset_range_by_score(zset, 20, 30, &collect, out) == 3);
+    assert(strcmp(out, "b,c,d,") == 0);
+    out[0] = 0;
+    assert(zset_range_by_score(zset, 11, 19, &collect, out) == 0);
+    assert(zset_range_by_score(zset, -INFINITY, 10, &collect, out) == 1);
+    assert(strcmp(out, "a,") == 0);
+    zset_free(zset);
+}
+
+void
+case_zset_range_by_rank()
+{
+    char out[64] = "";
+    zset_t *zset = leaderboard();
+
+    assert(zset_range_by_rank(zset, 1, 3, &collect, out) == 3);
+    assert(strcmp(out, "b,c,d,") == 0);
+    out[0] = 0;
+    assert(zset_range_by_rank(zset, 3, 10, &collect, out) == 2);
+    assert(strcmp(out, "d,e,") == 0);
+    assert(zset_range_by_rank(zset, 5, 10, &collect, out) == 0);
+
+    // top 3
+    out[0] = 0;
+    assert(zset_rev_range_by_rank(zset, 0, 3, &collect, out) == 3);
+    assert(strcmp(out, "e,d,c,") == 0);
+    out[0] = 0;
+    assert(zset_rev_range_by_rank(zset, 4, 3, &collect, out) == 1);
+    assert(strcmp(out, "a,") == 0);
+    assert(zset_rev_range_by_rank(zset, 5, 3, &collect, out) == 0);
+    zset_free(zset);
+}
+
+static void
+check_ascending(uint8_t *member, size_t member_len, double score,
+        void *data)
+{
+    double *last = data;
+    assert(score >= *last);
+    *last = score;
+}
+
+void
+case_zset_random()
+{
+    size_t n = 2000, i, rank;
+    char (*members)[16] = malloc(n * 16);
+    double *scores = malloc(n * sizeof(double));
+    assert(members != NULL && scores != NULL);
+    zset_t *zset = zset_new();
+
+    srand(1);
+    for (i = 0; i < n; i++) {
+        sprintf(members[i], "player%zu", i);
+        scores[i] = rand() % 100;
+        assert(zset_add(zset, (uint8_t *)members[i], strlen(members[i]),
+                    scores[i]) == ZSET_OK);
+    }
+
+    for (i = 0; i < n * 5; i++) {
+        size_t k = (size_t)rand() % n;
+        scores[k] += rand() % 21 - 10;
+        assert(zset_add(zset, (uint8_t *)members[k], strlen(members[k]),
+                    scores[k]) == ZSET_OK);
+    }
+    assert(zset_size(zset) == n);
+
+    // rank = members with lower score + ties ordered before
+    for (i = 0; i < n; i += 37) {
+        size_t lower = 0, j;
+        for (j = 0; j < n; j++)
+            if (scores[j] < scores[i] || (scores[j] == scores[i] &&
+                        strcmp(members[j], members[i]) < 0))
+                lower++;
+        assert(zset_rank(zset, (uint8_t *)members[i], strlen(members[i]),
+                    &rank) == ZSET_OK && rank == lower);
+    }
+
+    double last = -INFINITY;
+    assert(zset_range_by_rank(zset, 0, n, &check_ascending, &last) == n);
+
+    zset_free(zset);
+    free(members);
+    free(scores);
+}